@@ -0,0 +1,266 @@
+/*
+ * Multi-scalar multiplication tuning sweep.
+ *
+ *   cc -O2 -Isrc -Isrc/secp256k1 \
+ *     -DHSK_USE_FIELD_5X52 -DHSK_USE_SCALAR_4X64 -DHAVE___INT128 \
+ *     -DHSK_USE_ENDOMORPHISM -DHSK_USE_ECMULT_STATIC_PRECOMPUTATION \
+ *     -o bench/ecmult bench/ecmult.c
+ *   ./bench/ecmult [max-points] [budget-points] > ecmult.tune
+ *
+ * For each batch size, times Strauss and every Pippenger
+ * bucket window through hsk_secp256k1_ecmult_multi_var,
+ * printing the sweep to stderr. The derived tuning is
+ * printed to stdout as a single line:
+ *
+ *   <threshold> <window 1 max> ... <window 11 max>
+ *
+ * which bch_verify_tune() applies to a context.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "secp256k1/secp256k1.c"
+
+#define BENCH_WINDOWS PIPPENGER_MAX_BUCKET_WINDOW
+#define BENCH_SIZES 64
+
+typedef struct bench_data_s {
+  hsk_secp256k1_scalar *scalars;
+  hsk_secp256k1_ge *points;
+} bench_data_t;
+
+static uint64_t
+bench_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static uint64_t bench_state = 0x9e3779b97f4a7c15ull;
+
+static uint64_t
+bench_rand(void) {
+  bench_state ^= bench_state << 13;
+  bench_state ^= bench_state >> 7;
+  bench_state ^= bench_state << 17;
+  return bench_state;
+}
+
+static void
+bench_scalar(hsk_secp256k1_scalar *sc) {
+  uint8_t raw[32];
+  int i;
+
+  for (i = 0; i < 32; i += 8) {
+    uint64_t x = bench_rand();
+    memcpy(&raw[i], &x, 8);
+  }
+
+  hsk_secp256k1_scalar_set_b32(sc, raw, NULL);
+}
+
+static int
+bench_cb(
+  hsk_secp256k1_scalar *sc,
+  hsk_secp256k1_ge *pt,
+  size_t idx,
+  void *arg
+) {
+  bench_data_t *data = (bench_data_t *)arg;
+
+  *sc = data->scalars[idx];
+  *pt = data->points[idx];
+
+  return 1;
+}
+
+// Force a strategy: window 0 is Strauss, otherwise
+// Pippenger with the given bucket window.
+static void
+bench_force(hsk_secp256k1_context *ctx, int window) {
+  hsk_secp256k1_ecmult_context *ectx = &ctx->ecmult_ctx;
+  int i;
+
+  ectx->pippenger_threshold = window ? 0 : SIZE_MAX;
+
+  for (i = 0; i < BENCH_WINDOWS; i++)
+    ectx->pippenger_window_max[i] = i + 1 < window ? 0 : SIZE_MAX;
+}
+
+static double
+bench_run(
+  hsk_secp256k1_context *ctx,
+  hsk_secp256k1_scratch *scratch,
+  bench_data_t *data,
+  size_t n,
+  size_t budget
+) {
+  hsk_secp256k1_scalar g_sc;
+  hsk_secp256k1_gej r;
+  size_t iters = budget / n;
+  uint64_t start;
+  size_t i;
+
+  if (iters == 0)
+    iters = 1;
+
+  bench_scalar(&g_sc);
+
+  start = bench_now();
+
+  for (i = 0; i < iters; i++) {
+    if (!hsk_secp256k1_ecmult_multi_var(&ctx->ecmult_ctx, scratch, &r,
+                                        &g_sc, bench_cb, data, n)) {
+      fprintf(stderr, "ecmult_multi_var failed (n=%zu)\n", n);
+      exit(1);
+    }
+  }
+
+  return (double)(bench_now() - start) / (double)(iters * n);
+}
+
+int
+main(int argc, char **argv) {
+  size_t sizes[BENCH_SIZES];
+  bool pippenger[BENCH_SIZES];
+  int best[BENCH_SIZES];
+  size_t window_max[BENCH_WINDOWS];
+  size_t max_points = 4096;
+  size_t budget = 4096;
+  size_t threshold;
+  size_t count = 0;
+  size_t n, i;
+  int w;
+
+  if (argc > 1)
+    max_points = strtoull(argv[1], NULL, 10);
+
+  if (argc > 2)
+    budget = strtoull(argv[2], NULL, 10);
+
+  if (max_points < 2)
+    max_points = 2;
+
+  // Roughly geometric sizes.
+  for (n = 1; n <= max_points && count < BENCH_SIZES; n += (n + 3) / 4)
+    sizes[count++] = n;
+
+  hsk_secp256k1_context *ctx = hsk_secp256k1_context_create(
+    HSK_SECP256K1_CONTEXT_SIGN | HSK_SECP256K1_CONTEXT_VERIFY);
+
+  hsk_secp256k1_scratch *scratch = hsk_secp256k1_scratch_create(
+    &ctx->error_callback, 1 << 20,
+    hsk_secp256k1_strauss_scratch_size(max_points) + (1 << 20));
+
+  bench_data_t data;
+  data.scalars = malloc(max_points * sizeof(hsk_secp256k1_scalar));
+  data.points = malloc(max_points * sizeof(hsk_secp256k1_ge));
+
+  if (!ctx || !scratch || !data.scalars || !data.points)
+    return 1;
+
+  for (i = 0; i < max_points; i++) {
+    hsk_secp256k1_scalar k;
+    hsk_secp256k1_gej pj;
+
+    bench_scalar(&k);
+    hsk_secp256k1_ecmult_gen(&ctx->ecmult_gen_ctx, &pj, &k);
+    hsk_secp256k1_ge_set_gej_var(&data.points[i], &pj);
+    bench_scalar(&data.scalars[i]);
+  }
+
+  fprintf(stderr, "%8s %9s", "points", "strauss");
+  for (w = 1; w <= BENCH_WINDOWS; w++)
+    fprintf(stderr, "  pip-%-4d", w);
+  fprintf(stderr, "   (ns/point)\n");
+
+  for (i = 0; i < count; i++) {
+    double strauss;
+    double min = 0.0;
+
+    n = sizes[i];
+
+    bench_force(ctx, 0);
+    strauss = bench_run(ctx, scratch, &data, n, budget);
+    best[i] = 1;
+
+    fprintf(stderr, "%8zu %9.0f", n, strauss);
+
+    for (w = 1; w <= BENCH_WINDOWS; w++) {
+      double ns;
+
+      // More buckets than points never pays off.
+      if ((size_t)1 << w > 8 * n + 8) {
+        fprintf(stderr, "  %8s", "-");
+        continue;
+      }
+
+      bench_force(ctx, w);
+      ns = bench_run(ctx, scratch, &data, n, budget);
+
+      if (min == 0.0 || ns < min) {
+        min = ns;
+        best[i] = w;
+      }
+
+      fprintf(stderr, "  %8.0f", ns);
+    }
+
+    fprintf(stderr, "\n");
+
+    pippenger[i] = min < strauss;
+  }
+
+  // Pippenger from the smallest size after which it
+  // always wins.
+  threshold = SIZE_MAX;
+
+  for (i = count; i > 0; i--) {
+    if (!pippenger[i - 1])
+      break;
+    threshold = sizes[i - 1];
+  }
+
+  // The window may only grow with the point count.
+  for (i = 1; i < count; i++) {
+    if (best[i] < best[i - 1])
+      best[i] = best[i - 1];
+  }
+
+  // Beyond the sweep, stay with the last best window.
+  for (w = 1; w <= BENCH_WINDOWS; w++) {
+    size_t max = w > 1 ? window_max[w - 2] : 0;
+
+    if (w >= best[count - 1]) {
+      window_max[w - 1] = SIZE_MAX;
+      continue;
+    }
+
+    for (i = 0; i < count; i++) {
+      if (best[i] <= w && sizes[i] > max)
+        max = sizes[i];
+    }
+
+    window_max[w - 1] = max;
+  }
+
+  if (threshold == SIZE_MAX)
+    threshold = max_points + 1;
+
+  printf("%zu", threshold);
+  for (w = 1; w < BENCH_WINDOWS; w++)
+    printf(" %zu", window_max[w - 1]);
+  printf("\n");
+
+  free(data.scalars);
+  free(data.points);
+  hsk_secp256k1_scratch_destroy(scratch);
+  hsk_secp256k1_context_destroy(ctx);
+
+  return 0;
+}
@@ -422,7 +422,7 @@ write_bytes(uint8_t **data, const uint8_t *bytes, size_t size) {
 
 static inline bool
 read_varint(uint8_t **data, size_t *data_len, uint64_t *value) {
-  if (data_len == 0)
+  if (*data_len == 0)
     return false;
 
   uint8_t prefix = (*data)[0];
@@ -491,7 +491,7 @@ read_varsize(uint8_t **data, size_t *data_len, size_t *value) {
   return true;
 }
 
-static inline bool
+static inline size_t
 size_varint(uint64_t value) {
   if (value < 0xfd)
     return 1;
@@ -621,6 +621,124 @@ write_varbytes(uint8_t **data, const uint8_t *bytes, size_t size) {
   return s;
 }
 
+/*
+ * Bulk readers. One bounds check per call.
+ */
+
+static inline bool
+slice_hash_array(uint8_t **data, size_t *len, uint8_t **out, size_t count) {
+  if (count > *len / 32)
+    return false;
+  *out = *data;
+  *data += count * 32;
+  *len -= count * 32;
+  return true;
+}
+
+static inline bool
+read_hash_array(
+  uint8_t **data,
+  size_t *len,
+  uint8_t (*out)[32],
+  size_t count
+) {
+  if (count > *len / 32)
+    return false;
+  memcpy(out, *data, count * 32);
+  *data += count * 32;
+  *len -= count * 32;
+  return true;
+}
+
+static inline bool
+read_u32_array(uint8_t **data, size_t *len, uint32_t *out, size_t count) {
+  if (count > *len / 4)
+    return false;
+#ifndef BCH_BIG_ENDIAN
+  memcpy(out, *data, count * 4);
+#else
+  size_t i;
+  for (i = 0; i < count; i++) {
+    const uint8_t *p = &(*data)[i * 4];
+    out[i] = ((uint32_t)p[3] << 24)
+           | ((uint32_t)p[2] << 16)
+           | ((uint32_t)p[1] << 8)
+           | (uint32_t)p[0];
+  }
+#endif
+  *data += count * 4;
+  *len -= count * 4;
+  return true;
+}
+
+static inline bool
+read_u64_array(uint8_t **data, size_t *len, uint64_t *out, size_t count) {
+  if (count > *len / 8)
+    return false;
+#ifndef BCH_BIG_ENDIAN
+  memcpy(out, *data, count * 8);
+#else
+  size_t i;
+  for (i = 0; i < count; i++) {
+    const uint8_t *p = &(*data)[i * 8];
+    out[i] = ((uint64_t)p[7] << 56)
+           | ((uint64_t)p[6] << 48)
+           | ((uint64_t)p[5] << 40)
+           | ((uint64_t)p[4] << 32)
+           | ((uint64_t)p[3] << 24)
+           | ((uint64_t)p[2] << 16)
+           | ((uint64_t)p[1] << 8)
+           | (uint64_t)p[0];
+  }
+#endif
+  *data += count * 8;
+  *len -= count * 8;
+  return true;
+}
+
+static inline bool
+read_varint_array(
+  uint8_t **data,
+  size_t *data_len,
+  uint64_t *out,
+  size_t count
+) {
+  size_t i = 0;
+
+  while (i < count) {
+    // Runs of single byte varints are widened eight at a
+    // time. A byte is a prefix (0xfd-0xff) iff its
+    // complement is below 3, which is tested for all
+    // eight bytes at once.
+    if (count - i >= 8 && *data_len >= 8) {
+      uint64_t x;
+      memcpy(&x, *data, 8);
+      x = ~x;
+
+      if (((x - 0x0303030303030303ull) & ~x & 0x8080808080808080ull) == 0) {
+        const uint8_t *p = *data;
+        size_t j;
+
+        for (j = 0; j < 8; j++)
+          out[i + j] = (uint64_t)p[j];
+
+        *data += 8;
+        *data_len -= 8;
+        i += 8;
+
+        continue;
+      }
+    }
+
+    if (!read_varint(data, data_len, &out[i]))
+      return false;
+
+    i += 1;
+  }
+
+  return true;
+}
+
 static inline uint8_t
 get_u8(const uint8_t *data) {
   return data[0];
@@ -0,0 +1,342 @@
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bio.h"
+#include "bloom.h"
+#include "buf.h"
+#include "map.h"
+
+#define BCH_BLOOM_LN2SQ 0.4804530139182014246671025263266649717
+#define BCH_BLOOM_LN2 0.6931471805599453094172321214581765680
+
+void
+bch_bloom_init(bch_bloom_t *bloom) {
+  assert(bloom && "bloom is null");
+
+  bloom->data = NULL;
+  bloom->size = 0;
+  bloom->n = 0;
+  bloom->tweak = 0;
+  bloom->update = BCH_BLOOM_UPDATE_NONE;
+}
+
+void
+bch_bloom_uninit(bch_bloom_t *bloom) {
+  if (!bloom)
+    return;
+
+  if (bloom->data) {
+    free(bloom->data);
+    bloom->data = NULL;
+  }
+
+  bloom->size = 0;
+  bloom->n = 0;
+}
+
+bch_bloom_t *
+bch_bloom_alloc(void) {
+  bch_bloom_t *bloom = malloc(sizeof(bch_bloom_t));
+
+  if (!bloom)
+    return NULL;
+
+  bch_bloom_init(bloom);
+
+  return bloom;
+}
+
+void
+bch_bloom_free(bch_bloom_t *bloom) {
+  if (!bloom)
+    return;
+
+  bch_bloom_uninit(bloom);
+  free(bloom);
+}
+
+// Size the filter for `items` elements at false
+// positive `rate`, clamped to the BIP37 limits.
+bool
+bch_bloom_reset(
+  bch_bloom_t *bloom,
+  uint32_t items,
+  double rate,
+  uint32_t tweak,
+  uint8_t update
+) {
+  assert(bloom && "bloom is null");
+
+  double bits;
+  double funcs;
+  size_t size;
+  uint32_t n;
+
+  if (items == 0)
+    items = 1;
+
+  if (!(rate > 0.0 && rate < 1.0))
+    return false;
+
+  bits = -1.0 / BCH_BLOOM_LN2SQ * (double)items * log(rate);
+
+  if (bits > BCH_BLOOM_MAX_SIZE * 8)
+    bits = BCH_BLOOM_MAX_SIZE * 8;
+
+  size = (size_t)bits / 8;
+
+  if (size == 0)
+    size = 1;
+
+  funcs = (double)(size * 8) / (double)items * BCH_BLOOM_LN2;
+
+  if (funcs > BCH_BLOOM_MAX_FUNCS)
+    funcs = BCH_BLOOM_MAX_FUNCS;
+
+  n = (uint32_t)funcs;
+
+  if (n == 0)
+    n = 1;
+
+  return bch_bloom_set(bloom, size, n, tweak, update);
+}
+
+bool
+bch_bloom_set(
+  bch_bloom_t *bloom,
+  size_t size,
+  uint32_t n,
+  uint32_t tweak,
+  uint8_t update
+) {
+  assert(bloom && "bloom is null");
+
+  uint8_t *data;
+
+  if (size == 0 || size > BCH_BLOOM_MAX_SIZE)
+    return false;
+
+  if (n == 0 || n > BCH_BLOOM_MAX_FUNCS)
+    return false;
+
+  data = calloc(size, 1);
+
+  if (!data)
+    return false;
+
+  if (bloom->data)
+    free(bloom->data);
+
+  bloom->data = data;
+  bloom->size = size;
+  bloom->n = n;
+  bloom->tweak = tweak;
+  bloom->update = update;
+
+  return true;
+}
+
+void
+bch_bloom_clear(bch_bloom_t *bloom) {
+  assert(bloom && "bloom is null");
+
+  if (bloom->data)
+    memset(bloom->data, 0x00, bloom->size);
+}
+
+void
+bch_bloom_add(bch_bloom_t *bloom, const uint8_t *data, size_t data_len) {
+  assert(bloom && "bloom is null");
+  assert(data && "data is null");
+
+  uint32_t hashes[BCH_BLOOM_MAX_FUNCS];
+  uint32_t bits = (uint32_t)bloom->size * 8;
+  uint32_t i;
+
+  if (bloom->size == 0)
+    return;
+
+  bch_map_tweak3_many(data, data_len, bloom->n, bloom->tweak, hashes);
+
+  for (i = 0; i < bloom->n; i++) {
+    uint32_t bit = hashes[i] % bits;
+    bloom->data[bit >> 3] |= 1 << (bit & 7);
+  }
+}
+
+bool
+bch_bloom_has(const bch_bloom_t *bloom, const uint8_t *data, size_t data_len) {
+  assert(bloom && "bloom is null");
+  assert(data && "data is null");
+
+  uint32_t hashes[BCH_BLOOM_MAX_FUNCS];
+  uint32_t bits = (uint32_t)bloom->size * 8;
+  uint32_t i;
+
+  if (bloom->size == 0)
+    return false;
+
+  bch_map_tweak3_many(data, data_len, bloom->n, bloom->tweak, hashes);
+
+  for (i = 0; i < bloom->n; i++) {
+    uint32_t bit = hashes[i] % bits;
+
+    if (!(bloom->data[bit >> 3] & (1 << (bit & 7))))
+      return false;
+  }
+
+  return true;
+}
+
+void
+bch_bloom_add_many(
+  bch_bloom_t *bloom,
+  const uint8_t **items,
+  const size_t *lens,
+  size_t len
+) {
+  assert(bloom && "bloom is null");
+  assert((items || len == 0) && "items is null");
+
+  size_t i;
+
+  for (i = 0; i < len; i++)
+    bch_bloom_add(bloom, items[i], lens[i]);
+}
+
+// Test `len` items, writing each result to `results`
+// (may be NULL). Returns the number of matches.
+size_t
+bch_bloom_has_many(
+  const bch_bloom_t *bloom,
+  const uint8_t **items,
+  const size_t *lens,
+  bool *results,
+  size_t len
+) {
+  assert(bloom && "bloom is null");
+  assert((items || len == 0) && "items is null");
+
+  size_t matches = 0;
+  size_t i;
+
+  for (i = 0; i < len; i++) {
+    bool match = bch_bloom_has(bloom, items[i], lens[i]);
+
+    if (results)
+      results[i] = match;
+
+    matches += match;
+  }
+
+  return matches;
+}
+
+/*
+ * Serialization (filterload)
+ */
+
+int
+bch_bloom_size(const bch_bloom_t *bloom) {
+  assert(bloom && "bloom is null");
+  return (int)size_varbytes(bloom->size) + 9;
+}
+
+int
+bch_bloom_write(const bch_bloom_t *bloom, uint8_t **data) {
+  assert(bloom && "bloom is null");
+  assert(data && "data is null");
+
+  int s = 0;
+  s += write_varbytes(data, bloom->data, bloom->size);
+  s += write_u32(data, bloom->n);
+  s += write_u32(data, bloom->tweak);
+  s += write_u8(data, bloom->update);
+  return s;
+}
+
+int
+bch_bloom_encode(const bch_bloom_t *bloom, uint8_t *data) {
+  return bch_bloom_write(bloom, &data);
+}
+
+bool
+bch_bloom_write_buf(const bch_bloom_t *bloom, bch_buf_t *buf) {
+  assert(bloom && "bloom is null");
+  assert(buf && "buf is null");
+
+  if (!bch_buf_write_varbytes(buf, bloom->data, bloom->size))
+    return false;
+
+  if (!bch_buf_write_u32(buf, bloom->n))
+    return false;
+
+  if (!bch_buf_write_u32(buf, bloom->tweak))
+    return false;
+
+  return bch_buf_write_u8(buf, bloom->update);
+}
+
+bool
+bch_bloom_read(uint8_t **data, size_t *data_len, bch_bloom_t *bloom) {
+  assert(data && "data is null");
+  assert(data_len && "data_len is null");
+  assert(bloom && "bloom is null");
+
+  uint8_t *filter;
+  size_t size;
+  uint32_t n, tweak;
+  uint8_t update;
+
+  if (!slice_varbytes(data, data_len, &filter, &size))
+    return false;
+
+  if (!read_u32(data, data_len, &n))
+    return false;
+
+  if (!read_u32(data, data_len, &tweak))
+    return false;
+
+  if (!read_u8(data, data_len, &update))
+    return false;
+
+  if (!bch_bloom_set(bloom, size, n, tweak, update))
+    return false;
+
+  memcpy(bloom->data, filter, size);
+
+  return true;
+}
+
+bool
+bch_bloom_decode(const uint8_t *data, size_t data_len, bch_bloom_t *bloom) {
+  return bch_bloom_read((uint8_t **)&data, &data_len, bloom);
+}
+
+// Apply a filteradd payload.
+bool
+bch_bloom_read_add(uint8_t **data, size_t *data_len, bch_bloom_t *bloom) {
+  assert(data && "data is null");
+  assert(data_len && "data_len is null");
+  assert(bloom && "bloom is null");
+
+  uint8_t *item;
+  size_t size;
+
+  if (!slice_varbytes(data, data_len, &item, &size))
+    return false;
+
+  if (size > BCH_BLOOM_MAX_ITEM)
+    return false;
+
+  if (bloom->size == 0)
+    return false;
+
+  bch_bloom_add(bloom, item, size);
+
+  return true;
+}
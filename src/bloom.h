@@ -0,0 +1,103 @@
+#ifndef _BCH_BLOOM_H
+#define _BCH_BLOOM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "buf.h"
+
+// BIP37 limits.
+#define BCH_BLOOM_MAX_SIZE 36000
+#define BCH_BLOOM_MAX_FUNCS 50
+#define BCH_BLOOM_MAX_ITEM 520
+
+#define BCH_BLOOM_UPDATE_NONE 0
+#define BCH_BLOOM_UPDATE_ALL 1
+#define BCH_BLOOM_UPDATE_P2PUBKEY_ONLY 2
+
+typedef struct bch_bloom_s {
+  uint8_t *data;
+  size_t size;
+  uint32_t n;
+  uint32_t tweak;
+  uint8_t update;
+} bch_bloom_t;
+
+void
+bch_bloom_init(bch_bloom_t *bloom);
+
+void
+bch_bloom_uninit(bch_bloom_t *bloom);
+
+bch_bloom_t *
+bch_bloom_alloc(void);
+
+void
+bch_bloom_free(bch_bloom_t *bloom);
+
+bool
+bch_bloom_reset(
+  bch_bloom_t *bloom,
+  uint32_t items,
+  double rate,
+  uint32_t tweak,
+  uint8_t update
+);
+
+bool
+bch_bloom_set(
+  bch_bloom_t *bloom,
+  size_t size,
+  uint32_t n,
+  uint32_t tweak,
+  uint8_t update
+);
+
+void
+bch_bloom_clear(bch_bloom_t *bloom);
+
+void
+bch_bloom_add(bch_bloom_t *bloom, const uint8_t *data, size_t data_len);
+
+bool
+bch_bloom_has(const bch_bloom_t *bloom, const uint8_t *data, size_t data_len);
+
+void
+bch_bloom_add_many(
+  bch_bloom_t *bloom,
+  const uint8_t **items,
+  const size_t *lens,
+  size_t len
+);
+
+size_t
+bch_bloom_has_many(
+  const bch_bloom_t *bloom,
+  const uint8_t **items,
+  const size_t *lens,
+  bool *results,
+  size_t len
+);
+
+int
+bch_bloom_size(const bch_bloom_t *bloom);
+
+int
+bch_bloom_write(const bch_bloom_t *bloom, uint8_t **data);
+
+int
+bch_bloom_encode(const bch_bloom_t *bloom, uint8_t *data);
+
+bool
+bch_bloom_write_buf(const bch_bloom_t *bloom, bch_buf_t *buf);
+
+bool
+bch_bloom_read(uint8_t **data, size_t *data_len, bch_bloom_t *bloom);
+
+bool
+bch_bloom_decode(const uint8_t *data, size_t data_len, bch_bloom_t *bloom);
+
+bool
+bch_bloom_read_add(uint8_t **data, size_t *data_len, bch_bloom_t *bloom);
+#endif
@@ -12,8 +12,6 @@
 
 #include "bn.h"
 
-static void _lshift_one_bit(bch_bn_t *a);
-static void _rshift_one_bit(bch_bn_t *a);
 static void _lshift_word(bch_bn_t *a, int nwords);
 static void _rshift_word(bch_bn_t *a, int nwords);
 
@@ -253,101 +251,214 @@ bch_bn_sub(const bch_bn_t *a, const bch_bn_t *b, bch_bn_t *c) {
 
 void
 bch_bn_mul(const bch_bn_t *a, const bch_bn_t *b, bch_bn_t *c) {
+  // Comba (column-wise) multiplication, truncated
+  // to BCH_BN_SIZE digits. Each column sums its
+  // partial products into a 96 bit accumulator
+  // (acc + hi) before emitting one digit.
   assert(a && "a is null");
   assert(b && "b is null");
   assert(c && "c is null");
 
-  bch_bn_t row;
-  bch_bn_t tmp;
   bch_bn_t cc;
-  int i, j;
+  uint64_t acc = 0;
+  uint32_t hi = 0;
+  int i, k;
 
-  bch_bn_init(&cc);
+  for (k = 0; k < BCH_BN_SIZE; k++) {
+    for (i = 0; i <= k; i++) {
+      uint64_t t = (uint64_t)a->array[i] * (uint64_t)b->array[k - i];
 
-  for (i = 0; i < BCH_BN_SIZE; i++) {
-    bch_bn_init(&row);
+      acc += t;
+      hi += (acc < t);
+    }
+
+    cc.array[k] = (uint32_t)acc;
+    acc = (acc >> 32) | ((uint64_t)hi << 32);
+    hi = 0;
+  }
 
-    for (j = 0; j < BCH_BN_SIZE; j++) {
-      if (i + j < BCH_BN_SIZE) {
-        bch_bn_init(&tmp);
+  bch_bn_assign(c, &cc);
+}
 
-        uint64_t intermediate =
-          ((uint64_t)a->array[i] * (uint64_t)b->array[j]);
+static int
+_nlz(uint32_t x) {
+  int n = 0;
 
-        bch_bn_from_int(&tmp, intermediate);
-        _lshift_word(&tmp, i + j);
-        bch_bn_add(&tmp, &row, &row);
-      }
-    }
+  if (x == 0)
+    return 32;
 
-    bch_bn_add(&cc, &row, &cc);
+  if (x <= 0x0000ffff) {
+    n += 16;
+    x <<= 16;
   }
 
-  bch_bn_assign(c, &cc);
+  if (x <= 0x00ffffff) {
+    n += 8;
+    x <<= 8;
+  }
+
+  if (x <= 0x0fffffff) {
+    n += 4;
+    x <<= 4;
+  }
+
+  if (x <= 0x3fffffff) {
+    n += 2;
+    x <<= 2;
+  }
+
+  if (x <= 0x7fffffff)
+    n += 1;
+
+  return n;
 }
 
 void
-bch_bn_div(const bch_bn_t *a, const bch_bn_t *b, bch_bn_t *c) {
+bch_bn_divmod(
+  const bch_bn_t *a,
+  const bch_bn_t *b,
+  bch_bn_t *c,
+  bch_bn_t *d
+) {
+  // Knuth's Algorithm D (TAOCP vol. 2, 4.3.1)
+  // with 32 bit digits. c = a / b, d = a % b.
+  // Either output may be NULL or alias an input.
   assert(a && "a is null");
   assert(b && "b is null");
-  assert(c && "c is null");
+  assert(!bch_bn_is_zero(b) && "division by zero");
 
-  bch_bn_t current;
-  bch_bn_t denom;
-  bch_bn_t tmp;
+  uint32_t un[BCH_BN_SIZE + 1];
+  uint32_t vn[BCH_BN_SIZE];
+  bch_bn_t q;
+  int m, n, s, i, j;
 
-  // int current = 1;
-  bch_bn_from_int(&current, 1);
-  // denom = b
-  bch_bn_assign(&denom, b);
-  // tmp = a
-  bch_bn_assign(&tmp, a);
+  bch_bn_init(&q);
 
-  const uint64_t half_max = 1 + (uint64_t)(BCH_BN_MAX / 2);
-  bool overflow = false;
+  // Significant digits.
+  n = BCH_BN_SIZE;
+  while (b->array[n - 1] == 0)
+    n -= 1;
 
-  // while (denom <= a) {
-  while (bch_bn_cmp(&denom, a) != 1) {
-    if (denom.array[BCH_BN_SIZE - 1] >= half_max) {
-      overflow = true;
-      break;
+  m = BCH_BN_SIZE;
+  while (m > 0 && a->array[m - 1] == 0)
+    m -= 1;
+
+  if (m < n) {
+    if (d)
+      bch_bn_assign(d, a);
+
+    if (c)
+      bch_bn_assign(c, &q);
+
+    return;
+  }
+
+  // Single digit divisor: schoolbook short division.
+  if (n == 1) {
+    uint64_t v = b->array[0];
+    uint64_t rem = 0;
+
+    for (j = m - 1; j >= 0; j--) {
+      uint64_t cur = (rem << 32) | a->array[j];
+      q.array[j] = (uint32_t)(cur / v);
+      rem = cur % v;
     }
 
-    // current <<= 1;
-    _lshift_one_bit(&current);
+    if (d)
+      bch_bn_from_int(d, rem);
+
+    if (c)
+      bch_bn_assign(c, &q);
+
+    return;
+  }
+
+  // Normalize so the top divisor digit has its high bit set.
+  s = _nlz(b->array[n - 1]);
 
-    // denom <<= 1;
-    _lshift_one_bit(&denom);
+  for (i = n - 1; i > 0; i--) {
+    vn[i] = (b->array[i] << s)
+      | (uint32_t)((uint64_t)b->array[i - 1] >> (32 - s));
   }
 
-  if (!overflow) {
-    // denom >>= 1;
-    _rshift_one_bit(&denom);
-    // current >>= 1;
-    _rshift_one_bit(&current);
+  vn[0] = b->array[0] << s;
+
+  un[m] = (uint32_t)((uint64_t)a->array[m - 1] >> (32 - s));
+
+  for (i = m - 1; i > 0; i--) {
+    un[i] = (a->array[i] << s)
+      | (uint32_t)((uint64_t)a->array[i - 1] >> (32 - s));
   }
 
-  // int answer = 0;
-  bch_bn_init(c);
-
-  // while (current != 0)
-  while (!bch_bn_is_zero(&current)) {
-    // if (dividend >= denom)
-    if (bch_bn_cmp(&tmp, &denom) != -1)  {
-      // dividend -= denom;
-      bch_bn_sub(&tmp, &denom, &tmp);
-      // answer |= current;
-      bch_bn_or(c, &current, c);
+  un[0] = a->array[0] << s;
+
+  for (j = m - n; j >= 0; j--) {
+    // Estimate the quotient digit from the top two
+    // dividend digits and refine it with the second
+    // divisor digit. It is then at most one too large.
+    uint64_t num = ((uint64_t)un[j + n] << 32) | un[j + n - 1];
+    uint64_t qhat = num / vn[n - 1];
+    uint64_t rhat = num % vn[n - 1];
+
+    while (qhat > BCH_BN_MAX
+           || qhat * vn[n - 2] > ((rhat << 32) | un[j + n - 2])) {
+      qhat -= 1;
+      rhat += vn[n - 1];
+
+      if (rhat > BCH_BN_MAX)
+        break;
+    }
+
+    // Multiply and subtract.
+    int64_t t;
+    uint64_t k = 0;
+
+    for (i = 0; i < n; i++) {
+      uint64_t p = qhat * vn[i];
+      t = (int64_t)un[i + j] - (int64_t)k - (int64_t)(p & BCH_BN_MAX);
+      un[i + j] = (uint32_t)t;
+      k = (p >> 32) - (t >> 32);
+    }
+
+    t = (int64_t)un[j + n] - (int64_t)k;
+    un[j + n] = (uint32_t)t;
+
+    // Went negative: add back.
+    if (t < 0) {
+      qhat -= 1;
+      k = 0;
+
+      for (i = 0; i < n; i++) {
+        t = (int64_t)un[i + j] + vn[i] + k;
+        un[i + j] = (uint32_t)t;
+        k = (uint64_t)t >> 32;
+      }
+
+      un[j + n] += (uint32_t)k;
     }
 
-    // current >>= 1;
-    _rshift_one_bit(&current);
+    q.array[j] = (uint32_t)qhat;
+  }
+
+  if (d) {
+    bch_bn_init(d);
+
+    for (i = 0; i < n - 1; i++) {
+      d->array[i] = (un[i] >> s)
+        | (uint32_t)((uint64_t)un[i + 1] << (32 - s));
+    }
 
-    // denom >>= 1;
-    _rshift_one_bit(&denom);
+    d->array[n - 1] = un[n - 1] >> s;
   }
 
-  // return answer;
+  if (c)
+    bch_bn_assign(c, &q);
+}
+
+void
+bch_bn_div(const bch_bn_t *a, const bch_bn_t *b, bch_bn_t *c) {
+  assert(c && "c is null");
+  bch_bn_divmod(a, b, c, NULL);
 }
 
 void
@@ -408,23 +519,8 @@ bch_bn_rshift(bch_bn_t *a, bch_bn_t *b, int nbits) {
 
 void
 bch_bn_mod(const bch_bn_t *a, const bch_bn_t *b, bch_bn_t *c) {
-  // mod(a, b) = a - ((a / b) * b)
-  // example:
-  //   mod(8, 3) = 8 - ((8 / 3) * 3) = 2
-  assert(a && "a is null");
-  assert(b && "b is null");
   assert(c && "c is null");
-
-  bch_bn_t tmp;
-
-  // c = (a / b)
-  bch_bn_div(a, b, c);
-
-  // tmp = (c * b)
-  bch_bn_mul(c, b, &tmp);
-
-  // c = a - tmp
-  bch_bn_sub(a, &tmp, c);
+  bch_bn_divmod(a, b, NULL, c);
 }
 
 void
@@ -495,39 +591,31 @@ bch_bn_is_zero(const bch_bn_t *n) {
 }
 
 void
-bch_bn_pow(const bch_bn_t *a, bch_bn_t *b, bch_bn_t *c) {
+bch_bn_pow(const bch_bn_t *a, const bch_bn_t *b, bch_bn_t *c) {
+  // Left-to-right square-and-multiply over the
+  // bits of b: c = a^b, truncated like bch_bn_mul.
   assert(a && "a is null");
   assert(b && "b is null");
   assert(c && "c is null");
 
-  bch_bn_t tmp;
+  bch_bn_t base;
   bch_bn_t cc;
+  int i, j;
 
-  bch_bn_init(&cc);
-
-  if (bch_bn_cmp(b, &cc) == 0) {
-    // Return 1 when exponent
-    // is 0 -- n^0 = 1
-    bch_bn_inc(&cc);
-  } else {
-    // Copy a -> tmp
-    bch_bn_assign(&tmp, a);
-
-    bch_bn_dec(b);
+  bch_bn_assign(&base, a);
+  bch_bn_from_int(&cc, 1);
 
-    // Begin summing products:
-    while (!bch_bn_is_zero(b)) {
-      // c = tmp * tmp
-      bch_bn_mul(&tmp, a, &cc);
+  i = BCH_BN_SIZE - 1;
+  while (i >= 0 && b->array[i] == 0)
+    i -= 1;
 
-      // Decrement b by one
-      bch_bn_dec(b);
+  for (; i >= 0; i--) {
+    for (j = 31; j >= 0; j--) {
+      bch_bn_mul(&cc, &cc, &cc);
 
-      bch_bn_assign(&tmp, &cc);
+      if ((b->array[i] >> j) & 1)
+        bch_bn_mul(&cc, &base, &cc);
     }
-
-    // c = tmp
-    bch_bn_assign(&cc, &tmp);
   }
 
   bch_bn_assign(c, &cc);
@@ -572,29 +660,3 @@ _lshift_word(bch_bn_t *a, int nwords) {
   for (; i >= 0; i--)
     a->array[i] = 0;
 }
-
-static void
-_lshift_one_bit(bch_bn_t *a) {
-  assert(a && "a is null");
-
-  int i;
-  for (i = (BCH_BN_SIZE - 1); i > 0; i--) {
-    a->array[i] = (a->array[i] << 1)
-      | (a->array[i - 1] >> ((8 * 4) - 1));
-  }
-
-  a->array[0] <<= 1;
-}
-
-static void
-_rshift_one_bit(bch_bn_t *a) {
-  assert(a && "a is null");
-
-  int i;
-  for (i = 0; i < (BCH_BN_SIZE - 1); i++) {
-    a->array[i] = (a->array[i] >> 1)
-      | (a->array[i + 1] << ((8 * 4) - 1));
-  }
-
-  a->array[BCH_BN_SIZE - 1] >>= 1;
-}
@@ -63,6 +63,14 @@ bch_bn_div(const bch_bn_t *a, const bch_bn_t *b, bch_bn_t *c); // c = a / b
 void
 bch_bn_mod(const bch_bn_t *a, const bch_bn_t *b, bch_bn_t *c); // c = a % b
 
+void
+bch_bn_divmod(
+  const bch_bn_t *a,
+  const bch_bn_t *b,
+  bch_bn_t *c,
+  bch_bn_t *d
+); // c = a / b, d = a % b
+
 /*
  * Bitwise Operations
  */
@@ -102,7 +110,7 @@ void
 bch_bn_dec(bch_bn_t *n);
 
 void
-bch_bn_pow(const bch_bn_t *a, bch_bn_t *b, bch_bn_t *c);
+bch_bn_pow(const bch_bn_t *a, const bch_bn_t *b, bch_bn_t *c); // c = a ^ b
 
 void
 bch_bn_assign(bch_bn_t *dst, const bch_bn_t *src);
@@ -0,0 +1,323 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+
+#include "bio.h"
+#include "buf.h"
+
+/*
+ * Pool
+ */
+
+void
+bch_pool_init(bch_pool_t *pool, size_t max) {
+  assert(pool && "pool is null");
+
+  pool->free = NULL;
+  pool->count = 0;
+  pool->max = max;
+}
+
+void
+bch_pool_uninit(bch_pool_t *pool) {
+  if (!pool)
+    return;
+
+  bch_chunk_t *c, *next;
+
+  for (c = pool->free; c; c = next) {
+    next = c->next;
+    free(c);
+  }
+
+  pool->free = NULL;
+  pool->count = 0;
+}
+
+static bch_chunk_t *
+bch_pool_get(bch_pool_t *pool) {
+  bch_chunk_t *c;
+
+  if (pool && pool->free) {
+    c = pool->free;
+    pool->free = c->next;
+    pool->count -= 1;
+  } else {
+    c = malloc(sizeof(bch_chunk_t));
+
+    if (!c)
+      return NULL;
+  }
+
+  c->next = NULL;
+  c->len = 0;
+
+  return c;
+}
+
+static void
+bch_pool_put(bch_pool_t *pool, bch_chunk_t *c) {
+  if (!pool || pool->count >= pool->max) {
+    free(c);
+    return;
+  }
+
+  c->next = pool->free;
+  pool->free = c;
+  pool->count += 1;
+}
+
+/*
+ * Buffer
+ */
+
+void
+bch_buf_init(bch_buf_t *buf, bch_pool_t *pool) {
+  assert(buf && "buf is null");
+
+  buf->pool = pool;
+  buf->head = NULL;
+  buf->tail = NULL;
+  buf->size = 0;
+  buf->chunks = 0;
+  buf->refs = 0;
+}
+
+void
+bch_buf_uninit(bch_buf_t *buf) {
+  if (!buf)
+    return;
+
+  bch_buf_reset(buf);
+}
+
+bch_buf_t *
+bch_buf_alloc(bch_pool_t *pool) {
+  bch_buf_t *buf = malloc(sizeof(bch_buf_t));
+
+  if (!buf)
+    return NULL;
+
+  bch_buf_init(buf, pool);
+
+  buf->refs = 1;
+
+  return buf;
+}
+
+void
+bch_buf_ref(bch_buf_t *buf) {
+  assert(buf && "buf is null");
+  assert(buf->refs > 0 && "buf is not refcounted");
+
+  buf->refs += 1;
+}
+
+// Drop a reference taken by bch_buf_alloc or
+// bch_buf_ref. Chunks go back to the pool with
+// the last one.
+void
+bch_buf_unref(bch_buf_t *buf) {
+  if (!buf)
+    return;
+
+  assert(buf->refs > 0 && "buf is not refcounted");
+
+  buf->refs -= 1;
+
+  if (buf->refs == 0) {
+    bch_buf_uninit(buf);
+    free(buf);
+  }
+}
+
+void
+bch_buf_reset(bch_buf_t *buf) {
+  assert(buf && "buf is null");
+
+  bch_chunk_t *c, *next;
+
+  for (c = buf->head; c; c = next) {
+    next = c->next;
+    bch_pool_put(buf->pool, c);
+  }
+
+  buf->head = NULL;
+  buf->tail = NULL;
+  buf->size = 0;
+  buf->chunks = 0;
+}
+
+// Return `size` contiguous bytes at the end of the
+// buffer, starting a new chunk if the current one is
+// too full. The pointer stays valid for the life of
+// the buffer, so space (e.g. a message header) can be
+// reserved first and filled in afterwards.
+uint8_t *
+bch_buf_reserve(bch_buf_t *buf, size_t size) {
+  assert(buf && "buf is null");
+  assert(size <= BCH_BUF_CHUNK_SIZE && "reservation too large");
+
+  bch_chunk_t *c = buf->tail;
+  uint8_t *p;
+
+  if (!c || BCH_BUF_CHUNK_SIZE - c->len < size) {
+    c = bch_pool_get(buf->pool);
+
+    if (!c)
+      return NULL;
+
+    if (buf->tail)
+      buf->tail->next = c;
+    else
+      buf->head = c;
+
+    buf->tail = c;
+    buf->chunks += 1;
+  }
+
+  p = &c->data[c->len];
+
+  c->len += size;
+  buf->size += size;
+
+  return p;
+}
+
+bool
+bch_buf_write(bch_buf_t *buf, const uint8_t *data, size_t size) {
+  assert(buf && "buf is null");
+
+  while (size > 0) {
+    bch_chunk_t *c = buf->tail;
+    size_t room = c ? BCH_BUF_CHUNK_SIZE - c->len : 0;
+    size_t n;
+    uint8_t *p;
+
+    // Large writes fill the current chunk first.
+    if (room == 0)
+      room = BCH_BUF_CHUNK_SIZE;
+
+    n = size < room ? size : room;
+    p = bch_buf_reserve(buf, n);
+
+    if (!p)
+      return false;
+
+    memcpy(p, data, n);
+
+    data += n;
+    size -= n;
+  }
+
+  return true;
+}
+
+bool
+bch_buf_write_u8(bch_buf_t *buf, uint8_t value) {
+  uint8_t *p = bch_buf_reserve(buf, 1);
+
+  if (!p)
+    return false;
+
+  write_u8(&p, value);
+
+  return true;
+}
+
+bool
+bch_buf_write_u16(bch_buf_t *buf, uint16_t value) {
+  uint8_t *p = bch_buf_reserve(buf, 2);
+
+  if (!p)
+    return false;
+
+  write_u16(&p, value);
+
+  return true;
+}
+
+bool
+bch_buf_write_u32(bch_buf_t *buf, uint32_t value) {
+  uint8_t *p = bch_buf_reserve(buf, 4);
+
+  if (!p)
+    return false;
+
+  write_u32(&p, value);
+
+  return true;
+}
+
+bool
+bch_buf_write_u64(bch_buf_t *buf, uint64_t value) {
+  uint8_t *p = bch_buf_reserve(buf, 8);
+
+  if (!p)
+    return false;
+
+  write_u64(&p, value);
+
+  return true;
+}
+
+bool
+bch_buf_write_varint(bch_buf_t *buf, uint64_t value) {
+  uint8_t *p = bch_buf_reserve(buf, size_varint(value));
+
+  if (!p)
+    return false;
+
+  write_varint(&p, value);
+
+  return true;
+}
+
+bool
+bch_buf_write_varbytes(bch_buf_t *buf, const uint8_t *data, size_t size) {
+  if (!bch_buf_write_varint(buf, (uint64_t)size))
+    return false;
+
+  return bch_buf_write(buf, data, size);
+}
+
+// Fill up to `max` iovecs, one per chunk.
+// Returns the number filled.
+size_t
+bch_buf_iov(const bch_buf_t *buf, struct iovec *iov, size_t max) {
+  assert(buf && "buf is null");
+  assert((iov || max == 0) && "iov is null");
+
+  const bch_chunk_t *c;
+  size_t n = 0;
+
+  for (c = buf->head; c && n < max; c = c->next) {
+    iov[n].iov_base = (void *)c->data;
+    iov[n].iov_len = c->len;
+    n += 1;
+  }
+
+  return n;
+}
+
+// Copy out the first `size` bytes (for
+// checksumming or small messages).
+size_t
+bch_buf_read(const bch_buf_t *buf, uint8_t *out, size_t size) {
+  assert(buf && "buf is null");
+  assert((out || size == 0) && "out is null");
+
+  const bch_chunk_t *c;
+  size_t n = 0;
+
+  for (c = buf->head; c && n < size; c = c->next) {
+    size_t len = c->len < size - n ? c->len : size - n;
+    memcpy(&out[n], c->data, len);
+    n += len;
+  }
+
+  return n;
+}
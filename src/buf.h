@@ -0,0 +1,101 @@
+#ifndef _BCH_BUF_H
+#define _BCH_BUF_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <sys/uio.h>
+
+/*
+ * Chunked serialization buffer.
+ *
+ * Data is written in a single pass into a chain of
+ * fixed-size chunks taken from a pool, so there is no
+ * sizing pass and nothing is ever moved or copied once
+ * written. The chain is handed to writev()/uv_write()
+ * as an iovec (uv_buf_t is layout compatible with struct
+ * iovec on unix). Buffers are reference counted so one
+ * serialized message can be queued to many peers.
+ */
+
+// Chunk payload; a chunk with its header is 4096 bytes.
+#define BCH_BUF_CHUNK_SIZE (4096 - 2 * sizeof(size_t))
+
+typedef struct bch_chunk_s {
+  struct bch_chunk_s *next;
+  size_t len;
+  uint8_t data[BCH_BUF_CHUNK_SIZE];
+} bch_chunk_t;
+
+typedef struct bch_pool_s {
+  bch_chunk_t *free;
+  size_t count;
+  size_t max;
+} bch_pool_t;
+
+typedef struct bch_buf_s {
+  bch_pool_t *pool;
+  bch_chunk_t *head;
+  bch_chunk_t *tail;
+  size_t size;
+  size_t chunks;
+  int refs;
+} bch_buf_t;
+
+#define bch_buf_size(buf) ((buf)->size)
+#define bch_buf_iovcnt(buf) ((buf)->chunks)
+
+void
+bch_pool_init(bch_pool_t *pool, size_t max);
+
+void
+bch_pool_uninit(bch_pool_t *pool);
+
+void
+bch_buf_init(bch_buf_t *buf, bch_pool_t *pool);
+
+void
+bch_buf_uninit(bch_buf_t *buf);
+
+bch_buf_t *
+bch_buf_alloc(bch_pool_t *pool);
+
+void
+bch_buf_ref(bch_buf_t *buf);
+
+void
+bch_buf_unref(bch_buf_t *buf);
+
+void
+bch_buf_reset(bch_buf_t *buf);
+
+uint8_t *
+bch_buf_reserve(bch_buf_t *buf, size_t size);
+
+bool
+bch_buf_write(bch_buf_t *buf, const uint8_t *data, size_t size);
+
+bool
+bch_buf_write_u8(bch_buf_t *buf, uint8_t value);
+
+bool
+bch_buf_write_u16(bch_buf_t *buf, uint16_t value);
+
+bool
+bch_buf_write_u32(bch_buf_t *buf, uint32_t value);
+
+bool
+bch_buf_write_u64(bch_buf_t *buf, uint64_t value);
+
+bool
+bch_buf_write_varint(bch_buf_t *buf, uint64_t value);
+
+bool
+bch_buf_write_varbytes(bch_buf_t *buf, const uint8_t *data, size_t size);
+
+size_t
+bch_buf_iov(const bch_buf_t *buf, struct iovec *iov, size_t max);
+
+size_t
+bch_buf_read(const bch_buf_t *buf, uint8_t *out, size_t size);
+#endif
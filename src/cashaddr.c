@@ -0,0 +1,720 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "cashaddr.h"
+
+/*
+ * CashAddr
+ *
+ * The checksum is a BCH code over GF(32) with a 40 bit
+ * state. Instead of five conditional XORs per symbol,
+ * the polymod consumes two symbols per step: the top
+ * ten bits of the state index a precomputed table of
+ * their combined reduction.
+ */
+
+static const char *bch_cashaddr_charset =
+  "qpzry9x8gf2tvdw0s3jn54khce6mua7l";
+
+static const int8_t bch_cashaddr_rev[128] = {
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  15, -1, 10, 17, 21, 20, 26, 30,  7,  5, -1, -1, -1, -1, -1, -1,
+  -1, 29, -1, 24, 13, 25,  9,  8, 23, -1, 18, 22, 31, 27, 19, -1,
+   1,  0,  3, 16, 11, 28, 12, 14,  6,  4,  2, -1, -1, -1, -1, -1,
+  -1, 29, -1, 24, 13, 25,  9,  8, 23, -1, 18, 22, 31, 27, 19, -1,
+   1,  0,  3, 16, 11, 28, 12, 14,  6,  4,  2, -1, -1, -1, -1, -1
+};
+
+// Reduction of the top symbol (state >> 35).
+static const uint64_t bch_cashaddr_table5[32] = {
+  0x0000000000ULL, 0x98f2bc8e61ULL, 0x79b76d99e2ULL, 0xe145d11783ULL,
+  0xf33e5fb3c4ULL, 0x6bcce33da5ULL, 0x8a89322a26ULL, 0x127b8ea447ULL,
+  0xae2eabe2a8ULL, 0x36dc176cc9ULL, 0xd799c67b4aULL, 0x4f6b7af52bULL,
+  0x5d10f4516cULL, 0xc5e248df0dULL, 0x24a799c88eULL, 0xbc552546efULL,
+  0x1e4f43e470ULL, 0x86bdff6a11ULL, 0x67f82e7d92ULL, 0xff0a92f3f3ULL,
+  0xed711c57b4ULL, 0x7583a0d9d5ULL, 0x94c671ce56ULL, 0x0c34cd4037ULL,
+  0xb061e806d8ULL, 0x28935488b9ULL, 0xc9d6859f3aULL, 0x512439115bULL,
+  0x435fb7b51cULL, 0xdbad0b3b7dULL, 0x3ae8da2cfeULL, 0xa21a66a29fULL
+};
+
+// Reduction of the top two symbols (state >> 30).
+static const uint64_t bch_cashaddr_table10[1024] = {
+  0x0000000000ULL, 0x98f2bc8e61ULL, 0x79b76d99e2ULL, 0xe145d11783ULL,
+  0xf33e5fb3c4ULL, 0x6bcce33da5ULL, 0x8a89322a26ULL, 0x127b8ea447ULL,
+  0xae2eabe2a8ULL, 0x36dc176cc9ULL, 0xd799c67b4aULL, 0x4f6b7af52bULL,
+  0x5d10f4516cULL, 0xc5e248df0dULL, 0x24a799c88eULL, 0xbc552546efULL,
+  0x1e4f43e470ULL, 0x86bdff6a11ULL, 0x67f82e7d92ULL, 0xff0a92f3f3ULL,
+  0xed711c57b4ULL, 0x7583a0d9d5ULL, 0x94c671ce56ULL, 0x0c34cd4037ULL,
+  0xb061e806d8ULL, 0x28935488b9ULL, 0xc9d6859f3aULL, 0x512439115bULL,
+  0x435fb7b51cULL, 0xdbad0b3b7dULL, 0x3ae8da2cfeULL, 0xa21a66a29fULL,
+  0xe15d033fd3ULL, 0x79afbfb1b2ULL, 0x98ea6ea631ULL, 0x0018d22850ULL,
+  0x12635c8c17ULL, 0x8a91e00276ULL, 0x6bd43115f5ULL, 0xf3268d9b94ULL,
+  0x4f73a8dd7bULL, 0xd78114531aULL, 0x36c4c54499ULL, 0xae3679caf8ULL,
+  0xbc4df76ebfULL, 0x24bf4be0deULL, 0xc5fa9af75dULL, 0x5d0826793cULL,
+  0xff1240dba3ULL, 0x67e0fc55c2ULL, 0x86a52d4241ULL, 0x1e5791cc20ULL,
+  0x0c2c1f6867ULL, 0x94dea3e606ULL, 0x759b72f185ULL, 0xed69ce7fe4ULL,
+  0x513ceb390bULL, 0xc9ce57b76aULL, 0x288b86a0e9ULL, 0xb0793a2e88ULL,
+  0xa202b48acfULL, 0x3af00804aeULL, 0xdbb5d9132dULL, 0x4347659d4cULL,
+  0x8ab8967aafULL, 0x124a2af4ceULL, 0xf30ffbe34dULL, 0x6bfd476d2cULL,
+  0x7986c9c96bULL, 0xe17475470aULL, 0x0031a45089ULL, 0x98c318dee8ULL,
+  0x24963d9807ULL, 0xbc64811666ULL, 0x5d215001e5ULL, 0xc5d3ec8f84ULL,
+  0xd7a8622bc3ULL, 0x4f5adea5a2ULL, 0xae1f0fb221ULL, 0x36edb33c40ULL,
+  0x94f7d59edfULL, 0x0c056910beULL, 0xed40b8073dULL, 0x75b204895cULL,
+  0x67c98a2d1bULL, 0xff3b36a37aULL, 0x1e7ee7b4f9ULL, 0x868c5b3a98ULL,
+  0x3ad97e7c77ULL, 0xa22bc2f216ULL, 0x436e13e595ULL, 0xdb9caf6bf4ULL,
+  0xc9e721cfb3ULL, 0x51159d41d2ULL, 0xb0504c5651ULL, 0x28a2f0d830ULL,
+  0x6be595457cULL, 0xf31729cb1dULL, 0x1252f8dc9eULL, 0x8aa04452ffULL,
+  0x98dbcaf6b8ULL, 0x00297678d9ULL, 0xe16ca76f5aULL, 0x799e1be13bULL,
+  0xc5cb3ea7d4ULL, 0x5d398229b5ULL, 0xbc7c533e36ULL, 0x248eefb057ULL,
+  0x36f5611410ULL, 0xae07dd9a71ULL, 0x4f420c8df2ULL, 0xd7b0b00393ULL,
+  0x75aad6a10cULL, 0xed586a2f6dULL, 0x0c1dbb38eeULL, 0x94ef07b68fULL,
+  0x86948912c8ULL, 0x1e66359ca9ULL, 0xff23e48b2aULL, 0x67d158054bULL,
+  0xdb847d43a4ULL, 0x4376c1cdc5ULL, 0xa23310da46ULL, 0x3ac1ac5427ULL,
+  0x28ba22f060ULL, 0xb0489e7e01ULL, 0x510d4f6982ULL, 0xc9fff3e7e3ULL,
+  0x5d232c547eULL, 0xc5d190da1fULL, 0x249441cd9cULL, 0xbc66fd43fdULL,
+  0xae1d73e7baULL, 0x36efcf69dbULL, 0xd7aa1e7e58ULL, 0x4f58a2f039ULL,
+  0xf30d87b6d6ULL, 0x6bff3b38b7ULL, 0x8abaea2f34ULL, 0x124856a155ULL,
+  0x0033d80512ULL, 0x98c1648b73ULL, 0x7984b59cf0ULL, 0xe176091291ULL,
+  0x436c6fb00eULL, 0xdb9ed33e6fULL, 0x3adb0229ecULL, 0xa229bea78dULL,
+  0xb0523003caULL, 0x28a08c8dabULL, 0xc9e55d9a28ULL, 0x5117e11449ULL,
+  0xed42c452a6ULL, 0x75b078dcc7ULL, 0x94f5a9cb44ULL, 0x0c07154525ULL,
+  0x1e7c9be162ULL, 0x868e276f03ULL, 0x67cbf67880ULL, 0xff394af6e1ULL,
+  0xbc7e2f6badULL, 0x248c93e5ccULL, 0xc5c942f24fULL, 0x5d3bfe7c2eULL,
+  0x4f4070d869ULL, 0xd7b2cc5608ULL, 0x36f71d418bULL, 0xae05a1cfeaULL,
+  0x1250848905ULL, 0x8aa2380764ULL, 0x6be7e910e7ULL, 0xf315559e86ULL,
+  0xe16edb3ac1ULL, 0x799c67b4a0ULL, 0x98d9b6a323ULL, 0x002b0a2d42ULL,
+  0xa2316c8fddULL, 0x3ac3d001bcULL, 0xdb8601163fULL, 0x4374bd985eULL,
+  0x510f333c19ULL, 0xc9fd8fb278ULL, 0x28b85ea5fbULL, 0xb04ae22b9aULL,
+  0x0c1fc76d75ULL, 0x94ed7be314ULL, 0x75a8aaf497ULL, 0xed5a167af6ULL,
+  0xff2198deb1ULL, 0x67d32450d0ULL, 0x8696f54753ULL, 0x1e6449c932ULL,
+  0xd79bba2ed1ULL, 0x4f6906a0b0ULL, 0xae2cd7b733ULL, 0x36de6b3952ULL,
+  0x24a5e59d15ULL, 0xbc57591374ULL, 0x5d128804f7ULL, 0xc5e0348a96ULL,
+  0x79b511cc79ULL, 0xe147ad4218ULL, 0x00027c559bULL, 0x98f0c0dbfaULL,
+  0x8a8b4e7fbdULL, 0x1279f2f1dcULL, 0xf33c23e65fULL, 0x6bce9f683eULL,
+  0xc9d4f9caa1ULL, 0x51264544c0ULL, 0xb063945343ULL, 0x289128dd22ULL,
+  0x3aeaa67965ULL, 0xa2181af704ULL, 0x435dcbe087ULL, 0xdbaf776ee6ULL,
+  0x67fa522809ULL, 0xff08eea668ULL, 0x1e4d3fb1ebULL, 0x86bf833f8aULL,
+  0x94c40d9bcdULL, 0x0c36b115acULL, 0xed7360022fULL, 0x7581dc8c4eULL,
+  0x36c6b91102ULL, 0xae34059f63ULL, 0x4f71d488e0ULL, 0xd783680681ULL,
+  0xc5f8e6a2c6ULL, 0x5d0a5a2ca7ULL, 0xbc4f8b3b24ULL, 0x24bd37b545ULL,
+  0x98e812f3aaULL, 0x001aae7dcbULL, 0xe15f7f6a48ULL, 0x79adc3e429ULL,
+  0x6bd64d406eULL, 0xf324f1ce0fULL, 0x126120d98cULL, 0x8a939c57edULL,
+  0x2889faf572ULL, 0xb07b467b13ULL, 0x513e976c90ULL, 0xc9cc2be2f1ULL,
+  0xdbb7a546b6ULL, 0x434519c8d7ULL, 0xa200c8df54ULL, 0x3af2745135ULL,
+  0x86a75117daULL, 0x1e55ed99bbULL, 0xff103c8e38ULL, 0x67e2800059ULL,
+  0x75990ea41eULL, 0xed6bb22a7fULL, 0x0c2e633dfcULL, 0x94dcdfb39dULL,
+  0xb056dc8cd5ULL, 0x28a46002b4ULL, 0xc9e1b11537ULL, 0x51130d9b56ULL,
+  0x4368833f11ULL, 0xdb9a3fb170ULL, 0x3adfeea6f3ULL, 0xa22d522892ULL,
+  0x1e78776e7dULL, 0x868acbe01cULL, 0x67cf1af79fULL, 0xff3da679feULL,
+  0xed4628ddb9ULL, 0x75b49453d8ULL, 0x94f145445bULL, 0x0c03f9ca3aULL,
+  0xae199f68a5ULL, 0x36eb23e6c4ULL, 0xd7aef2f147ULL, 0x4f5c4e7f26ULL,
+  0x5d27c0db61ULL, 0xc5d57c5500ULL, 0x2490ad4283ULL, 0xbc6211cce2ULL,
+  0x0037348a0dULL, 0x98c588046cULL, 0x79805913efULL, 0xe172e59d8eULL,
+  0xf3096b39c9ULL, 0x6bfbd7b7a8ULL, 0x8abe06a02bULL, 0x124cba2e4aULL,
+  0x510bdfb306ULL, 0xc9f9633d67ULL, 0x28bcb22ae4ULL, 0xb04e0ea485ULL,
+  0xa2358000c2ULL, 0x3ac73c8ea3ULL, 0xdb82ed9920ULL, 0x4370511741ULL,
+  0xff257451aeULL, 0x67d7c8dfcfULL, 0x869219c84cULL, 0x1e60a5462dULL,
+  0x0c1b2be26aULL, 0x94e9976c0bULL, 0x75ac467b88ULL, 0xed5efaf5e9ULL,
+  0x4f449c5776ULL, 0xd7b620d917ULL, 0x36f3f1ce94ULL, 0xae014d40f5ULL,
+  0xbc7ac3e4b2ULL, 0x24887f6ad3ULL, 0xc5cdae7d50ULL, 0x5d3f12f331ULL,
+  0xe16a37b5deULL, 0x79988b3bbfULL, 0x98dd5a2c3cULL, 0x002fe6a25dULL,
+  0x125468061aULL, 0x8aa6d4887bULL, 0x6be3059ff8ULL, 0xf311b91199ULL,
+  0x3aee4af67aULL, 0xa21cf6781bULL, 0x4359276f98ULL, 0xdbab9be1f9ULL,
+  0xc9d01545beULL, 0x5122a9cbdfULL, 0xb06778dc5cULL, 0x2895c4523dULL,
+  0x94c0e114d2ULL, 0x0c325d9ab3ULL, 0xed778c8d30ULL, 0x7585300351ULL,
+  0x67febea716ULL, 0xff0c022977ULL, 0x1e49d33ef4ULL, 0x86bb6fb095ULL,
+  0x24a109120aULL, 0xbc53b59c6bULL, 0x5d16648be8ULL, 0xc5e4d80589ULL,
+  0xd79f56a1ceULL, 0x4f6dea2fafULL, 0xae283b382cULL, 0x36da87b64dULL,
+  0x8a8fa2f0a2ULL, 0x127d1e7ec3ULL, 0xf338cf6940ULL, 0x6bca73e721ULL,
+  0x79b1fd4366ULL, 0xe14341cd07ULL, 0x000690da84ULL, 0x98f42c54e5ULL,
+  0xdbb349c9a9ULL, 0x4341f547c8ULL, 0xa20424504bULL, 0x3af698de2aULL,
+  0x288d167a6dULL, 0xb07faaf40cULL, 0x513a7be38fULL, 0xc9c8c76deeULL,
+  0x759de22b01ULL, 0xed6f5ea560ULL, 0x0c2a8fb2e3ULL, 0x94d8333c82ULL,
+  0x86a3bd98c5ULL, 0x1e510116a4ULL, 0xff14d00127ULL, 0x67e66c8f46ULL,
+  0xc5fc0a2dd9ULL, 0x5d0eb6a3b8ULL, 0xbc4b67b43bULL, 0x24b9db3a5aULL,
+  0x36c2559e1dULL, 0xae30e9107cULL, 0x4f753807ffULL, 0xd78784899eULL,
+  0x6bd2a1cf71ULL, 0xf3201d4110ULL, 0x1265cc5693ULL, 0x8a9770d8f2ULL,
+  0x98ecfe7cb5ULL, 0x001e42f2d4ULL, 0xe15b93e557ULL, 0x79a92f6b36ULL,
+  0xed75f0d8abULL, 0x75874c56caULL, 0x94c29d4149ULL, 0x0c3021cf28ULL,
+  0x1e4baf6b6fULL, 0x86b913e50eULL, 0x67fcc2f28dULL, 0xff0e7e7cecULL,
+  0x435b5b3a03ULL, 0xdba9e7b462ULL, 0x3aec36a3e1ULL, 0xa21e8a2d80ULL,
+  0xb0650489c7ULL, 0x2897b807a6ULL, 0xc9d2691025ULL, 0x5120d59e44ULL,
+  0xf33ab33cdbULL, 0x6bc80fb2baULL, 0x8a8ddea539ULL, 0x127f622b58ULL,
+  0x0004ec8f1fULL, 0x98f650017eULL, 0x79b38116fdULL, 0xe1413d989cULL,
+  0x5d1418de73ULL, 0xc5e6a45012ULL, 0x24a3754791ULL, 0xbc51c9c9f0ULL,
+  0xae2a476db7ULL, 0x36d8fbe3d6ULL, 0xd79d2af455ULL, 0x4f6f967a34ULL,
+  0x0c28f3e778ULL, 0x94da4f6919ULL, 0x759f9e7e9aULL, 0xed6d22f0fbULL,
+  0xff16ac54bcULL, 0x67e410daddULL, 0x86a1c1cd5eULL, 0x1e537d433fULL,
+  0xa2065805d0ULL, 0x3af4e48bb1ULL, 0xdbb1359c32ULL, 0x4343891253ULL,
+  0x513807b614ULL, 0xc9cabb3875ULL, 0x288f6a2ff6ULL, 0xb07dd6a197ULL,
+  0x1267b00308ULL, 0x8a950c8d69ULL, 0x6bd0dd9aeaULL, 0xf32261148bULL,
+  0xe159efb0ccULL, 0x79ab533eadULL, 0x98ee82292eULL, 0x001c3ea74fULL,
+  0xbc491be1a0ULL, 0x24bba76fc1ULL, 0xc5fe767842ULL, 0x5d0ccaf623ULL,
+  0x4f77445264ULL, 0xd785f8dc05ULL, 0x36c029cb86ULL, 0xae329545e7ULL,
+  0x67cd66a204ULL, 0xff3fda2c65ULL, 0x1e7a0b3be6ULL, 0x8688b7b587ULL,
+  0x94f33911c0ULL, 0x0c01859fa1ULL, 0xed44548822ULL, 0x75b6e80643ULL,
+  0xc9e3cd40acULL, 0x511171cecdULL, 0xb054a0d94eULL, 0x28a61c572fULL,
+  0x3add92f368ULL, 0xa22f2e7d09ULL, 0x436aff6a8aULL, 0xdb9843e4ebULL,
+  0x7982254674ULL, 0xe17099c815ULL, 0x003548df96ULL, 0x98c7f451f7ULL,
+  0x8abc7af5b0ULL, 0x124ec67bd1ULL, 0xf30b176c52ULL, 0x6bf9abe233ULL,
+  0xd7ac8ea4dcULL, 0x4f5e322abdULL, 0xae1be33d3eULL, 0x36e95fb35fULL,
+  0x2492d11718ULL, 0xbc606d9979ULL, 0x5d25bc8efaULL, 0xc5d700009bULL,
+  0x8690659dd7ULL, 0x1e62d913b6ULL, 0xff27080435ULL, 0x67d5b48a54ULL,
+  0x75ae3a2e13ULL, 0xed5c86a072ULL, 0x0c1957b7f1ULL, 0x94ebeb3990ULL,
+  0x28bece7f7fULL, 0xb04c72f11eULL, 0x5109a3e69dULL, 0xc9fb1f68fcULL,
+  0xdb8091ccbbULL, 0x43722d42daULL, 0xa237fc5559ULL, 0x3ac540db38ULL,
+  0x98df2679a7ULL, 0x002d9af7c6ULL, 0xe1684be045ULL, 0x799af76e24ULL,
+  0x6be179ca63ULL, 0xf313c54402ULL, 0x1256145381ULL, 0x8aa4a8dde0ULL,
+  0x36f18d9b0fULL, 0xae0331156eULL, 0x4f46e002edULL, 0xd7b45c8c8cULL,
+  0xc5cfd228cbULL, 0x5d3d6ea6aaULL, 0xbc78bfb129ULL, 0x248a033f48ULL,
+  0x28adad9983ULL, 0xb05f1117e2ULL, 0x511ac00061ULL, 0xc9e87c8e00ULL,
+  0xdb93f22a47ULL, 0x43614ea426ULL, 0xa2249fb3a5ULL, 0x3ad6233dc4ULL,
+  0x8683067b2bULL, 0x1e71baf54aULL, 0xff346be2c9ULL, 0x67c6d76ca8ULL,
+  0x75bd59c8efULL, 0xed4fe5468eULL, 0x0c0a34510dULL, 0x94f888df6cULL,
+  0x36e2ee7df3ULL, 0xae1052f392ULL, 0x4f5583e411ULL, 0xd7a73f6a70ULL,
+  0xc5dcb1ce37ULL, 0x5d2e0d4056ULL, 0xbc6bdc57d5ULL, 0x249960d9b4ULL,
+  0x98cc459f5bULL, 0x003ef9113aULL, 0xe17b2806b9ULL, 0x79899488d8ULL,
+  0x6bf21a2c9fULL, 0xf300a6a2feULL, 0x124577b57dULL, 0x8ab7cb3b1cULL,
+  0xc9f0aea650ULL, 0x5102122831ULL, 0xb047c33fb2ULL, 0x28b57fb1d3ULL,
+  0x3acef11594ULL, 0xa23c4d9bf5ULL, 0x43799c8c76ULL, 0xdb8b200217ULL,
+  0x67de0544f8ULL, 0xff2cb9ca99ULL, 0x1e6968dd1aULL, 0x869bd4537bULL,
+  0x94e05af73cULL, 0x0c12e6795dULL, 0xed57376edeULL, 0x75a58be0bfULL,
+  0xd7bfed4220ULL, 0x4f4d51cc41ULL, 0xae0880dbc2ULL, 0x36fa3c55a3ULL,
+  0x2481b2f1e4ULL, 0xbc730e7f85ULL, 0x5d36df6806ULL, 0xc5c463e667ULL,
+  0x799146a088ULL, 0xe163fa2ee9ULL, 0x00262b396aULL, 0x98d497b70bULL,
+  0x8aaf19134cULL, 0x125da59d2dULL, 0xf318748aaeULL, 0x6beac804cfULL,
+  0xa2153be32cULL, 0x3ae7876d4dULL, 0xdba2567aceULL, 0x4350eaf4afULL,
+  0x512b6450e8ULL, 0xc9d9d8de89ULL, 0x289c09c90aULL, 0xb06eb5476bULL,
+  0x0c3b900184ULL, 0x94c92c8fe5ULL, 0x758cfd9866ULL, 0xed7e411607ULL,
+  0xff05cfb240ULL, 0x67f7733c21ULL, 0x86b2a22ba2ULL, 0x1e401ea5c3ULL,
+  0xbc5a78075cULL, 0x24a8c4893dULL, 0xc5ed159ebeULL, 0x5d1fa910dfULL,
+  0x4f6427b498ULL, 0xd7969b3af9ULL, 0x36d34a2d7aULL, 0xae21f6a31bULL,
+  0x1274d3e5f4ULL, 0x8a866f6b95ULL, 0x6bc3be7c16ULL, 0xf33102f277ULL,
+  0xe14a8c5630ULL, 0x79b830d851ULL, 0x98fde1cfd2ULL, 0x000f5d41b3ULL,
+  0x434838dcffULL, 0xdbba84529eULL, 0x3aff55451dULL, 0xa20de9cb7cULL,
+  0xb076676f3bULL, 0x2884dbe15aULL, 0xc9c10af6d9ULL, 0x5133b678b8ULL,
+  0xed66933e57ULL, 0x75942fb036ULL, 0x94d1fea7b5ULL, 0x0c234229d4ULL,
+  0x1e58cc8d93ULL, 0x86aa7003f2ULL, 0x67efa11471ULL, 0xff1d1d9a10ULL,
+  0x5d077b388fULL, 0xc5f5c7b6eeULL, 0x24b016a16dULL, 0xbc42aa2f0cULL,
+  0xae39248b4bULL, 0x36cb98052aULL, 0xd78e4912a9ULL, 0x4f7cf59cc8ULL,
+  0xf329d0da27ULL, 0x6bdb6c5446ULL, 0x8a9ebd43c5ULL, 0x126c01cda4ULL,
+  0x00178f69e3ULL, 0x98e533e782ULL, 0x79a0e2f001ULL, 0xe1525e7e60ULL,
+  0x758e81cdfdULL, 0xed7c3d439cULL, 0x0c39ec541fULL, 0x94cb50da7eULL,
+  0x86b0de7e39ULL, 0x1e4262f058ULL, 0xff07b3e7dbULL, 0x67f50f69baULL,
+  0xdba02a2f55ULL, 0x435296a134ULL, 0xa21747b6b7ULL, 0x3ae5fb38d6ULL,
+  0x289e759c91ULL, 0xb06cc912f0ULL, 0x5129180573ULL, 0xc9dba48b12ULL,
+  0x6bc1c2298dULL, 0xf3337ea7ecULL, 0x1276afb06fULL, 0x8a84133e0eULL,
+  0x98ff9d9a49ULL, 0x000d211428ULL, 0xe148f003abULL, 0x79ba4c8dcaULL,
+  0xc5ef69cb25ULL, 0x5d1dd54544ULL, 0xbc580452c7ULL, 0x24aab8dca6ULL,
+  0x36d13678e1ULL, 0xae238af680ULL, 0x4f665be103ULL, 0xd794e76f62ULL,
+  0x94d382f22eULL, 0x0c213e7c4fULL, 0xed64ef6bccULL, 0x759653e5adULL,
+  0x67eddd41eaULL, 0xff1f61cf8bULL, 0x1e5ab0d808ULL, 0x86a80c5669ULL,
+  0x3afd291086ULL, 0xa20f959ee7ULL, 0x434a448964ULL, 0xdbb8f80705ULL,
+  0xc9c376a342ULL, 0x5131ca2d23ULL, 0xb0741b3aa0ULL, 0x2886a7b4c1ULL,
+  0x8a9cc1165eULL, 0x126e7d983fULL, 0xf32bac8fbcULL, 0x6bd91001ddULL,
+  0x79a29ea59aULL, 0xe150222bfbULL, 0x0015f33c78ULL, 0x98e74fb219ULL,
+  0x24b26af4f6ULL, 0xbc40d67a97ULL, 0x5d05076d14ULL, 0xc5f7bbe375ULL,
+  0xd78c354732ULL, 0x4f7e89c953ULL, 0xae3b58ded0ULL, 0x36c9e450b1ULL,
+  0xff3617b752ULL, 0x67c4ab3933ULL, 0x86817a2eb0ULL, 0x1e73c6a0d1ULL,
+  0x0c08480496ULL, 0x94faf48af7ULL, 0x75bf259d74ULL, 0xed4d991315ULL,
+  0x5118bc55faULL, 0xc9ea00db9bULL, 0x28afd1cc18ULL, 0xb05d6d4279ULL,
+  0xa226e3e63eULL, 0x3ad45f685fULL, 0xdb918e7fdcULL, 0x436332f1bdULL,
+  0xe179545322ULL, 0x798be8dd43ULL, 0x98ce39cac0ULL, 0x003c8544a1ULL,
+  0x12470be0e6ULL, 0x8ab5b76e87ULL, 0x6bf0667904ULL, 0xf302daf765ULL,
+  0x4f57ffb18aULL, 0xd7a5433febULL, 0x36e0922868ULL, 0xae122ea609ULL,
+  0xbc69a0024eULL, 0x249b1c8c2fULL, 0xc5decd9bacULL, 0x5d2c7115cdULL,
+  0x1e6b148881ULL, 0x8699a806e0ULL, 0x67dc791163ULL, 0xff2ec59f02ULL,
+  0xed554b3b45ULL, 0x75a7f7b524ULL, 0x94e226a2a7ULL, 0x0c109a2cc6ULL,
+  0xb045bf6a29ULL, 0x28b703e448ULL, 0xc9f2d2f3cbULL, 0x51006e7daaULL,
+  0x437be0d9edULL, 0xdb895c578cULL, 0x3acc8d400fULL, 0xa23e31ce6eULL,
+  0x0024576cf1ULL, 0x98d6ebe290ULL, 0x79933af513ULL, 0xe161867b72ULL,
+  0xf31a08df35ULL, 0x6be8b45154ULL, 0x8aad6546d7ULL, 0x125fd9c8b6ULL,
+  0xae0afc8e59ULL, 0x36f8400038ULL, 0xd7bd9117bbULL, 0x4f4f2d99daULL,
+  0x5d34a33d9dULL, 0xc5c61fb3fcULL, 0x2483cea47fULL, 0xbc71722a1eULL,
+  0x98fb711556ULL, 0x0009cd9b37ULL, 0xe14c1c8cb4ULL, 0x79bea002d5ULL,
+  0x6bc52ea692ULL, 0xf3379228f3ULL, 0x1272433f70ULL, 0x8a80ffb111ULL,
+  0x36d5daf7feULL, 0xae2766799fULL, 0x4f62b76e1cULL, 0xd7900be07dULL,
+  0xc5eb85443aULL, 0x5d1939ca5bULL, 0xbc5ce8ddd8ULL, 0x24ae5453b9ULL,
+  0x86b432f126ULL, 0x1e468e7f47ULL, 0xff035f68c4ULL, 0x67f1e3e6a5ULL,
+  0x758a6d42e2ULL, 0xed78d1cc83ULL, 0x0c3d00db00ULL, 0x94cfbc5561ULL,
+  0x289a99138eULL, 0xb068259defULL, 0x512df48a6cULL, 0xc9df48040dULL,
+  0xdba4c6a04aULL, 0x43567a2e2bULL, 0xa213ab39a8ULL, 0x3ae117b7c9ULL,
+  0x79a6722a85ULL, 0xe154cea4e4ULL, 0x00111fb367ULL, 0x98e3a33d06ULL,
+  0x8a982d9941ULL, 0x126a911720ULL, 0xf32f4000a3ULL, 0x6bddfc8ec2ULL,
+  0xd788d9c82dULL, 0x4f7a65464cULL, 0xae3fb451cfULL, 0x36cd08dfaeULL,
+  0x24b6867be9ULL, 0xbc443af588ULL, 0x5d01ebe20bULL, 0xc5f3576c6aULL,
+  0x67e931cef5ULL, 0xff1b8d4094ULL, 0x1e5e5c5717ULL, 0x86ace0d976ULL,
+  0x94d76e7d31ULL, 0x0c25d2f350ULL, 0xed6003e4d3ULL, 0x7592bf6ab2ULL,
+  0xc9c79a2c5dULL, 0x513526a23cULL, 0xb070f7b5bfULL, 0x28824b3bdeULL,
+  0x3af9c59f99ULL, 0xa20b7911f8ULL, 0x434ea8067bULL, 0xdbbc14881aULL,
+  0x1243e76ff9ULL, 0x8ab15be198ULL, 0x6bf48af61bULL, 0xf30636787aULL,
+  0xe17db8dc3dULL, 0x798f04525cULL, 0x98cad545dfULL, 0x003869cbbeULL,
+  0xbc6d4c8d51ULL, 0x249ff00330ULL, 0xc5da2114b3ULL, 0x5d289d9ad2ULL,
+  0x4f53133e95ULL, 0xd7a1afb0f4ULL, 0x36e47ea777ULL, 0xae16c22916ULL,
+  0x0c0ca48b89ULL, 0x94fe1805e8ULL, 0x75bbc9126bULL, 0xed49759c0aULL,
+  0xff32fb384dULL, 0x67c047b62cULL, 0x868596a1afULL, 0x1e772a2fceULL,
+  0xa2220f6921ULL, 0x3ad0b3e740ULL, 0xdb9562f0c3ULL, 0x4367de7ea2ULL,
+  0x511c50dae5ULL, 0xc9eeec5484ULL, 0x28ab3d4307ULL, 0xb05981cd66ULL,
+  0xf31ee4502aULL, 0x6bec58de4bULL, 0x8aa989c9c8ULL, 0x125b3547a9ULL,
+  0x0020bbe3eeULL, 0x98d2076d8fULL, 0x7997d67a0cULL, 0xe1656af46dULL,
+  0x5d304fb282ULL, 0xc5c2f33ce3ULL, 0x2487222b60ULL, 0xbc759ea501ULL,
+  0xae0e100146ULL, 0x36fcac8f27ULL, 0xd7b97d98a4ULL, 0x4f4bc116c5ULL,
+  0xed51a7b45aULL, 0x75a31b3a3bULL, 0x94e6ca2db8ULL, 0x0c1476a3d9ULL,
+  0x1e6ff8079eULL, 0x869d4489ffULL, 0x67d8959e7cULL, 0xff2a29101dULL,
+  0x437f0c56f2ULL, 0xdb8db0d893ULL, 0x3ac861cf10ULL, 0xa23add4171ULL,
+  0xb04153e536ULL, 0x28b3ef6b57ULL, 0xc9f63e7cd4ULL, 0x510482f2b5ULL,
+  0xc5d85d4128ULL, 0x5d2ae1cf49ULL, 0xbc6f30d8caULL, 0x249d8c56abULL,
+  0x36e602f2ecULL, 0xae14be7c8dULL, 0x4f516f6b0eULL, 0xd7a3d3e56fULL,
+  0x6bf6f6a380ULL, 0xf3044a2de1ULL, 0x12419b3a62ULL, 0x8ab327b403ULL,
+  0x98c8a91044ULL, 0x003a159e25ULL, 0xe17fc489a6ULL, 0x798d7807c7ULL,
+  0xdb971ea558ULL, 0x4365a22b39ULL, 0xa220733cbaULL, 0x3ad2cfb2dbULL,
+  0x28a941169cULL, 0xb05bfd98fdULL, 0x511e2c8f7eULL, 0xc9ec90011fULL,
+  0x75b9b547f0ULL, 0xed4b09c991ULL, 0x0c0ed8de12ULL, 0x94fc645073ULL,
+  0x8687eaf434ULL, 0x1e75567a55ULL, 0xff30876dd6ULL, 0x67c23be3b7ULL,
+  0x24855e7efbULL, 0xbc77e2f09aULL, 0x5d3233e719ULL, 0xc5c08f6978ULL,
+  0xd7bb01cd3fULL, 0x4f49bd435eULL, 0xae0c6c54ddULL, 0x36fed0dabcULL,
+  0x8aabf59c53ULL, 0x1259491232ULL, 0xf31c9805b1ULL, 0x6bee248bd0ULL,
+  0x7995aa2f97ULL, 0xe16716a1f6ULL, 0x0022c7b675ULL, 0x98d07b3814ULL,
+  0x3aca1d9a8bULL, 0xa238a114eaULL, 0x437d700369ULL, 0xdb8fcc8d08ULL,
+  0xc9f442294fULL, 0x5106fea72eULL, 0xb0432fb0adULL, 0x28b1933eccULL,
+  0x94e4b67823ULL, 0x0c160af642ULL, 0xed53dbe1c1ULL, 0x75a1676fa0ULL,
+  0x67dae9cbe7ULL, 0xff28554586ULL, 0x1e6d845205ULL, 0x869f38dc64ULL,
+  0x4f60cb3b87ULL, 0xd79277b5e6ULL, 0x36d7a6a265ULL, 0xae251a2c04ULL,
+  0xbc5e948843ULL, 0x24ac280622ULL, 0xc5e9f911a1ULL, 0x5d1b459fc0ULL,
+  0xe14e60d92fULL, 0x79bcdc574eULL, 0x98f90d40cdULL, 0x000bb1ceacULL,
+  0x12703f6aebULL, 0x8a8283e48aULL, 0x6bc752f309ULL, 0xf335ee7d68ULL,
+  0x512f88dff7ULL, 0xc9dd345196ULL, 0x2898e54615ULL, 0xb06a59c874ULL,
+  0xa211d76c33ULL, 0x3ae36be252ULL, 0xdba6baf5d1ULL, 0x4354067bb0ULL,
+  0xff01233d5fULL, 0x67f39fb33eULL, 0x86b64ea4bdULL, 0x1e44f22adcULL,
+  0x0c3f7c8e9bULL, 0x94cdc000faULL, 0x7588111779ULL, 0xed7aad9918ULL,
+  0xae3dc80454ULL, 0x36cf748a35ULL, 0xd78aa59db6ULL, 0x4f781913d7ULL,
+  0x5d0397b790ULL, 0xc5f12b39f1ULL, 0x24b4fa2e72ULL, 0xbc4646a013ULL,
+  0x001363e6fcULL, 0x98e1df689dULL, 0x79a40e7f1eULL, 0xe156b2f17fULL,
+  0xf32d3c5538ULL, 0x6bdf80db59ULL, 0x8a9a51ccdaULL, 0x1268ed42bbULL,
+  0xb0728be024ULL, 0x2880376e45ULL, 0xc9c5e679c6ULL, 0x51375af7a7ULL,
+  0x434cd453e0ULL, 0xdbbe68dd81ULL, 0x3afbb9ca02ULL, 0xa209054463ULL,
+  0x1e5c20028cULL, 0x86ae9c8cedULL, 0x67eb4d9b6eULL, 0xff19f1150fULL,
+  0xed627fb148ULL, 0x7590c33f29ULL, 0x94d51228aaULL, 0x0c27aea6cbULL
+};
+
+static bool
+bch_cashaddr_mixed(const char *str) {
+  bool lower = false;
+  bool upper = false;
+
+  for (; *str; str++) {
+    if (*str >= 'a' && *str <= 'z')
+      lower = true;
+    else if (*str >= 'A' && *str <= 'Z')
+      upper = true;
+  }
+
+  return lower && upper;
+}
+
+static uint64_t
+bch_cashaddr_polymod(uint64_t c, const uint8_t *data, size_t data_len) {
+  while (data_len >= 2) {
+    c = ((c & 0x3fffffff) << 10)
+      ^ ((uint64_t)data[0] << 5)
+      ^ data[1]
+      ^ bch_cashaddr_table10[c >> 30];
+    data += 2;
+    data_len -= 2;
+  }
+
+  if (data_len)
+    c = ((c & 0x07ffffffff) << 5) ^ data[0] ^ bch_cashaddr_table5[c >> 35];
+
+  return c;
+}
+
+static int
+bch_cashaddr_size_bits(size_t hash_len) {
+  switch (hash_len) {
+    case 20:
+      return 0;
+    case 24:
+      return 1;
+    case 28:
+      return 2;
+    case 32:
+      return 3;
+    case 40:
+      return 4;
+    case 48:
+      return 5;
+    case 56:
+      return 6;
+    case 64:
+      return 7;
+    default:
+      return -1;
+  }
+}
+
+// Validate and lowercase a prefix into `out`, returning
+// the polymod state after the prefix and separator.
+static bool
+bch_cashaddr_prefix(
+  const char *prefix,
+  size_t prefix_len,
+  char *out,
+  uint64_t *state
+) {
+  uint8_t syms[BCH_CASHADDR_MAX_PREFIX + 1];
+  bool lower = false;
+  bool upper = false;
+  size_t i;
+
+  if (prefix_len == 0 || prefix_len > BCH_CASHADDR_MAX_PREFIX)
+    return false;
+
+  for (i = 0; i < prefix_len; i++) {
+    char ch = prefix[i];
+
+    if (ch < 33 || ch > 126 || ch == ':')
+      return false;
+
+    if (ch >= 'a' && ch <= 'z')
+      lower = true;
+
+    if (ch >= 'A' && ch <= 'Z') {
+      upper = true;
+      ch += 32;
+    }
+
+    out[i] = ch;
+    syms[i] = ch & 0x1f;
+  }
+
+  if (lower && upper)
+    return false;
+
+  out[prefix_len] = '\0';
+  syms[prefix_len] = 0;
+
+  *state = bch_cashaddr_polymod(1, syms, prefix_len + 1);
+
+  return true;
+}
+
+static char *
+bch_cashaddr_encode_payload(
+  char *out,
+  uint64_t state,
+  int type,
+  const uint8_t *hash,
+  size_t hash_len,
+  int size_bits
+) {
+  static const uint8_t zero[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+  uint8_t syms[BCH_CASHADDR_MAX_DATA + 8];
+  uint32_t acc = ((uint32_t)type << 3) | (uint32_t)size_bits;
+  int bits = 8;
+  size_t n = 0;
+  size_t i;
+
+  for (i = 0; i < hash_len; i++) {
+    acc = (acc << 8) | hash[i];
+    bits += 8;
+
+    while (bits >= 5) {
+      bits -= 5;
+      syms[n++] = (acc >> bits) & 31;
+    }
+  }
+
+  if (bits > 0)
+    syms[n++] = (acc << (5 - bits)) & 31;
+
+  state = bch_cashaddr_polymod(state, syms, n);
+  state = bch_cashaddr_polymod(state, zero, 8) ^ 1;
+
+  for (i = 0; i < 8; i++)
+    syms[n++] = (state >> (5 * (7 - i))) & 31;
+
+  for (i = 0; i < n; i++)
+    *out++ = bch_cashaddr_charset[syms[i]];
+
+  *out = '\0';
+
+  return out;
+}
+
+bool
+bch_cashaddr_encode(
+  char *output,
+  const char *prefix,
+  int type,
+  const uint8_t *hash,
+  size_t hash_len
+) {
+  assert(output && "output is null");
+  assert(prefix && "prefix is null");
+  assert(hash && "hash is null");
+
+  size_t prefix_len = strlen(prefix);
+  int size_bits = bch_cashaddr_size_bits(hash_len);
+  uint64_t state;
+
+  if (type < 0 || type > 15 || size_bits < 0)
+    return false;
+
+  if (!bch_cashaddr_prefix(prefix, prefix_len, output, &state))
+    return false;
+
+  output[prefix_len] = ':';
+
+  bch_cashaddr_encode_payload(
+    &output[prefix_len + 1],
+    state,
+    type,
+    hash,
+    hash_len,
+    size_bits
+  );
+
+  return true;
+}
+
+static bool
+bch_cashaddr_decode_payload(
+  int *type,
+  uint8_t *hash,
+  size_t *hash_len,
+  uint64_t state,
+  const char *addr,
+  size_t addr_len
+) {
+  uint8_t syms[BCH_CASHADDR_MAX_DATA + 8];
+  uint32_t acc = 0;
+  int bits = 0;
+  size_t n = 0;
+  size_t i;
+  int version = -1;
+
+  if (addr_len < 8 + 2 || addr_len > BCH_CASHADDR_MAX_DATA + 8)
+    return false;
+
+  for (i = 0; i < addr_len; i++) {
+    int ch = (uint8_t)addr[i];
+    int v;
+
+    if (ch > 127 || (v = bch_cashaddr_rev[ch]) == -1)
+      return false;
+
+    syms[i] = (uint8_t)v;
+  }
+
+  if (bch_cashaddr_polymod(state, syms, addr_len) != 1)
+    return false;
+
+  addr_len -= 8;
+
+  for (i = 0; i < addr_len; i++) {
+    acc = (acc << 5) | syms[i];
+    bits += 5;
+
+    if (bits >= 8) {
+      bits -= 8;
+
+      uint8_t byte = (acc >> bits) & 0xff;
+
+      if (version == -1)
+        version = byte;
+      else
+        hash[n++] = byte;
+    }
+  }
+
+  // No more than four bits of zero padding.
+  if (bits >= 5 || ((acc << (8 - bits)) & 0xff) != 0)
+    return false;
+
+  if (version == -1 || (version & 0x80))
+    return false;
+
+  if (bch_cashaddr_size_bits(n) != (version & 7))
+    return false;
+
+  *type = (version >> 3) & 15;
+  *hash_len = n;
+
+  return true;
+}
+
+bool
+bch_cashaddr_decode(
+  int *type,
+  uint8_t *hash,
+  size_t *hash_len,
+  char *prefix,
+  const char *default_prefix,
+  const char *addr
+) {
+  assert(type && "type is null");
+  assert(hash && "hash is null");
+  assert(hash_len && "hash_len is null");
+  assert(prefix && "prefix is null");
+  assert(default_prefix && "default_prefix is null");
+  assert(addr && "addr is null");
+
+  const char *sep = strrchr(addr, ':');
+  const char *pre = default_prefix;
+  size_t pre_len = strlen(default_prefix);
+  uint64_t state;
+
+  if (bch_cashaddr_mixed(addr))
+    return false;
+
+  if (sep) {
+    pre = addr;
+    pre_len = sep - addr;
+    addr = sep + 1;
+  }
+
+  if (!bch_cashaddr_prefix(pre, pre_len, prefix, &state))
+    return false;
+
+  return bch_cashaddr_decode_payload(
+    type,
+    hash,
+    hash_len,
+    state,
+    addr,
+    strlen(addr)
+  );
+}
+
+/*
+ * Batch
+ *
+ * The prefix contribution to the checksum is the same
+ * for every address, so it is computed once per call.
+ */
+
+bool
+bch_cashaddr_encode_batch(
+  char *out,
+  size_t stride,
+  const char *prefix,
+  int type,
+  const uint8_t (*hashes)[20],
+  size_t len
+) {
+  assert(out && "out is null");
+  assert(prefix && "prefix is null");
+  assert((hashes || len == 0) && "hashes is null");
+
+  char lower[BCH_CASHADDR_MAX_PREFIX + 1];
+  size_t prefix_len = strlen(prefix);
+  uint64_t state;
+  size_t i;
+
+  if (type < 0 || type > 15)
+    return false;
+
+  if (!bch_cashaddr_prefix(prefix, prefix_len, lower, &state))
+    return false;
+
+  // prefix + ':' + 42 symbols + '\0'
+  if (stride < prefix_len + 44)
+    return false;
+
+  for (i = 0; i < len; i++) {
+    char *p = &out[i * stride];
+
+    memcpy(p, lower, prefix_len);
+    p[prefix_len] = ':';
+
+    bch_cashaddr_encode_payload(
+      &p[prefix_len + 1],
+      state,
+      type,
+      hashes[i],
+      20,
+      0
+    );
+  }
+
+  return true;
+}
+
+size_t
+bch_cashaddr_decode_batch(
+  int *types,
+  uint8_t (*hashes)[20],
+  bool *valid,
+  const char *prefix,
+  const char **addrs,
+  size_t len
+) {
+  assert(types && "types is null");
+  assert(hashes && "hashes is null");
+  assert(valid && "valid is null");
+  assert(prefix && "prefix is null");
+  assert((addrs || len == 0) && "addrs is null");
+
+  char lower[BCH_CASHADDR_MAX_PREFIX + 1];
+  uint8_t hash[64];
+  size_t prefix_len = strlen(prefix);
+  size_t count = 0;
+  uint64_t state;
+  size_t i;
+
+  if (!bch_cashaddr_prefix(prefix, prefix_len, lower, &state)) {
+    memset(valid, 0, len * sizeof(bool));
+    return 0;
+  }
+
+  for (i = 0; i < len; i++) {
+    const char *addr = addrs[i];
+    size_t hash_len;
+
+    valid[i] = false;
+
+    if (bch_cashaddr_mixed(addr))
+      continue;
+
+    // An explicit prefix must match (in either case).
+    if (strchr(addr, ':')) {
+      size_t j;
+
+      for (j = 0; j < prefix_len; j++) {
+        char ch = addr[j];
+
+        if (ch >= 'A' && ch <= 'Z')
+          ch += 32;
+
+        if (ch != lower[j])
+          break;
+      }
+
+      if (j < prefix_len || addr[prefix_len] != ':')
+        continue;
+
+      addr += prefix_len + 1;
+    }
+
+    if (!bch_cashaddr_decode_payload(&types[i], hash, &hash_len,
+                                     state, addr, strlen(addr))) {
+      continue;
+    }
+
+    if (hash_len != 20)
+      continue;
+
+    memcpy(hashes[i], hash, 20);
+
+    valid[i] = true;
+    count += 1;
+  }
+
+  return count;
+}
@@ -2,6 +2,14 @@
 #define _BCH_CASHADDR_H
 
 #include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define BCH_CASHADDR_MAX_PREFIX 83
+#define BCH_CASHADDR_MAX_DATA 104
+
+// prefix + ':' + payload + checksum + '\0'
+#define BCH_CASHADDR_MAX_SIZE (BCH_CASHADDR_MAX_PREFIX + BCH_CASHADDR_MAX_DATA + 10)
 
 bool
 bch_cashaddr_encode(
@@ -21,4 +29,24 @@ bch_cashaddr_decode(
   const char *default_prefix,
   const char *addr
 );
+
+bool
+bch_cashaddr_encode_batch(
+  char *out,
+  size_t stride,
+  const char *prefix,
+  int type,
+  const uint8_t (*hashes)[20],
+  size_t len
+);
+
+size_t
+bch_cashaddr_decode_batch(
+  int *types,
+  uint8_t (*hashes)[20],
+  bool *valid,
+  const char *prefix,
+  const char **addrs,
+  size_t len
+);
 #endif
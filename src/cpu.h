@@ -0,0 +1,83 @@
+#ifndef _BCH_CPU_H
+#define _BCH_CPU_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BCH_CPU_X86
+#include <cpuid.h>
+#endif
+
+/*
+ * Runtime CPU feature detection.
+ */
+
+#ifdef BCH_CPU_X86
+static inline uint64_t
+bch_cpu_xgetbv(void) {
+  uint32_t eax, edx;
+  __asm__ __volatile__("xgetbv" : "=a" (eax), "=d" (edx) : "c" (0));
+  return ((uint64_t)edx << 32) | eax;
+}
+#endif
+
+static inline bool
+bch_cpu_has_sse41(void) {
+#ifdef BCH_CPU_X86
+  uint32_t eax, ebx, ecx, edx;
+
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+    return false;
+
+  return (ecx >> 19) & 1;
+#else
+  return false;
+#endif
+}
+
+static inline bool
+bch_cpu_has_avx2(void) {
+#ifdef BCH_CPU_X86
+  uint32_t eax, ebx, ecx, edx;
+
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+    return false;
+
+  // The OS must save the ymm registers (OSXSAVE + XCR0).
+  if (!((ecx >> 27) & 1))
+    return false;
+
+  if ((bch_cpu_xgetbv() & 6) != 6)
+    return false;
+
+  if (__get_cpuid_max(0, NULL) < 7)
+    return false;
+
+  __cpuid_count(7, 0, eax, ebx, ecx, edx);
+
+  return (ebx >> 5) & 1;
+#else
+  return false;
+#endif
+}
+
+static inline bool
+bch_cpu_has_sha(void) {
+#ifdef BCH_CPU_X86
+  uint32_t eax, ebx, ecx, edx;
+
+  if (!bch_cpu_has_sse41())
+    return false;
+
+  if (__get_cpuid_max(0, NULL) < 7)
+    return false;
+
+  __cpuid_count(7, 0, eax, ebx, ecx, edx);
+
+  return (ebx >> 29) & 1;
+#else
+  return false;
+#endif
+}
+#endif
@@ -0,0 +1,416 @@
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ectable.h"
+#include "hash.h"
+#include "secp256k1/secp256k1.h"
+
+#define BCH_ECTABLE_MAGIC 0x47484342 // "BCHG"
+
+// Keeps the table on its own cache lines.
+#define BCH_ECTABLE_HEADER_SIZE 64
+
+// How long to wait for another process to finish
+// building (window 24 takes a few seconds).
+#define BCH_ECTABLE_WAIT_MS 60000
+
+// How long an unfinished segment may go without a
+// builder holding its lock before it is rebuilt.
+#define BCH_ECTABLE_STALE_MS 100
+
+#define BCH_ECTABLE_OK 0
+#define BCH_ECTABLE_FAIL 1
+#define BCH_ECTABLE_STALE 2
+
+typedef struct bch_ectable_header_s {
+  uint32_t magic;
+  uint32_t window;
+  uint64_t size;
+  // SHA-256 of the table.
+  uint8_t digest[32];
+  // Set last by the builder.
+  atomic_uint ready;
+} bch_ectable_header_t;
+
+static bool
+bch_ectable_name(char *out, size_t out_len, const char *name, int window) {
+  int len = snprintf(out, out_len, "%s-%d", name, window);
+  return len > 0 && (size_t)len < out_len;
+}
+
+static void
+bch_ectable_sleep(void) {
+  struct timespec ts = { 0, 1000000 };
+  nanosleep(&ts, NULL);
+}
+
+void
+bch_ectable_init(bch_ectable_t *ectable) {
+  assert(ectable && "ectable is null");
+
+  ectable->map = NULL;
+  ectable->map_size = 0;
+  ectable->table = NULL;
+  ectable->window = 0;
+}
+
+// Called with the builder lock held.
+static bool
+bch_ectable_build(
+  const hsk_secp256k1_context *ctx,
+  int fd,
+  size_t map_size,
+  int window,
+  size_t size
+) {
+  bch_ectable_header_t *header;
+  uint8_t *map;
+  bool ok;
+
+  if (ftruncate(fd, map_size) != 0)
+    return false;
+
+  map = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+  if (map == MAP_FAILED)
+    return false;
+
+  header = (bch_ectable_header_t *)map;
+  header->magic = BCH_ECTABLE_MAGIC;
+  header->window = (uint32_t)window;
+  header->size = size;
+
+  ok = hsk_secp256k1_ecmult_window_table_build(ctx,
+    map + BCH_ECTABLE_HEADER_SIZE, window) == 1;
+
+  if (ok) {
+    bch_hash_sha256(map + BCH_ECTABLE_HEADER_SIZE, size, header->digest);
+    atomic_store_explicit(&header->ready, 1, memory_order_release);
+  }
+
+  munmap(map, map_size);
+
+  return ok;
+}
+
+// Only trust a segment that this user owns and
+// nobody else can write.
+static bool
+bch_ectable_owned(int fd) {
+  struct stat st;
+
+  if (fstat(fd, &st) != 0)
+    return false;
+
+  if (st.st_uid != geteuid())
+    return false;
+
+  return (st.st_mode & (S_IWGRP | S_IWOTH)) == 0;
+}
+
+// Waits for the builder to finish. A segment that
+// stays unfinished while nobody holds the builder
+// lock was left by a crashed process.
+static int
+bch_ectable_wait(int fd, size_t map_size, uint8_t **out) {
+  const bch_ectable_header_t *header;
+  uint8_t *map = NULL;
+  int unlocked = 0;
+  struct stat st;
+  int i;
+
+  for (i = 0; i < BCH_ECTABLE_WAIT_MS; i++) {
+    if (fstat(fd, &st) != 0)
+      break;
+
+    if ((size_t)st.st_size != map_size && st.st_size != 0)
+      break;
+
+    if (!map && (size_t)st.st_size == map_size) {
+      map = mmap(NULL, map_size, PROT_READ, MAP_SHARED, fd, 0);
+
+      if (map == MAP_FAILED) {
+        map = NULL;
+        break;
+      }
+    }
+
+    if (map) {
+      header = (const bch_ectable_header_t *)map;
+
+      if (atomic_load_explicit((atomic_uint *)&header->ready,
+                               memory_order_acquire)) {
+        *out = map;
+        return BCH_ECTABLE_OK;
+      }
+    }
+
+    if (flock(fd, LOCK_SH | LOCK_NB) == 0) {
+      flock(fd, LOCK_UN);
+
+      if (++unlocked >= BCH_ECTABLE_STALE_MS) {
+        if (map)
+          munmap(map, map_size);
+        return BCH_ECTABLE_STALE;
+      }
+    } else {
+      unlocked = 0;
+    }
+
+    bch_ectable_sleep();
+  }
+
+  if (map)
+    munmap(map, map_size);
+
+  return BCH_ECTABLE_FAIL;
+}
+
+// Checks a finished segment against this build and
+// the generator: the digest covers every byte of the
+// table, the spot checks that it holds the right points.
+static bool
+bch_ectable_verify(
+  const hsk_secp256k1_context *ctx,
+  const uint8_t *map,
+  int window,
+  size_t size
+) {
+  const bch_ectable_header_t *header = (const bch_ectable_header_t *)map;
+  uint8_t digest[32];
+
+  if (header->magic != BCH_ECTABLE_MAGIC
+      || header->window != (uint32_t)window
+      || header->size != size) {
+    return false;
+  }
+
+  bch_hash_sha256(map + BCH_ECTABLE_HEADER_SIZE, size, digest);
+
+  if (memcmp(digest, header->digest, 32) != 0)
+    return false;
+
+  return hsk_secp256k1_ecmult_window_table_check(ctx,
+    map + BCH_ECTABLE_HEADER_SIZE, window) == 1;
+}
+
+// Unlinks the segment behind `fd`, but only if `path`
+// still names it. The builder lock serializes this
+// against other processes doing the same, so a fresh
+// segment created in the meantime is left alone.
+static void
+bch_ectable_discard(int fd, const char *path) {
+  struct stat st, cur;
+  int cur_fd;
+
+  // A builder has taken it over.
+  if (flock(fd, LOCK_EX | LOCK_NB) != 0)
+    return;
+
+  if (fstat(fd, &st) == 0) {
+    cur_fd = shm_open(path, O_RDONLY, 0);
+
+    if (cur_fd != -1) {
+      if (fstat(cur_fd, &cur) == 0
+          && cur.st_dev == st.st_dev
+          && cur.st_ino == st.st_ino) {
+        shm_unlink(path);
+      }
+
+      close(cur_fd);
+    }
+  }
+
+  flock(fd, LOCK_UN);
+}
+
+static int
+bch_ectable_attach(
+  bch_ectable_t *ectable,
+  const hsk_secp256k1_context *ctx,
+  const char *path,
+  int window,
+  size_t size
+) {
+  size_t map_size = BCH_ECTABLE_HEADER_SIZE + size;
+  uint8_t *map;
+  int rc;
+  int fd;
+
+  // Exactly one process wins the create and builds,
+  // holding the lock until the table is ready.
+  fd = shm_open(path, O_RDWR | O_CREAT | O_EXCL, 0644);
+
+  if (fd != -1) {
+    // Unlinked before the lock is dropped so that
+    // only our own segment can be removed.
+    if (flock(fd, LOCK_EX) != 0
+        || !bch_ectable_build(ctx, fd, map_size, window, size)) {
+      shm_unlink(path);
+      close(fd);
+      return BCH_ECTABLE_FAIL;
+    }
+
+    flock(fd, LOCK_UN);
+  } else {
+    if (errno != EEXIST)
+      return BCH_ECTABLE_FAIL;
+
+    fd = shm_open(path, O_RDONLY, 0);
+
+    if (fd == -1)
+      return BCH_ECTABLE_FAIL;
+  }
+
+  if (!bch_ectable_owned(fd)) {
+    close(fd);
+    return BCH_ECTABLE_FAIL;
+  }
+
+  rc = bch_ectable_wait(fd, map_size, &map);
+
+  // A segment from a differently configured build, or
+  // with contents that do not match, is treated like a
+  // stale one: replaced rather than left for every
+  // later process to trip over.
+  if (rc == BCH_ECTABLE_OK && !bch_ectable_verify(ctx, map, window, size)) {
+    munmap(map, map_size);
+    rc = BCH_ECTABLE_STALE;
+  }
+
+  if (rc == BCH_ECTABLE_STALE)
+    bch_ectable_discard(fd, path);
+
+  close(fd);
+
+  if (rc != BCH_ECTABLE_OK)
+    return rc;
+
+  ectable->map = map;
+  ectable->map_size = map_size;
+  ectable->table = map + BCH_ECTABLE_HEADER_SIZE;
+  ectable->window = window;
+
+  return BCH_ECTABLE_OK;
+}
+
+// Fallback when the segment cannot be used: a table
+// private to this process, read-only once built.
+static bool
+bch_ectable_private(
+  bch_ectable_t *ectable,
+  const hsk_secp256k1_context *ctx,
+  int window,
+  size_t size
+) {
+  void *map = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+  if (map == MAP_FAILED)
+    return false;
+
+  if (!hsk_secp256k1_ecmult_window_table_build(ctx, map, window)
+      || mprotect(map, size, PROT_READ) != 0) {
+    munmap(map, size);
+    return false;
+  }
+
+  ectable->map = map;
+  ectable->map_size = size;
+  ectable->table = map;
+  ectable->window = window;
+
+  return true;
+}
+
+bool
+bch_ectable_open(bch_ectable_t *ectable, const char *name, int window) {
+  hsk_secp256k1_context *ctx;
+  char path[256];
+  size_t size;
+  bool ok = false;
+  int rc = BCH_ECTABLE_FAIL;
+  int i;
+
+  assert(ectable && "ectable is null");
+  assert(name && "name is null");
+
+  size = hsk_secp256k1_ecmult_window_table_size(window);
+
+  if (size == 0)
+    return false;
+
+  ctx = hsk_secp256k1_context_create(HSK_SECP256K1_CONTEXT_NONE);
+
+  if (!ctx)
+    return false;
+
+  if (bch_ectable_name(path, sizeof(path), name, window)) {
+    // A stale or bad segment is replaced once.
+    for (i = 0; i < 2; i++) {
+      rc = bch_ectable_attach(ectable, ctx, path, window, size);
+
+      if (rc != BCH_ECTABLE_STALE)
+        break;
+    }
+  }
+
+  if (rc == BCH_ECTABLE_OK)
+    ok = true;
+  else
+    ok = bch_ectable_private(ectable, ctx, window, size);
+
+  hsk_secp256k1_context_destroy(ctx);
+
+  return ok;
+}
+
+void
+bch_ectable_close(bch_ectable_t *ectable) {
+  assert(ectable && "ectable is null");
+
+  if (ectable->map)
+    munmap(ectable->map, ectable->map_size);
+
+  bch_ectable_init(ectable);
+}
+
+// The table must stay open until the context
+// and all its clones are destroyed.
+bool
+bch_ectable_apply(const bch_ectable_t *ectable, hsk_secp256k1_context *ctx) {
+  assert(ectable && "ectable is null");
+  assert(ctx && "ctx is null");
+
+  if (!ectable->table)
+    return false;
+
+  return hsk_secp256k1_context_set_ecmult_window(ctx,
+    ectable->window, ectable->table) == 1;
+}
+
+// Removes a stale or mismatched segment. Processes
+// that have it mapped keep their mapping.
+bool
+bch_ectable_unlink(const char *name, int window) {
+  char path[256];
+
+  assert(name && "name is null");
+
+  if (!bch_ectable_name(path, sizeof(path), name, window))
+    return false;
+
+  return shm_unlink(path) == 0;
+}
@@ -0,0 +1,56 @@
+#ifndef _BCH_ECTABLE_H
+#define _BCH_ECTABLE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "secp256k1/secp256k1.h"
+
+/*
+ * Shared verification tables.
+ *
+ * The generator tables used by signature verification grow
+ * as 2^window and are identical in every process. Rather
+ * than have each resolver build and hold its own copy, the
+ * first process to open a named POSIX shared memory segment
+ * builds the tables into it, and every process (including
+ * the builder) then maps it read-only. Later processes skip
+ * the build entirely. The segment outlives the processes
+ * until it is unlinked or the host reboots.
+ *
+ * A segment is only used if it is owned by the effective
+ * user and not writable by group or others, the SHA-256
+ * of the whole table matches the digest the builder
+ * stored, and spot checks of its entries against the
+ * generator pass. A segment owned by someone else makes
+ * the process fall back to a private table. The builder
+ * holds a lock on the segment while it builds, so one left
+ * unfinished by a crashed builder, or one whose contents
+ * fail the checks, is unlinked and rebuilt.
+ */
+
+#define BCH_ECTABLE_NAME "/bch-ecmult"
+
+typedef struct bch_ectable_s {
+  void *map;
+  size_t map_size;
+  const void *table;
+  int window;
+} bch_ectable_t;
+
+void
+bch_ectable_init(bch_ectable_t *ectable);
+
+bool
+bch_ectable_open(bch_ectable_t *ectable, const char *name, int window);
+
+void
+bch_ectable_close(bch_ectable_t *ectable);
+
+bool
+bch_ectable_apply(const bch_ectable_t *ectable, hsk_secp256k1_context *ctx);
+
+bool
+bch_ectable_unlink(const char *name, int window);
+#endif
@@ -0,0 +1,554 @@
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bio.h"
+#include "cpu.h"
+#include "hash.h"
+
+// The vendored secp256k1 SHA-256 is the only one in the tree.
+// Its HMAC and RFC6979 helpers are not needed here.
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-function"
+#endif
+#include "secp256k1/hash_impl.h"
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+
+#if defined(BCH_CPU_X86)
+#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__)
+#define BCH_HASH_VECTOR
+#endif
+
+#define BCH_HASH_SCALAR 0
+#define BCH_HASH_X8 1
+#define BCH_HASH_AVX2 2
+#define BCH_HASH_SHANI 3
+
+// Detected once per process; racing threads
+// all store the same value.
+static atomic_int bch_hash_impl = -1;
+
+static const uint32_t bch_sha256_iv[8] = {
+  0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+  0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+static const uint32_t bch_sha256_k[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+  0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+  0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+  0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+  0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+  0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+  0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+  0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+  0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+/*
+ * Scalar
+ */
+
+void
+bch_hash_sha256(const uint8_t *data, size_t data_len, uint8_t *hash) {
+  assert(hash && "hash is null");
+
+  hsk_secp256k1_sha256 ctx;
+  hsk_secp256k1_sha256_initialize(&ctx);
+  hsk_secp256k1_sha256_write(&ctx, data, data_len);
+  hsk_secp256k1_sha256_finalize(&ctx, hash);
+}
+
+void
+bch_hash_hash256(const uint8_t *data, size_t data_len, uint8_t *hash) {
+  uint8_t tmp[32];
+  bch_hash_sha256(data, data_len, tmp);
+  bch_hash_sha256(tmp, 32, hash);
+}
+
+/*
+ * 8-way
+ *
+ * Eight independent messages are hashed side by side, one per
+ * vector lane. The compiler lowers the vector type to whatever
+ * the target offers (2x SSE2, NEON, or a single AVX2 register
+ * in the AVX2 clone below).
+ */
+
+#ifdef BCH_HASH_VECTOR
+
+typedef uint32_t bch_v8_t __attribute__((vector_size(32)));
+
+#define ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+#define SIG0(x) (ROTR(x, 2) ^ ROTR(x, 13) ^ ROTR(x, 22))
+#define SIG1(x) (ROTR(x, 6) ^ ROTR(x, 11) ^ ROTR(x, 25))
+#define sig0(x) (ROTR(x, 7) ^ ROTR(x, 18) ^ ((x) >> 3))
+#define sig1(x) (ROTR(x, 17) ^ ROTR(x, 19) ^ ((x) >> 10))
+#define CH(x, y, z) ((z) ^ ((x) & ((y) ^ (z))))
+#define MAJ(x, y, z) (((x) & (y)) | ((z) & ((x) | (y))))
+
+static inline __attribute__((always_inline)) void
+bch_sha256_x8_transform(bch_v8_t *s, bch_v8_t *w) {
+  bch_v8_t a = s[0];
+  bch_v8_t b = s[1];
+  bch_v8_t c = s[2];
+  bch_v8_t d = s[3];
+  bch_v8_t e = s[4];
+  bch_v8_t f = s[5];
+  bch_v8_t g = s[6];
+  bch_v8_t h = s[7];
+  int i;
+
+  for (i = 0; i < 64; i++) {
+    bch_v8_t x;
+
+    if (i < 16) {
+      x = w[i];
+    } else {
+      w[i & 15] += sig1(w[(i - 2) & 15])
+                 + w[(i - 7) & 15]
+                 + sig0(w[(i - 15) & 15]);
+      x = w[i & 15];
+    }
+
+    bch_v8_t t1 = h + SIG1(e) + CH(e, f, g) + bch_sha256_k[i] + x;
+    bch_v8_t t2 = SIG0(a) + MAJ(a, b, c);
+
+    h = g;
+    g = f;
+    f = e;
+    e = d + t1;
+    d = c;
+    c = b;
+    b = a;
+    a = t1 + t2;
+  }
+
+  s[0] += a;
+  s[1] += b;
+  s[2] += c;
+  s[3] += d;
+  s[4] += e;
+  s[5] += f;
+  s[6] += g;
+  s[7] += h;
+}
+
+#undef ROTR
+#undef SIG0
+#undef SIG1
+#undef sig0
+#undef sig1
+#undef CH
+#undef MAJ
+
+static inline __attribute__((always_inline)) void
+bch_hash256_80_x8_body(const uint8_t **data, uint8_t **hashes) {
+  uint32_t lanes[16][8];
+  bch_v8_t s[8];
+  bch_v8_t w[16];
+  int i, j;
+
+  // First block: bytes 0-63.
+  for (i = 0; i < 16; i++) {
+    for (j = 0; j < 8; j++)
+      lanes[i][j] = get_u32be(data[j] + i * 4);
+  }
+
+  memcpy(w, lanes, sizeof(w));
+
+  for (i = 0; i < 8; i++)
+    s[i] = (bch_v8_t){ 0 } + bch_sha256_iv[i];
+
+  bch_sha256_x8_transform(s, w);
+
+  // Second block: bytes 64-79 plus padding (640 bits).
+  for (i = 0; i < 4; i++) {
+    for (j = 0; j < 8; j++)
+      lanes[i][j] = get_u32be(data[j] + 64 + i * 4);
+  }
+
+  memcpy(w, lanes, sizeof(bch_v8_t) * 4);
+
+  w[4] = (bch_v8_t){ 0 } + 0x80000000;
+
+  for (i = 5; i < 15; i++)
+    w[i] = (bch_v8_t){ 0 };
+
+  w[15] = (bch_v8_t){ 0 } + 640;
+
+  bch_sha256_x8_transform(s, w);
+
+  // Second hash: the 32 byte digest plus padding (256 bits).
+  for (i = 0; i < 8; i++) {
+    w[i] = s[i];
+    s[i] = (bch_v8_t){ 0 } + bch_sha256_iv[i];
+  }
+
+  w[8] = (bch_v8_t){ 0 } + 0x80000000;
+
+  for (i = 9; i < 15; i++)
+    w[i] = (bch_v8_t){ 0 };
+
+  w[15] = (bch_v8_t){ 0 } + 256;
+
+  bch_sha256_x8_transform(s, w);
+
+  memcpy(lanes, s, sizeof(s));
+
+  for (j = 0; j < 8; j++) {
+    for (i = 0; i < 8; i++)
+      set_u32be(hashes[j] + i * 4, lanes[i][j]);
+  }
+}
+
+static void
+bch_hash256_80_x8(const uint8_t **data, uint8_t **hashes) {
+  bch_hash256_80_x8_body(data, hashes);
+}
+
+#ifdef BCH_CPU_X86
+__attribute__((target("avx2"))) static void
+bch_hash256_80_avx2(const uint8_t **data, uint8_t **hashes) {
+  bch_hash256_80_x8_body(data, hashes);
+}
+#endif
+
+#endif /* BCH_HASH_VECTOR */
+
+/*
+ * SHA-NI
+ */
+
+#if defined(BCH_HASH_VECTOR) && defined(BCH_CPU_X86)
+
+#define QROUND(s0, s1, m, i) do {                                      \
+  __m128i msg_ = _mm_add_epi32((m),                                    \
+    _mm_loadu_si128((const __m128i *)&bch_sha256_k[(i)]));              \
+  (s1) = _mm_sha256rnds2_epu32((s1), (s0), msg_);                      \
+  (s0) = _mm_sha256rnds2_epu32((s0), (s1), _mm_shuffle_epi32(msg_, 0x0e)); \
+} while (0)
+
+#define MSG_A(m0, m1) \
+  ((m0) = _mm_sha256msg1_epu32((m0), (m1)))
+
+#define MSG_C(m0, m1, m2)                                         \
+  ((m2) = _mm_sha256msg2_epu32(                                   \
+    _mm_add_epi32((m2), _mm_alignr_epi8((m1), (m0), 4)), (m1)))
+
+#define MSG_B(m0, m1, m2) do { \
+  MSG_C(m0, m1, m2);           \
+  MSG_A(m0, m1);               \
+} while (0)
+
+// Two independent streams are interleaved to hide
+// the latency of the sha256rnds2 instruction.
+__attribute__((target("sha,sse4.1"))) static void
+bch_sha256_shani_transform2(
+  uint32_t *sa,
+  const uint8_t *ca,
+  uint32_t *sb,
+  const uint8_t *cb
+) {
+  const __m128i mask =
+    _mm_set_epi64x(0x0c0d0e0f08090a0bull, 0x0405060700010203ull);
+  __m128i am0, am1, am2, am3, as0, as1, aso0, aso1;
+  __m128i bm0, bm1, bm2, bm3, bs0, bs1, bso0, bso1;
+  __m128i t1, t2;
+
+  // ABCD/EFGH -> ABEF/CDGH.
+  as0 = _mm_loadu_si128((const __m128i *)sa);
+  as1 = _mm_loadu_si128((const __m128i *)(sa + 4));
+  t1 = _mm_shuffle_epi32(as0, 0xb1);
+  t2 = _mm_shuffle_epi32(as1, 0x1b);
+  as0 = _mm_alignr_epi8(t1, t2, 0x08);
+  as1 = _mm_blend_epi16(t2, t1, 0xf0);
+
+  bs0 = _mm_loadu_si128((const __m128i *)sb);
+  bs1 = _mm_loadu_si128((const __m128i *)(sb + 4));
+  t1 = _mm_shuffle_epi32(bs0, 0xb1);
+  t2 = _mm_shuffle_epi32(bs1, 0x1b);
+  bs0 = _mm_alignr_epi8(t1, t2, 0x08);
+  bs1 = _mm_blend_epi16(t2, t1, 0xf0);
+
+  aso0 = as0;
+  aso1 = as1;
+  bso0 = bs0;
+  bso1 = bs1;
+
+  am0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)ca), mask);
+  bm0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)cb), mask);
+  QROUND(as0, as1, am0, 0);
+  QROUND(bs0, bs1, bm0, 0);
+  am1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(ca + 16)), mask);
+  bm1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(cb + 16)), mask);
+  QROUND(as0, as1, am1, 4);
+  QROUND(bs0, bs1, bm1, 4);
+  MSG_A(am0, am1);
+  MSG_A(bm0, bm1);
+  am2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(ca + 32)), mask);
+  bm2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(cb + 32)), mask);
+  QROUND(as0, as1, am2, 8);
+  QROUND(bs0, bs1, bm2, 8);
+  MSG_A(am1, am2);
+  MSG_A(bm1, bm2);
+  am3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(ca + 48)), mask);
+  bm3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(cb + 48)), mask);
+  QROUND(as0, as1, am3, 12);
+  QROUND(bs0, bs1, bm3, 12);
+  MSG_B(am2, am3, am0);
+  MSG_B(bm2, bm3, bm0);
+  QROUND(as0, as1, am0, 16);
+  QROUND(bs0, bs1, bm0, 16);
+  MSG_B(am3, am0, am1);
+  MSG_B(bm3, bm0, bm1);
+  QROUND(as0, as1, am1, 20);
+  QROUND(bs0, bs1, bm1, 20);
+  MSG_B(am0, am1, am2);
+  MSG_B(bm0, bm1, bm2);
+  QROUND(as0, as1, am2, 24);
+  QROUND(bs0, bs1, bm2, 24);
+  MSG_B(am1, am2, am3);
+  MSG_B(bm1, bm2, bm3);
+  QROUND(as0, as1, am3, 28);
+  QROUND(bs0, bs1, bm3, 28);
+  MSG_B(am2, am3, am0);
+  MSG_B(bm2, bm3, bm0);
+  QROUND(as0, as1, am0, 32);
+  QROUND(bs0, bs1, bm0, 32);
+  MSG_B(am3, am0, am1);
+  MSG_B(bm3, bm0, bm1);
+  QROUND(as0, as1, am1, 36);
+  QROUND(bs0, bs1, bm1, 36);
+  MSG_B(am0, am1, am2);
+  MSG_B(bm0, bm1, bm2);
+  QROUND(as0, as1, am2, 40);
+  QROUND(bs0, bs1, bm2, 40);
+  MSG_B(am1, am2, am3);
+  MSG_B(bm1, bm2, bm3);
+  QROUND(as0, as1, am3, 44);
+  QROUND(bs0, bs1, bm3, 44);
+  MSG_B(am2, am3, am0);
+  MSG_B(bm2, bm3, bm0);
+  QROUND(as0, as1, am0, 48);
+  QROUND(bs0, bs1, bm0, 48);
+  MSG_B(am3, am0, am1);
+  MSG_B(bm3, bm0, bm1);
+  QROUND(as0, as1, am1, 52);
+  QROUND(bs0, bs1, bm1, 52);
+  MSG_C(am0, am1, am2);
+  MSG_C(bm0, bm1, bm2);
+  QROUND(as0, as1, am2, 56);
+  QROUND(bs0, bs1, bm2, 56);
+  MSG_C(am1, am2, am3);
+  MSG_C(bm1, bm2, bm3);
+  QROUND(as0, as1, am3, 60);
+  QROUND(bs0, bs1, bm3, 60);
+
+  as0 = _mm_add_epi32(as0, aso0);
+  as1 = _mm_add_epi32(as1, aso1);
+  bs0 = _mm_add_epi32(bs0, bso0);
+  bs1 = _mm_add_epi32(bs1, bso1);
+
+  // ABEF/CDGH -> ABCD/EFGH.
+  t1 = _mm_shuffle_epi32(as0, 0x1b);
+  t2 = _mm_shuffle_epi32(as1, 0xb1);
+  as0 = _mm_blend_epi16(t1, t2, 0xf0);
+  as1 = _mm_alignr_epi8(t2, t1, 0x08);
+  _mm_storeu_si128((__m128i *)sa, as0);
+  _mm_storeu_si128((__m128i *)(sa + 4), as1);
+
+  t1 = _mm_shuffle_epi32(bs0, 0x1b);
+  t2 = _mm_shuffle_epi32(bs1, 0xb1);
+  bs0 = _mm_blend_epi16(t1, t2, 0xf0);
+  bs1 = _mm_alignr_epi8(t2, t1, 0x08);
+  _mm_storeu_si128((__m128i *)sb, bs0);
+  _mm_storeu_si128((__m128i *)(sb + 4), bs1);
+}
+
+#undef QROUND
+#undef MSG_A
+#undef MSG_B
+#undef MSG_C
+
+static void
+bch_hash256_80_shani(const uint8_t **data, uint8_t **hashes) {
+  uint32_t s[2][8];
+  uint8_t block[2][64];
+  int i, j;
+
+  for (j = 0; j < 2; j++)
+    memcpy(s[j], bch_sha256_iv, sizeof(s[j]));
+
+  bch_sha256_shani_transform2(s[0], data[0], s[1], data[1]);
+
+  // Bytes 64-79 plus padding (640 bits).
+  for (j = 0; j < 2; j++) {
+    memset(block[j], 0, 64);
+    memcpy(block[j], data[j] + 64, 16);
+    block[j][16] = 0x80;
+    set_u64be(block[j] + 56, 640);
+  }
+
+  bch_sha256_shani_transform2(s[0], block[0], s[1], block[1]);
+
+  // The 32 byte digest plus padding (256 bits).
+  for (j = 0; j < 2; j++) {
+    memset(block[j], 0, 64);
+
+    for (i = 0; i < 8; i++)
+      set_u32be(block[j] + i * 4, s[j][i]);
+
+    block[j][32] = 0x80;
+    set_u64be(block[j] + 56, 256);
+
+    memcpy(s[j], bch_sha256_iv, sizeof(s[j]));
+  }
+
+  bch_sha256_shani_transform2(s[0], block[0], s[1], block[1]);
+
+  for (j = 0; j < 2; j++) {
+    for (i = 0; i < 8; i++)
+      set_u32be(hashes[j] + i * 4, s[j][i]);
+  }
+}
+
+#endif
+
+/*
+ * Dispatch
+ */
+
+static int
+bch_hash_detect(void) {
+#if defined(BCH_HASH_VECTOR) && defined(BCH_CPU_X86)
+  if (bch_cpu_has_sha())
+    return BCH_HASH_SHANI;
+
+  if (bch_cpu_has_avx2())
+    return BCH_HASH_AVX2;
+#endif
+
+#ifdef BCH_HASH_VECTOR
+  return BCH_HASH_X8;
+#else
+  return BCH_HASH_SCALAR;
+#endif
+}
+
+static int
+bch_hash_select(void) {
+  int impl = atomic_load_explicit(&bch_hash_impl, memory_order_relaxed);
+
+  if (impl == -1) {
+    impl = bch_hash_detect();
+    atomic_store_explicit(&bch_hash_impl, impl, memory_order_relaxed);
+  }
+
+  return impl;
+}
+
+const char *
+bch_hash_backend(void) {
+  switch (bch_hash_select()) {
+    case BCH_HASH_SHANI:
+      return "sha-ni";
+    case BCH_HASH_AVX2:
+      return "avx2";
+    case BCH_HASH_X8:
+      return "vector";
+    default:
+      return "scalar";
+  }
+}
+
+void
+bch_hash_hash256_80(const uint8_t **data, uint8_t **hashes, size_t len) {
+  assert(data && "data is null");
+  assert(hashes && "hashes is null");
+
+  int impl = bch_hash_select();
+
+#if defined(BCH_HASH_VECTOR) && defined(BCH_CPU_X86)
+  if (impl == BCH_HASH_SHANI) {
+    while (len >= 2) {
+      bch_hash256_80_shani(data, hashes);
+      data += 2;
+      hashes += 2;
+      len -= 2;
+    }
+
+    if (len == 1) {
+      const uint8_t *in[2] = { data[0], data[0] };
+      uint8_t scratch[32];
+      uint8_t *out[2] = { hashes[0], scratch };
+      bch_hash256_80_shani(in, out);
+    }
+
+    return;
+  }
+#endif
+
+#ifdef BCH_HASH_VECTOR
+  if (impl == BCH_HASH_AVX2 || impl == BCH_HASH_X8) {
+    void (*x8)(const uint8_t **, uint8_t **) = bch_hash256_80_x8;
+
+#ifdef BCH_CPU_X86
+    if (impl == BCH_HASH_AVX2)
+      x8 = bch_hash256_80_avx2;
+#endif
+
+    while (len >= 8) {
+      x8(data, hashes);
+      data += 8;
+      hashes += 8;
+      len -= 8;
+    }
+
+    // Pad a short tail with copies of its last
+    // message and throw the extra lanes away.
+    if (len >= 3) {
+      const uint8_t *in[8];
+      uint8_t *out[8];
+      uint8_t scratch[8][32];
+      size_t i;
+
+      for (i = 0; i < 8; i++) {
+        if (i < len) {
+          in[i] = data[i];
+          out[i] = hashes[i];
+        } else {
+          in[i] = data[len - 1];
+          out[i] = scratch[i];
+        }
+      }
+
+      x8(in, out);
+
+      return;
+    }
+  }
+#else
+  (void)impl;
+#endif
+
+  size_t i;
+  for (i = 0; i < len; i++)
+    bch_hash_hash256(data[i], 80, hashes[i]);
+}
@@ -0,0 +1,18 @@
+#ifndef _BCH_HASH_H
+#define _BCH_HASH_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+void
+bch_hash_sha256(const uint8_t *data, size_t data_len, uint8_t *hash);
+
+void
+bch_hash_hash256(const uint8_t *data, size_t data_len, uint8_t *hash);
+
+void
+bch_hash_hash256_80(const uint8_t **data, uint8_t **hashes, size_t len);
+
+const char *
+bch_hash_backend(void);
+#endif
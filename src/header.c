@@ -0,0 +1,263 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bio.h"
+#include "buf.h"
+#include "hash.h"
+#include "header.h"
+#include "u256.h"
+
+#define BCH_HEADER_BATCH 64
+
+static bool
+bch_pow_to_u256(uint32_t bits, bch_u256_t *target) {
+  bch_u256_set_u64(target, 0);
+
+  if (bits == 0)
+    return false;
+
+  // No negatives.
+  if ((bits >> 23) & 1)
+    return false;
+
+  uint32_t exponent = bits >> 24;
+  uint64_t mantissa = bits & 0x7fffff;
+
+  if (exponent <= 3) {
+    target->limbs[0] = mantissa >> (8 * (3 - exponent));
+    return true;
+  }
+
+  uint32_t shift = 8 * (exponent - 3);
+
+  // Overflow.
+  if (shift >= 256 || (shift > 232 && (mantissa >> (256 - shift)) != 0))
+    return false;
+
+  uint32_t limb = shift / 64;
+  uint32_t off = shift % 64;
+
+  target->limbs[limb] = mantissa << off;
+
+  if (off > 40 && limb < 3)
+    target->limbs[limb + 1] = mantissa >> (64 - off);
+
+  return true;
+}
+
+bool
+bch_pow_to_target(uint32_t bits, uint8_t *target) {
+  assert(target && "target is null");
+
+  bch_u256_t t;
+
+  if (!bch_pow_to_u256(bits, &t))
+    return false;
+
+  bch_u256_export(&t, target);
+
+  return true;
+}
+
+bool
+bch_header_get_proof(const bch_header_t *hdr, uint8_t *proof) {
+  assert(hdr && "hdr is null");
+  assert(proof && "proof is null");
+
+  bch_u256_t target, work;
+
+  if (!bch_pow_to_u256(hdr->bits, &target))
+    return false;
+
+  if (!bch_u256_work(&work, &target))
+    return false;
+
+  bch_u256_export(&work, proof);
+
+  return true;
+}
+
+bool
+bch_header_calc_work(bch_header_t *hdr, const bch_header_t *prev) {
+  assert(hdr && "hdr is null");
+
+  bch_u256_t target, work, prev_work;
+
+  if (!bch_pow_to_u256(hdr->bits, &target))
+    return false;
+
+  if (!bch_u256_work(&work, &target))
+    return false;
+
+  if (prev) {
+    bch_u256_import(&prev_work, prev->work);
+    bch_u256_add(&work, &prev_work, &work);
+  }
+
+  bch_u256_export(&work, hdr->work);
+
+  return true;
+}
+
+void
+bch_header_hash_batch(bch_header_t **hdrs, size_t len) {
+  assert(hdrs && "hdrs is null");
+
+  uint8_t raw[BCH_HEADER_BATCH][80];
+  const uint8_t *data[BCH_HEADER_BATCH];
+  uint8_t *hashes[BCH_HEADER_BATCH];
+
+  while (len > 0) {
+    size_t n = len < BCH_HEADER_BATCH ? len : BCH_HEADER_BATCH;
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+      bch_header_encode(hdrs[i], raw[i]);
+      data[i] = raw[i];
+      hashes[i] = hdrs[i]->hash;
+    }
+
+    bch_hash_hash256_80(data, hashes, n);
+
+    for (i = 0; i < n; i++)
+      hdrs[i]->cache = true;
+
+    hdrs += n;
+    len -= n;
+  }
+}
+
+bool
+bch_header_write_buf(const bch_header_t *hdr, bch_buf_t *buf) {
+  assert(hdr && "hdr is null");
+  assert(buf && "buf is null");
+
+  uint8_t *p = bch_buf_reserve(buf, 80);
+
+  if (!p)
+    return false;
+
+  bch_header_encode(hdr, p);
+
+  return true;
+}
+
+bool
+bch_header_view_read(
+  uint8_t **data,
+  size_t *data_len,
+  bch_header_view_t *view
+) {
+  assert(data && "data is null");
+  assert(data_len && "data_len is null");
+  assert(view && "view is null");
+
+  uint8_t *raw;
+
+  if (!slice_bytes(data, data_len, &raw, 80))
+    return false;
+
+  view->raw = raw;
+  view->version = get_u32(&raw[0]);
+  view->prev_block = &raw[4];
+  view->merkle_root = &raw[36];
+  view->time = get_u32(&raw[68]);
+  view->bits = get_u32(&raw[72]);
+  view->nonce = &raw[76];
+
+  return true;
+}
+
+void
+bch_header_view_hash(const bch_header_view_t *view, uint8_t *hash) {
+  assert(view && "view is null");
+  assert(hash && "hash is null");
+
+  bch_hash_hash256(view->raw, 80, hash);
+}
+
+void
+bch_header_view_hash_batch(
+  const bch_header_view_t *views,
+  uint8_t (*hashes)[32],
+  size_t len
+) {
+  assert(views && "views is null");
+  assert(hashes && "hashes is null");
+
+  const uint8_t *data[BCH_HEADER_BATCH];
+  uint8_t *out[BCH_HEADER_BATCH];
+
+  // Hashed straight out of the receive buffer.
+  while (len > 0) {
+    size_t n = len < BCH_HEADER_BATCH ? len : BCH_HEADER_BATCH;
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+      data[i] = views[i].raw;
+      out[i] = hashes[i];
+    }
+
+    bch_hash_hash256_80(data, out, n);
+
+    views += n;
+    hashes += n;
+    len -= n;
+  }
+}
+
+bool
+bch_header_view_verify_pow(const bch_header_view_t *view, const uint8_t *hash) {
+  assert(view && "view is null");
+  assert(hash && "hash is null");
+
+  uint8_t target[32];
+  int i;
+
+  if (!bch_pow_to_target(view->bits, target))
+    return false;
+
+  // The hash is a little endian number,
+  // the target is big endian.
+  for (i = 0; i < 32; i++) {
+    uint8_t a = hash[31 - i];
+    uint8_t b = target[i];
+
+    if (a < b)
+      return true;
+
+    if (a > b)
+      return false;
+  }
+
+  return true;
+}
+
+// Build a full header once the view has passed
+// PoW and contextual checks. `hash` may be NULL.
+void
+bch_header_view_materialize(
+  const bch_header_view_t *view,
+  const uint8_t *hash,
+  bch_header_t *hdr
+) {
+  assert(view && "view is null");
+  assert(hdr && "hdr is null");
+
+  bch_header_init(hdr);
+
+  hdr->version = view->version;
+  memcpy(hdr->prev_block, view->prev_block, 32);
+  memcpy(hdr->merkle_root, view->merkle_root, 32);
+  hdr->time = view->time;
+  hdr->bits = view->bits;
+  memcpy(hdr->nonce, view->nonce, 4);
+
+  if (hash) {
+    memcpy(hdr->hash, hash, 32);
+    hdr->cache = true;
+  }
+}
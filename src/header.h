@@ -4,6 +4,9 @@
 #include <assert.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdlib.h>
+
+#include "buf.h"
 
 typedef struct bch_header_s {
   uint32_t version;
@@ -21,6 +24,19 @@ typedef struct bch_header_s {
   struct bch_header_s *next;
 } bch_header_t;
 
+// Read-only view of a serialized header. The large
+// fields point into the buffer it was read from, which
+// must outlive the view.
+typedef struct bch_header_view_s {
+  const uint8_t *raw;
+  uint32_t version;
+  const uint8_t *prev_block;
+  const uint8_t *merkle_root;
+  uint32_t time;
+  uint32_t bits;
+  const uint8_t *nonce;
+} bch_header_view_t;
+
 void
 bch_header_init(bch_header_t *hdr);
 
@@ -57,6 +73,39 @@ bch_header_size(const bch_header_t *hdr);
 int
 bch_header_encode(const bch_header_t *hdr, uint8_t *data);
 
+void
+bch_header_hash_batch(bch_header_t **hdrs, size_t len);
+
+bool
+bch_header_write_buf(const bch_header_t *hdr, bch_buf_t *buf);
+
+bool
+bch_header_view_read(
+  uint8_t **data,
+  size_t *data_len,
+  bch_header_view_t *view
+);
+
+void
+bch_header_view_hash(const bch_header_view_t *view, uint8_t *hash);
+
+void
+bch_header_view_hash_batch(
+  const bch_header_view_t *views,
+  uint8_t (*hashes)[32],
+  size_t len
+);
+
+bool
+bch_header_view_verify_pow(const bch_header_view_t *view, const uint8_t *hash);
+
+void
+bch_header_view_materialize(
+  const bch_header_view_t *view,
+  const uint8_t *hash,
+  bch_header_t *hdr
+);
+
 void
 bch_header_print(bch_header_t *hdr, const char *prefix);
 #endif
@@ -0,0 +1,596 @@
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "bio.h"
+#include "header.h"
+#include "hindex.h"
+
+#define BCH_HINDEX_MAGIC 0x49484342 // "BCHI"
+
+#define REC_RAW 0
+#define REC_HASH 80
+#define REC_WORK 112
+#define REC_HEIGHT 144
+#define REC_FLAGS 148
+#define REC_CRC 152
+
+#define TIP_SEQ 0
+#define TIP_COUNT 8
+#define TIP_HASH 12
+#define TIP_CRC 44
+
+// Reflected CRC-32 (polynomial 0xedb88320).
+static const uint32_t bch_crc32_table[256] = {
+  0x00000000, 0x77073096, 0xee0e612c, 0x990951ba,
+  0x076dc419, 0x706af48f, 0xe963a535, 0x9e6495a3,
+  0x0edb8832, 0x79dcb8a4, 0xe0d5e91e, 0x97d2d988,
+  0x09b64c2b, 0x7eb17cbd, 0xe7b82d07, 0x90bf1d91,
+  0x1db71064, 0x6ab020f2, 0xf3b97148, 0x84be41de,
+  0x1adad47d, 0x6ddde4eb, 0xf4d4b551, 0x83d385c7,
+  0x136c9856, 0x646ba8c0, 0xfd62f97a, 0x8a65c9ec,
+  0x14015c4f, 0x63066cd9, 0xfa0f3d63, 0x8d080df5,
+  0x3b6e20c8, 0x4c69105e, 0xd56041e4, 0xa2677172,
+  0x3c03e4d1, 0x4b04d447, 0xd20d85fd, 0xa50ab56b,
+  0x35b5a8fa, 0x42b2986c, 0xdbbbc9d6, 0xacbcf940,
+  0x32d86ce3, 0x45df5c75, 0xdcd60dcf, 0xabd13d59,
+  0x26d930ac, 0x51de003a, 0xc8d75180, 0xbfd06116,
+  0x21b4f4b5, 0x56b3c423, 0xcfba9599, 0xb8bda50f,
+  0x2802b89e, 0x5f058808, 0xc60cd9b2, 0xb10be924,
+  0x2f6f7c87, 0x58684c11, 0xc1611dab, 0xb6662d3d,
+  0x76dc4190, 0x01db7106, 0x98d220bc, 0xefd5102a,
+  0x71b18589, 0x06b6b51f, 0x9fbfe4a5, 0xe8b8d433,
+  0x7807c9a2, 0x0f00f934, 0x9609a88e, 0xe10e9818,
+  0x7f6a0dbb, 0x086d3d2d, 0x91646c97, 0xe6635c01,
+  0x6b6b51f4, 0x1c6c6162, 0x856530d8, 0xf262004e,
+  0x6c0695ed, 0x1b01a57b, 0x8208f4c1, 0xf50fc457,
+  0x65b0d9c6, 0x12b7e950, 0x8bbeb8ea, 0xfcb9887c,
+  0x62dd1ddf, 0x15da2d49, 0x8cd37cf3, 0xfbd44c65,
+  0x4db26158, 0x3ab551ce, 0xa3bc0074, 0xd4bb30e2,
+  0x4adfa541, 0x3dd895d7, 0xa4d1c46d, 0xd3d6f4fb,
+  0x4369e96a, 0x346ed9fc, 0xad678846, 0xda60b8d0,
+  0x44042d73, 0x33031de5, 0xaa0a4c5f, 0xdd0d7cc9,
+  0x5005713c, 0x270241aa, 0xbe0b1010, 0xc90c2086,
+  0x5768b525, 0x206f85b3, 0xb966d409, 0xce61e49f,
+  0x5edef90e, 0x29d9c998, 0xb0d09822, 0xc7d7a8b4,
+  0x59b33d17, 0x2eb40d81, 0xb7bd5c3b, 0xc0ba6cad,
+  0xedb88320, 0x9abfb3b6, 0x03b6e20c, 0x74b1d29a,
+  0xead54739, 0x9dd277af, 0x04db2615, 0x73dc1683,
+  0xe3630b12, 0x94643b84, 0x0d6d6a3e, 0x7a6a5aa8,
+  0xe40ecf0b, 0x9309ff9d, 0x0a00ae27, 0x7d079eb1,
+  0xf00f9344, 0x8708a3d2, 0x1e01f268, 0x6906c2fe,
+  0xf762575d, 0x806567cb, 0x196c3671, 0x6e6b06e7,
+  0xfed41b76, 0x89d32be0, 0x10da7a5a, 0x67dd4acc,
+  0xf9b9df6f, 0x8ebeeff9, 0x17b7be43, 0x60b08ed5,
+  0xd6d6a3e8, 0xa1d1937e, 0x38d8c2c4, 0x4fdff252,
+  0xd1bb67f1, 0xa6bc5767, 0x3fb506dd, 0x48b2364b,
+  0xd80d2bda, 0xaf0a1b4c, 0x36034af6, 0x41047a60,
+  0xdf60efc3, 0xa867df55, 0x316e8eef, 0x4669be79,
+  0xcb61b38c, 0xbc66831a, 0x256fd2a0, 0x5268e236,
+  0xcc0c7795, 0xbb0b4703, 0x220216b9, 0x5505262f,
+  0xc5ba3bbe, 0xb2bd0b28, 0x2bb45a92, 0x5cb36a04,
+  0xc2d7ffa7, 0xb5d0cf31, 0x2cd99e8b, 0x5bdeae1d,
+  0x9b64c2b0, 0xec63f226, 0x756aa39c, 0x026d930a,
+  0x9c0906a9, 0xeb0e363f, 0x72076785, 0x05005713,
+  0x95bf4a82, 0xe2b87a14, 0x7bb12bae, 0x0cb61b38,
+  0x92d28e9b, 0xe5d5be0d, 0x7cdcefb7, 0x0bdbdf21,
+  0x86d3d2d4, 0xf1d4e242, 0x68ddb3f8, 0x1fda836e,
+  0x81be16cd, 0xf6b9265b, 0x6fb077e1, 0x18b74777,
+  0x88085ae6, 0xff0f6a70, 0x66063bca, 0x11010b5c,
+  0x8f659eff, 0xf862ae69, 0x616bffd3, 0x166ccf45,
+  0xa00ae278, 0xd70dd2ee, 0x4e048354, 0x3903b3c2,
+  0xa7672661, 0xd06016f7, 0x4969474d, 0x3e6e77db,
+  0xaed16a4a, 0xd9d65adc, 0x40df0b66, 0x37d83bf0,
+  0xa9bcae53, 0xdebb9ec5, 0x47b2cf7f, 0x30b5ffe9,
+  0xbdbdf21c, 0xcabac28a, 0x53b39330, 0x24b4a3a6,
+  0xbad03605, 0xcdd70693, 0x54de5729, 0x23d967bf,
+  0xb3667a2e, 0xc4614ab8, 0x5d681b02, 0x2a6f2b94,
+  0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d
+};
+
+static uint32_t
+bch_crc32(const uint8_t *data, size_t data_len) {
+  uint32_t c = 0xffffffff;
+  size_t i;
+
+  for (i = 0; i < data_len; i++)
+    c = bch_crc32_table[(c ^ data[i]) & 0xff] ^ (c >> 8);
+
+  return c ^ 0xffffffff;
+}
+
+static bool
+bch_hindex_pwrite(int fd, const uint8_t *data, size_t len, off_t off) {
+  while (len > 0) {
+    ssize_t w = pwrite(fd, data, len, off);
+
+    if (w < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+
+    data += w;
+    len -= w;
+    off += w;
+  }
+
+  return true;
+}
+
+static bool
+bch_hindex_pread(int fd, uint8_t *data, size_t len, off_t off) {
+  while (len > 0) {
+    ssize_t r = pread(fd, data, len, off);
+
+    if (r < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+
+    if (r == 0)
+      return false;
+
+    data += r;
+    len -= r;
+    off += r;
+  }
+
+  return true;
+}
+
+static off_t
+bch_hindex_offset(uint32_t i) {
+  return (off_t)BCH_HINDEX_HEADER_SIZE + (off_t)i * BCH_HINDEX_RECORD_SIZE;
+}
+
+static void
+bch_hindex_write_preamble(const bch_hindex_t *idx, uint8_t *data) {
+  memset(data, 0, BCH_HINDEX_PREAMBLE_SIZE);
+  set_u32(data + 0, BCH_HINDEX_MAGIC);
+  set_u32(data + 4, BCH_HINDEX_VERSION);
+  set_u32(data + 8, idx->magic);
+  set_u32(data + 12, idx->start);
+  set_u32(data + 16, BCH_HINDEX_RECORD_SIZE);
+  set_u32(data + 28, bch_crc32(data, 28));
+}
+
+static bool
+bch_hindex_read_tip(
+  const uint8_t *data,
+  uint64_t *seq,
+  uint32_t *count,
+  uint8_t *hash
+) {
+  if (bch_crc32(data, TIP_CRC) != get_u32(data + TIP_CRC))
+    return false;
+
+  *seq = get_u64(data + TIP_SEQ);
+  *count = get_u32(data + TIP_COUNT);
+  memcpy(hash, data + TIP_HASH, 32);
+
+  return true;
+}
+
+static bool
+bch_hindex_write_tip(bch_hindex_t *idx, uint64_t seq, uint32_t count) {
+  uint8_t data[BCH_HINDEX_TIP_SIZE];
+
+  memset(data, 0, sizeof(data));
+  set_u64(data + TIP_SEQ, seq);
+  set_u32(data + TIP_COUNT, count);
+  memcpy(data + TIP_HASH, idx->tip, 32);
+  set_u32(data + TIP_CRC, bch_crc32(data, TIP_CRC));
+
+  off_t off = BCH_HINDEX_PREAMBLE_SIZE + (off_t)(seq & 1) * BCH_HINDEX_TIP_SIZE;
+
+  return bch_hindex_pwrite(idx->fd, data, sizeof(data), off);
+}
+
+// Map enough of the file for `count` records. The
+// old mapping is only replaced once everything has
+// been allocated, so a failure leaves `idx` intact.
+static bool
+bch_hindex_map(bch_hindex_t *idx, uint32_t count) {
+  size_t size = (size_t)bch_hindex_offset(count);
+  size_t checked_size = ((size_t)count + 7) / 8;
+
+  if (checked_size > idx->checked_size) {
+    uint8_t *checked = realloc(idx->checked, checked_size);
+
+    if (!checked)
+      return false;
+
+    memset(checked + idx->checked_size, 0, checked_size - idx->checked_size);
+
+    idx->checked = checked;
+    idx->checked_size = checked_size;
+  }
+
+  if (idx->map && idx->map_size >= size)
+    return true;
+
+  void *map = mmap(NULL, size, PROT_READ, MAP_SHARED, idx->fd, 0);
+
+  if (map == MAP_FAILED)
+    return false;
+
+  if (idx->map)
+    munmap(idx->map, idx->map_size);
+
+  idx->map = (uint8_t *)map;
+  idx->map_size = size;
+
+  return true;
+}
+
+static const uint8_t *
+bch_hindex_check(bch_hindex_t *idx, uint32_t i) {
+  const uint8_t *rec = idx->map + bch_hindex_offset(i);
+
+  if (idx->checked[i >> 3] & (1 << (i & 7)))
+    return rec;
+
+  if (bch_crc32(rec, REC_CRC) != get_u32(rec + REC_CRC))
+    return NULL;
+
+  if (get_u32(rec + REC_HEIGHT) != idx->start + i)
+    return NULL;
+
+  // The header must link to the record below it.
+  if (i > 0) {
+    const uint8_t *prev = idx->map + bch_hindex_offset(i - 1);
+
+    if (memcmp(rec + REC_RAW + 4, prev + REC_HASH, 32) != 0)
+      return NULL;
+  }
+
+  idx->checked[i >> 3] |= 1 << (i & 7);
+
+  return rec;
+}
+
+void
+bch_hindex_init(bch_hindex_t *idx) {
+  assert(idx && "idx is null");
+
+  idx->fd = -1;
+  idx->magic = 0;
+  idx->start = 0;
+  idx->count = 0;
+  idx->pending = 0;
+  idx->seq = 0;
+  memset(idx->tip, 0, 32);
+  idx->map = NULL;
+  idx->map_size = 0;
+  idx->checked = NULL;
+  idx->checked_size = 0;
+}
+
+bool
+bch_hindex_open(
+  bch_hindex_t *idx,
+  const char *path,
+  uint32_t magic,
+  uint32_t start
+) {
+  assert(idx && "idx is null");
+  assert(path && "path is null");
+
+  uint8_t header[BCH_HINDEX_HEADER_SIZE];
+  struct stat st;
+
+  bch_hindex_init(idx);
+
+  idx->magic = magic;
+  idx->start = start;
+
+  idx->fd = open(path, O_RDWR | O_CREAT, 0644);
+
+  if (idx->fd == -1)
+    return false;
+
+  if (fstat(idx->fd, &st) != 0)
+    goto fail;
+
+  if (st.st_size == 0) {
+    memset(header, 0, sizeof(header));
+    bch_hindex_write_preamble(idx, header);
+
+    if (!bch_hindex_pwrite(idx->fd, header, sizeof(header), 0))
+      goto fail;
+
+    if (!bch_hindex_write_tip(idx, 0, 0))
+      goto fail;
+
+    if (fsync(idx->fd) != 0)
+      goto fail;
+
+    st.st_size = sizeof(header);
+  }
+
+  if (st.st_size < (off_t)sizeof(header))
+    goto fail;
+
+  if (!bch_hindex_pread(idx->fd, header, sizeof(header), 0))
+    goto fail;
+
+  uint8_t expect[BCH_HINDEX_PREAMBLE_SIZE];
+  bch_hindex_write_preamble(idx, expect);
+
+  // Wrong network, version or start height.
+  if (memcmp(header, expect, BCH_HINDEX_PREAMBLE_SIZE) != 0)
+    goto fail;
+
+  uint32_t max = (uint32_t)(
+    (st.st_size - BCH_HINDEX_HEADER_SIZE) / BCH_HINDEX_RECORD_SIZE);
+
+  uint64_t seqs[2];
+  uint32_t counts[2];
+  uint8_t hashes[2][32];
+  bool valid[2];
+  int i;
+
+  for (i = 0; i < 2; i++) {
+    const uint8_t *slot = header + BCH_HINDEX_PREAMBLE_SIZE
+                        + i * BCH_HINDEX_TIP_SIZE;
+
+    valid[i] = bch_hindex_read_tip(slot, &seqs[i], &counts[i], hashes[i]);
+
+    // Records past the end of the file
+    // mean the data never hit the disk.
+    if (valid[i] && counts[i] > max)
+      valid[i] = false;
+  }
+
+  // Prefer the newer tip, but fall back to the older
+  // one if the newer tip's records do not check out.
+  int order[2] = { 0, 1 };
+
+  if (valid[0] && valid[1] && seqs[1] > seqs[0]) {
+    order[0] = 1;
+    order[1] = 0;
+  }
+
+  for (i = 0; i < 2; i++) {
+    int s = order[i];
+
+    if (!valid[s])
+      continue;
+
+    if (!bch_hindex_map(idx, counts[s]))
+      goto fail;
+
+    idx->count = counts[s];
+    idx->seq = seqs[s];
+    memcpy(idx->tip, hashes[s], 32);
+
+    if (idx->count == 0)
+      return true;
+
+    const uint8_t *rec = bch_hindex_check(idx, idx->count - 1);
+
+    if (rec && memcmp(rec + REC_HASH, idx->tip, 32) == 0)
+      return true;
+
+    memset(idx->checked, 0, idx->checked_size);
+  }
+
+fail:
+  bch_hindex_close(idx);
+  return false;
+}
+
+void
+bch_hindex_close(bch_hindex_t *idx) {
+  assert(idx && "idx is null");
+
+  if (idx->map)
+    munmap(idx->map, idx->map_size);
+
+  if (idx->checked)
+    free(idx->checked);
+
+  if (idx->fd != -1)
+    close(idx->fd);
+
+  bch_hindex_init(idx);
+}
+
+const uint8_t *
+bch_hindex_record(bch_hindex_t *idx, uint32_t height) {
+  assert(idx && "idx is null");
+
+  if (!bch_hindex_has(idx, height))
+    return NULL;
+
+  return bch_hindex_check(idx, height - idx->start);
+}
+
+const uint8_t *
+bch_hindex_hash(bch_hindex_t *idx, uint32_t height) {
+  const uint8_t *rec = bch_hindex_record(idx, height);
+
+  if (!rec)
+    return NULL;
+
+  return rec + REC_HASH;
+}
+
+const uint8_t *
+bch_hindex_work(bch_hindex_t *idx, uint32_t height) {
+  const uint8_t *rec = bch_hindex_record(idx, height);
+
+  if (!rec)
+    return NULL;
+
+  return rec + REC_WORK;
+}
+
+bool
+bch_hindex_get(bch_hindex_t *idx, uint32_t height, bch_header_t *hdr) {
+  assert(hdr && "hdr is null");
+
+  const uint8_t *rec = bch_hindex_record(idx, height);
+
+  if (!rec)
+    return false;
+
+  if (!bch_header_decode(rec + REC_RAW, 80, hdr))
+    return false;
+
+  hdr->cache = true;
+  memcpy(hdr->hash, rec + REC_HASH, 32);
+  hdr->height = height;
+  memcpy(hdr->work, rec + REC_WORK, 32);
+
+  return true;
+}
+
+bool
+bch_hindex_tip(bch_hindex_t *idx, bch_header_t *hdr) {
+  assert(idx && "idx is null");
+
+  if (idx->count == 0)
+    return false;
+
+  return bch_hindex_get(idx, bch_hindex_end(idx) - 1, hdr);
+}
+
+bool
+bch_hindex_append(bch_hindex_t *idx, const bch_header_t *hdr) {
+  assert(idx && "idx is null");
+  assert(hdr && "hdr is null");
+  assert(idx->fd != -1 && "index is closed");
+
+  uint32_t i = idx->count + idx->pending;
+
+  if (hdr->height != idx->start + i)
+    return false;
+
+  if (!hdr->cache)
+    return false;
+
+  uint8_t rec[BCH_HINDEX_RECORD_SIZE];
+
+  memset(rec, 0, sizeof(rec));
+
+  if (bch_header_encode(hdr, rec + REC_RAW) != 80)
+    return false;
+
+  memcpy(rec + REC_HASH, hdr->hash, 32);
+  memcpy(rec + REC_WORK, hdr->work, 32);
+  set_u32(rec + REC_HEIGHT, hdr->height);
+  set_u32(rec + REC_FLAGS, 0);
+  set_u32(rec + REC_CRC, bch_crc32(rec, REC_CRC));
+
+  if (!bch_hindex_pwrite(idx->fd, rec, sizeof(rec), bch_hindex_offset(i)))
+    return false;
+
+  memcpy(idx->tip, hdr->hash, 32);
+  idx->pending += 1;
+
+  return true;
+}
+
+bool
+bch_hindex_commit(bch_hindex_t *idx) {
+  assert(idx && "idx is null");
+  assert(idx->fd != -1 && "index is closed");
+
+  if (idx->pending == 0)
+    return true;
+
+  // Records must be durable before the tip points at them.
+  if (fsync(idx->fd) != 0)
+    return false;
+
+  uint32_t count = idx->count + idx->pending;
+
+  // Map the new records before publishing them so that
+  // a failed remap cannot leave `count` past the map.
+  if (!bch_hindex_map(idx, count))
+    return false;
+
+  if (!bch_hindex_write_tip(idx, idx->seq + 1, count))
+    return false;
+
+  if (fsync(idx->fd) != 0)
+    return false;
+
+  idx->seq += 1;
+  idx->count = count;
+  idx->pending = 0;
+
+  return true;
+}
+
+bool
+bch_hindex_truncate(bch_hindex_t *idx, uint32_t height) {
+  assert(idx && "idx is null");
+  assert(idx->fd != -1 && "index is closed");
+
+  uint32_t count = 0;
+
+  if (height >= idx->start)
+    count = height - idx->start + 1;
+
+  if (count >= idx->count + idx->pending)
+    return true;
+
+  // Only uncommitted records are dropped. The
+  // new tip may still be sitting in the file.
+  if (count > idx->count) {
+    off_t off = bch_hindex_offset(count - 1) + REC_HASH;
+
+    if (!bch_hindex_pread(idx->fd, idx->tip, 32, off))
+      return false;
+
+    idx->pending = count - idx->count;
+
+    return true;
+  }
+
+  if (count > 0) {
+    const uint8_t *rec = bch_hindex_check(idx, count - 1);
+
+    if (!rec)
+      return false;
+
+    memcpy(idx->tip, rec + REC_HASH, 32);
+  } else {
+    memset(idx->tip, 0, 32);
+  }
+
+  if (count == idx->count) {
+    idx->pending = 0;
+    return true;
+  }
+
+  if (!bch_hindex_write_tip(idx, idx->seq + 1, count))
+    return false;
+
+  if (fsync(idx->fd) != 0)
+    return false;
+
+  // Records above the new tip will be rewritten
+  // and must be validated again when read.
+  uint32_t i;
+  for (i = count; i < idx->count; i++)
+    idx->checked[i >> 3] &= ~(1 << (i & 7));
+
+  idx->seq += 1;
+  idx->count = count;
+  idx->pending = 0;
+
+  return true;
+}
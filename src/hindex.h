@@ -0,0 +1,95 @@
+#ifndef _BCH_HINDEX_H
+#define _BCH_HINDEX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "header.h"
+
+/*
+ * On-disk header index.
+ *
+ * Layout:
+ *
+ *   [preamble (32)] [tip slot A (48)] [tip slot B (48)]
+ *   [record 0 (160)] [record 1 (160)] ...
+ *
+ * Each record holds the raw 80 byte header followed by its
+ * hash, chainwork, height and a crc32. Records are appended
+ * with pwrite() and only become visible once a tip slot is
+ * committed. The two tip slots are written alternately so a
+ * torn write always leaves the previous tip intact.
+ *
+ * The file is mmap'd read-only. Records are validated
+ * lazily the first time they are looked at. Pointers
+ * returned by bch_hindex_record(), bch_hindex_hash() and
+ * bch_hindex_work() point into the mapping and are
+ * invalidated by the next bch_hindex_commit(), which may
+ * remap the file, and by bch_hindex_close().
+ */
+
+#define BCH_HINDEX_VERSION 1
+#define BCH_HINDEX_PREAMBLE_SIZE 32
+#define BCH_HINDEX_TIP_SIZE 48
+#define BCH_HINDEX_HEADER_SIZE \
+  (BCH_HINDEX_PREAMBLE_SIZE + BCH_HINDEX_TIP_SIZE * 2)
+#define BCH_HINDEX_RECORD_SIZE 160
+
+typedef struct bch_hindex_s {
+  int fd;
+  uint32_t magic;
+  uint32_t start;
+  uint32_t count;
+  uint32_t pending;
+  uint64_t seq;
+  uint8_t tip[32];
+  uint8_t *map;
+  size_t map_size;
+  uint8_t *checked;
+  size_t checked_size;
+} bch_hindex_t;
+
+#define bch_hindex_start(idx) ((idx)->start)
+#define bch_hindex_end(idx) ((idx)->start + (idx)->count)
+#define bch_hindex_has(idx, h) \
+  ((h) >= (idx)->start && (h) - (idx)->start < (idx)->count)
+
+void
+bch_hindex_init(bch_hindex_t *idx);
+
+bool
+bch_hindex_open(
+  bch_hindex_t *idx,
+  const char *path,
+  uint32_t magic,
+  uint32_t start
+);
+
+void
+bch_hindex_close(bch_hindex_t *idx);
+
+const uint8_t *
+bch_hindex_record(bch_hindex_t *idx, uint32_t height);
+
+const uint8_t *
+bch_hindex_hash(bch_hindex_t *idx, uint32_t height);
+
+const uint8_t *
+bch_hindex_work(bch_hindex_t *idx, uint32_t height);
+
+bool
+bch_hindex_get(bch_hindex_t *idx, uint32_t height, bch_header_t *hdr);
+
+bool
+bch_hindex_tip(bch_hindex_t *idx, bch_header_t *hdr);
+
+bool
+bch_hindex_append(bch_hindex_t *idx, const bch_header_t *hdr);
+
+bool
+bch_hindex_commit(bch_hindex_t *idx);
+
+bool
+bch_hindex_truncate(bch_hindex_t *idx, uint32_t height);
+#endif
@@ -0,0 +1,611 @@
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/random.h>
+#endif
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "hmap.h"
+#include "map.h"
+
+#define BCH_HMAP_EMPTY ((int8_t)-128)
+#define BCH_HMAP_DELETED ((int8_t)-2)
+#define BCH_HMAP_MIN_BUCKETS 16
+
+// Max load factor of 7/8.
+#define BCH_HMAP_CAPACITY(n) ((n) - ((n) >> 3))
+
+/*
+ * Control byte groups
+ */
+
+#if defined(__SSE2__)
+typedef uint32_t bch_hmap_mask_t;
+
+// A set bit `i` in a mask refers to slot `i >> BCH_HMAP_SHIFT`.
+#define BCH_HMAP_SHIFT 0
+
+static inline bch_hmap_mask_t
+bch_hmap_match(const int8_t *group, int8_t tag) {
+  __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(tag)));
+}
+
+static inline bch_hmap_mask_t
+bch_hmap_match_empty(const int8_t *group) {
+  return bch_hmap_match(group, BCH_HMAP_EMPTY);
+}
+
+static inline bch_hmap_mask_t
+bch_hmap_match_free(const int8_t *group) {
+  // Empty and deleted are the only negative bytes.
+  __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+  return _mm_movemask_epi8(ctrl);
+}
+#else
+typedef uint64_t bch_hmap_mask_t;
+
+#define BCH_HMAP_SHIFT 3
+#define BCH_HMAP_LSBS 0x0101010101010101ull
+#define BCH_HMAP_MSBS 0x8080808080808080ull
+
+static inline uint64_t
+bch_hmap_load(const int8_t *group) {
+  const uint8_t *p = (const uint8_t *)group;
+
+  return ((uint64_t)p[0])
+       | ((uint64_t)p[1] << 8)
+       | ((uint64_t)p[2] << 16)
+       | ((uint64_t)p[3] << 24)
+       | ((uint64_t)p[4] << 32)
+       | ((uint64_t)p[5] << 40)
+       | ((uint64_t)p[6] << 48)
+       | ((uint64_t)p[7] << 56);
+}
+
+// May report false positives after a true match;
+// callers compare keys anyway.
+static inline bch_hmap_mask_t
+bch_hmap_match(const int8_t *group, int8_t tag) {
+  uint64_t x = bch_hmap_load(group) ^ (BCH_HMAP_LSBS * (uint8_t)tag);
+  return (x - BCH_HMAP_LSBS) & ~x & BCH_HMAP_MSBS;
+}
+
+static inline bch_hmap_mask_t
+bch_hmap_match_empty(const int8_t *group) {
+  // Empty (0x80) is the only byte with bit 7 set and bit 1 clear.
+  uint64_t ctrl = bch_hmap_load(group);
+  return ctrl & (~ctrl << 6) & BCH_HMAP_MSBS;
+}
+
+static inline bch_hmap_mask_t
+bch_hmap_match_free(const int8_t *group) {
+  return bch_hmap_load(group) & BCH_HMAP_MSBS;
+}
+#endif
+
+static inline uint32_t
+bch_hmap_ctz(bch_hmap_mask_t mask) {
+  assert(mask != 0 && "empty mask");
+#if defined(__GNUC__)
+  return __builtin_ctzll(mask);
+#else
+  uint32_t n = 0;
+
+  while (!(mask & 1)) {
+    mask >>= 1;
+    n += 1;
+  }
+
+  return n;
+#endif
+}
+
+/*
+ * Hashing
+ */
+
+static inline uint64_t
+bch_hmap_read64(const uint8_t *p) {
+  return ((uint64_t)p[0])
+       | ((uint64_t)p[1] << 8)
+       | ((uint64_t)p[2] << 16)
+       | ((uint64_t)p[3] << 24)
+       | ((uint64_t)p[4] << 32)
+       | ((uint64_t)p[5] << 40)
+       | ((uint64_t)p[6] << 48)
+       | ((uint64_t)p[7] << 56);
+}
+
+// Every 8 byte word of the key is folded in, the last
+// one overlapping when the size is not a multiple of 8.
+// Keys that share a prefix (or come from a peer) thus
+// still spread out under the secret seed.
+static inline uint64_t
+bch_hmap_mix(uint64_t seed, const uint8_t *key, size_t len) {
+  uint64_t h = seed;
+  size_t i;
+
+  for (i = 0; i + 8 <= len; i += 8) {
+    h = (h ^ bch_hmap_read64(key + i)) * 0x9e3779b97f4a7c15ull;
+    h ^= h >> 29;
+  }
+
+  if (i < len) {
+    h = (h ^ bch_hmap_read64(key + len - 8)) * 0x9e3779b97f4a7c15ull;
+    h ^= h >> 29;
+  }
+
+  return h ^ (h >> 32);
+}
+
+static inline uint64_t
+bch_hmap_hash(const bch_hmap_t *map, const uint8_t *key) {
+  // Constant sizes let the compiler unroll the loop.
+  switch (map->key_size) {
+    case 32:
+      return bch_hmap_mix(map->seed, key, 32);
+    case 20:
+      return bch_hmap_mix(map->seed, key, 20);
+    default:
+      return bch_hmap_mix(map->seed, key, map->key_size);
+  }
+}
+
+#define bch_hmap_h1(h) ((uint32_t)((h) >> 7))
+#define bch_hmap_h2(h) ((int8_t)((h) & 0x7f))
+
+static inline bool
+bch_hmap_equal(const bch_hmap_t *map, const uint8_t *a, const uint8_t *b) {
+  // Constant sizes let the compiler inline the compare.
+  switch (map->key_size) {
+    case 32:
+      return memcmp(a, b, 32) == 0;
+    case 20:
+      return memcmp(a, b, 20) == 0;
+    default:
+      return memcmp(a, b, map->key_size) == 0;
+  }
+}
+
+static inline void
+bch_hmap_set_ctrl(bch_hmap_t *map, uint32_t i, int8_t c) {
+  map->ctrl[i] = c;
+
+  // Mirror the first group past the end so that
+  // a group load never has to wrap around.
+  if (i < BCH_HMAP_GROUP)
+    map->ctrl[map->n_buckets + i] = c;
+}
+
+static uint32_t
+bch_hmap_find(const bch_hmap_t *map, const uint8_t *key, uint64_t h) {
+  uint32_t mask = map->n_buckets - 1;
+  uint32_t pos = bch_hmap_h1(h) & mask;
+  uint32_t step = 0;
+  int8_t tag = bch_hmap_h2(h);
+
+  for (;;) {
+    const int8_t *group = &map->ctrl[pos];
+    bch_hmap_mask_t m = bch_hmap_match(group, tag);
+
+    while (m) {
+      uint32_t i = (pos + (bch_hmap_ctz(m) >> BCH_HMAP_SHIFT)) & mask;
+
+      if (bch_hmap_equal(map, bch_hmap_key(map, i), key))
+        return i;
+
+      m &= m - 1;
+    }
+
+    if (bch_hmap_match_empty(group))
+      return map->n_buckets;
+
+    // Triangular probing over groups visits
+    // every group once for power of two sizes.
+    step += BCH_HMAP_GROUP;
+    pos = (pos + step) & mask;
+  }
+}
+
+static uint32_t
+bch_hmap_find_free(const bch_hmap_t *map, uint64_t h) {
+  uint32_t mask = map->n_buckets - 1;
+  uint32_t pos = bch_hmap_h1(h) & mask;
+  uint32_t step = 0;
+
+  for (;;) {
+    bch_hmap_mask_t m = bch_hmap_match_free(&map->ctrl[pos]);
+
+    if (m)
+      return (pos + (bch_hmap_ctz(m) >> BCH_HMAP_SHIFT)) & mask;
+
+    step += BCH_HMAP_GROUP;
+    pos = (pos + step) & mask;
+  }
+}
+
+static bool
+bch_hmap_entropy(uint8_t *data, size_t len) {
+#if defined(__linux__)
+  while (len > 0) {
+    ssize_t r = getrandom(data, len, 0);
+
+    if (r < 0) {
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+
+    data += r;
+    len -= r;
+  }
+
+  if (len == 0)
+    return true;
+#endif
+
+  int fd = open("/dev/urandom", O_RDONLY | O_CLOEXEC);
+
+  if (fd == -1)
+    return false;
+
+  while (len > 0) {
+    ssize_t r = read(fd, data, len);
+
+    if (r < 0 && errno == EINTR)
+      continue;
+
+    if (r <= 0)
+      break;
+
+    data += r;
+    len -= r;
+  }
+
+  close(fd);
+
+  return len == 0;
+}
+
+static uint64_t
+bch_hmap_seed(void) {
+  // Per-table secret seed so crafted keys cannot
+  // target the probe sequence of every node.
+  uint8_t data[8];
+
+  // Without entropy the tables would be open to
+  // collision flooding; refuse to run instead.
+  if (!bch_hmap_entropy(data, sizeof(data)))
+    abort();
+
+  return bch_hmap_read64(data);
+}
+
+/*
+ * Map
+ */
+
+void
+bch_hmap_init(
+  bch_hmap_t *map,
+  uint32_t key_size,
+  bool is_map,
+  bch_map_free_func free_func
+) {
+  assert(map && "map is null");
+  assert(key_size >= 8 && "key too small");
+
+  map->key_size = key_size;
+  map->n_buckets = 0;
+  map->size = 0;
+  map->growth_left = 0;
+  map->seed = bch_hmap_seed();
+  map->ctrl = NULL;
+  map->keys = NULL;
+  map->vals = NULL;
+  map->is_map = is_map;
+  map->free_func = free_func;
+}
+
+void
+bch_hmap_init_hash_map(bch_hmap_t *map, bch_map_free_func free_func) {
+  bch_hmap_init(map, 32, true, free_func);
+}
+
+void
+bch_hmap_init_hash_set(bch_hmap_t *map) {
+  bch_hmap_init(map, 32, false, NULL);
+}
+
+void
+bch_hmap_init_hash160_map(bch_hmap_t *map, bch_map_free_func free_func) {
+  bch_hmap_init(map, 20, true, free_func);
+}
+
+void
+bch_hmap_init_hash160_set(bch_hmap_t *map) {
+  bch_hmap_init(map, 20, false, NULL);
+}
+
+void
+bch_hmap_uninit(bch_hmap_t *map) {
+  if (!map)
+    return;
+
+  bch_hmap_clear(map);
+
+  free(map->ctrl);
+  free(map->keys);
+  free(map->vals);
+
+  map->n_buckets = 0;
+  map->growth_left = 0;
+  map->ctrl = NULL;
+  map->keys = NULL;
+  map->vals = NULL;
+}
+
+bch_hmap_t *
+bch_hmap_alloc(uint32_t key_size, bool is_map, bch_map_free_func free_func) {
+  bch_hmap_t *map = malloc(sizeof(bch_hmap_t));
+
+  if (!map)
+    return NULL;
+
+  bch_hmap_init(map, key_size, is_map, free_func);
+
+  return map;
+}
+
+void
+bch_hmap_free(bch_hmap_t *map) {
+  if (!map)
+    return;
+
+  bch_hmap_uninit(map);
+  free(map);
+}
+
+void
+bch_hmap_reset(bch_hmap_t *map) {
+  assert(map && "map is null");
+
+  if (map->n_buckets == 0)
+    return;
+
+  memset(map->ctrl, (uint8_t)BCH_HMAP_EMPTY, map->n_buckets + BCH_HMAP_GROUP);
+
+  map->size = 0;
+  map->growth_left = BCH_HMAP_CAPACITY(map->n_buckets);
+}
+
+void
+bch_hmap_clear(bch_hmap_t *map) {
+  assert(map && "map is null");
+
+  if (map->is_map && map->free_func) {
+    uint32_t i;
+
+    for (i = 0; i < map->n_buckets; i++) {
+      if (bch_hmap_exists(map, i) && map->vals[i])
+        map->free_func(map->vals[i]);
+    }
+  }
+
+  bch_hmap_reset(map);
+}
+
+// Rebuild into `n_buckets` buckets. Also used at
+// the current size to drop deleted entries.
+static bool
+bch_hmap_rehash(bch_hmap_t *map, uint32_t n_buckets) {
+  bch_hmap_t old = *map;
+  uint32_t i;
+
+  assert((n_buckets & (n_buckets - 1)) == 0 && "n_buckets not a power of two");
+  assert(BCH_HMAP_CAPACITY(n_buckets) > map->size && "n_buckets too small");
+
+  int8_t *ctrl = malloc(n_buckets + BCH_HMAP_GROUP);
+  uint8_t *keys = malloc((size_t)n_buckets * map->key_size);
+  void **vals = NULL;
+
+  if (map->is_map)
+    vals = malloc((size_t)n_buckets * sizeof(void *));
+
+  if (!ctrl || !keys || (map->is_map && !vals)) {
+    free(ctrl);
+    free(keys);
+    free(vals);
+    return false;
+  }
+
+  memset(ctrl, (uint8_t)BCH_HMAP_EMPTY, n_buckets + BCH_HMAP_GROUP);
+
+  map->n_buckets = n_buckets;
+  map->ctrl = ctrl;
+  map->keys = keys;
+  map->vals = vals;
+
+  for (i = 0; i < old.n_buckets; i++) {
+    if (!bch_hmap_exists(&old, i))
+      continue;
+
+    const uint8_t *key = bch_hmap_key(&old, i);
+    uint64_t h = bch_hmap_hash(map, key);
+    uint32_t j = bch_hmap_find_free(map, h);
+
+    bch_hmap_set_ctrl(map, j, bch_hmap_h2(h));
+    memcpy(bch_hmap_key(map, j), key, map->key_size);
+
+    if (map->is_map)
+      map->vals[j] = old.vals[i];
+  }
+
+  map->growth_left = BCH_HMAP_CAPACITY(n_buckets) - map->size;
+
+  free(old.ctrl);
+  free(old.keys);
+  free(old.vals);
+
+  return true;
+}
+
+bool
+bch_hmap_resize(bch_hmap_t *map, uint32_t new_n_buckets) {
+  assert(map && "map is null");
+
+  uint32_t n = BCH_HMAP_MIN_BUCKETS;
+
+  while (n < new_n_buckets) {
+    if (n >= ((uint32_t)1 << 31))
+      return false;
+    n <<= 1;
+  }
+
+  // Requested size is too small.
+  if (BCH_HMAP_CAPACITY(n) <= map->size)
+    return true;
+
+  return bch_hmap_rehash(map, n);
+}
+
+uint32_t
+bch_hmap_lookup(const bch_hmap_t *map, const uint8_t *key) {
+  assert(map && "map is null");
+  assert(key && "key is null");
+
+  if (map->n_buckets == 0)
+    return 0;
+
+  return bch_hmap_find(map, key, bch_hmap_hash(map, key));
+}
+
+uint32_t
+bch_hmap_put(bch_hmap_t *map, const uint8_t *key, int *ret) {
+  assert(map && "map is null");
+  assert(key && "key is null");
+  assert(ret && "ret is null");
+
+  uint64_t h = bch_hmap_hash(map, key);
+  uint32_t i = 0;
+
+  if (map->n_buckets != 0) {
+    i = bch_hmap_find(map, key, h);
+
+    if (i != map->n_buckets) {
+      *ret = 0;
+      return i;
+    }
+
+    i = bch_hmap_find_free(map, h);
+  }
+
+  if (map->n_buckets == 0
+      || (map->ctrl[i] == BCH_HMAP_EMPTY && map->growth_left == 0)) {
+    uint32_t n = map->n_buckets;
+
+    // Grow if more than half full, otherwise
+    // the table is mostly tombstones: rebuild.
+    if (n == 0) {
+      n = BCH_HMAP_MIN_BUCKETS;
+    } else if (map->size + 1 > BCH_HMAP_CAPACITY(n) / 2) {
+      if (n >= ((uint32_t)1 << 31)) {
+        *ret = -1;
+        return map->n_buckets;
+      }
+      n <<= 1;
+    }
+
+    if (!bch_hmap_rehash(map, n)) {
+      *ret = -1;
+      return map->n_buckets;
+    }
+
+    i = bch_hmap_find_free(map, h);
+  }
+
+  if (map->ctrl[i] == BCH_HMAP_EMPTY) {
+    map->growth_left -= 1;
+    *ret = 1;
+  } else {
+    *ret = 2;
+  }
+
+  bch_hmap_set_ctrl(map, i, bch_hmap_h2(h));
+  memcpy(bch_hmap_key(map, i), key, map->key_size);
+
+  if (map->is_map)
+    map->vals[i] = NULL;
+
+  map->size += 1;
+
+  return i;
+}
+
+void
+bch_hmap_delete(bch_hmap_t *map, uint32_t x) {
+  assert(map && "map is null");
+
+  if (x == map->n_buckets || !bch_hmap_exists(map, x))
+    return;
+
+  bch_hmap_set_ctrl(map, x, BCH_HMAP_DELETED);
+  map->size -= 1;
+}
+
+bool
+bch_hmap_set(bch_hmap_t *map, const uint8_t *key, void *value) {
+  assert(map && "map is null");
+  assert(map->is_map && "map is a set");
+
+  int ret;
+  uint32_t i = bch_hmap_put(map, key, &ret);
+
+  if (ret == -1)
+    return false;
+
+  map->vals[i] = value;
+
+  return true;
+}
+
+void *
+bch_hmap_get(const bch_hmap_t *map, const uint8_t *key) {
+  assert(map && "map is null");
+  assert(map->is_map && "map is a set");
+
+  uint32_t i = bch_hmap_lookup(map, key);
+
+  if (i == map->n_buckets)
+    return NULL;
+
+  return map->vals[i];
+}
+
+bool
+bch_hmap_has(const bch_hmap_t *map, const uint8_t *key) {
+  return bch_hmap_lookup(map, key) != map->n_buckets;
+}
+
+bool
+bch_hmap_del(bch_hmap_t *map, const uint8_t *key) {
+  uint32_t i = bch_hmap_lookup(map, key);
+
+  if (i == map->n_buckets)
+    return false;
+
+  bch_hmap_delete(map, i);
+
+  return true;
+}
@@ -0,0 +1,125 @@
+#ifndef _BCH_HMAP_H
+#define _BCH_HMAP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "map.h"
+
+/*
+ * Hash-keyed map.
+ *
+ * An open-addressing table specialised for fixed-size keys
+ * which are themselves hashes (block/tx hashes, hash160s).
+ * Keys are copied inline into the table, so lookups never
+ * chase a key pointer or call through a function pointer.
+ *
+ * Each bucket has a control byte: empty, deleted, or the low
+ * 7 bits of the key's hash. Probing compares a whole group
+ * of control bytes at once (SSE2 where available, 64 bit
+ * SWAR otherwise) and only touches keys whose tag matches.
+ * Keys are hashed in full under a per-table seed drawn
+ * from the OS, so peers cannot predict bucket positions.
+ */
+
+#if defined(__SSE2__)
+#define BCH_HMAP_GROUP 16
+#else
+#define BCH_HMAP_GROUP 8
+#endif
+
+typedef struct bch_hmap_s {
+  uint32_t key_size;
+  uint32_t n_buckets;
+  uint32_t size;
+  uint32_t growth_left;
+  uint64_t seed;
+  int8_t *ctrl;
+  uint8_t *keys;
+  void **vals;
+  bool is_map;
+  bch_map_free_func free_func;
+} bch_hmap_t;
+
+typedef uint32_t bch_hmap_iter_t;
+
+#define bch_hmap_begin(map) ((bch_hmap_iter_t)0)
+#define bch_hmap_end(map) ((map)->n_buckets)
+#define bch_hmap_exists(map, i) ((map)->ctrl[i] >= 0)
+#define bch_hmap_key(map, i) (&(map)->keys[(size_t)(i) * (map)->key_size])
+#define bch_hmap_value(map, i) ((map)->vals[i])
+
+#define bch_hmap_each(map, kvar, vvar, code)                          \
+  do {                                                                \
+    bch_hmap_iter_t __i;                                              \
+    for (__i = bch_hmap_begin(map); __i < bch_hmap_end(map); __i++) { \
+      if (!bch_hmap_exists(map, __i))                                 \
+        continue;                                                     \
+                                                                      \
+      (kvar) = bch_hmap_key(map, __i);                                \
+      (vvar) = bch_hmap_value(map, __i);                              \
+                                                                      \
+      code;                                                           \
+    }                                                                 \
+  } while (0)
+
+void
+bch_hmap_init(
+  bch_hmap_t *map,
+  uint32_t key_size,
+  bool is_map,
+  bch_map_free_func free_func
+);
+
+void
+bch_hmap_init_hash_map(bch_hmap_t *map, bch_map_free_func free_func);
+
+void
+bch_hmap_init_hash_set(bch_hmap_t *map);
+
+void
+bch_hmap_init_hash160_map(bch_hmap_t *map, bch_map_free_func free_func);
+
+void
+bch_hmap_init_hash160_set(bch_hmap_t *map);
+
+void
+bch_hmap_uninit(bch_hmap_t *map);
+
+bch_hmap_t *
+bch_hmap_alloc(uint32_t key_size, bool is_map, bch_map_free_func free_func);
+
+void
+bch_hmap_free(bch_hmap_t *map);
+
+void
+bch_hmap_reset(bch_hmap_t *map);
+
+void
+bch_hmap_clear(bch_hmap_t *map);
+
+bool
+bch_hmap_resize(bch_hmap_t *map, uint32_t new_n_buckets);
+
+uint32_t
+bch_hmap_lookup(const bch_hmap_t *map, const uint8_t *key);
+
+uint32_t
+bch_hmap_put(bch_hmap_t *map, const uint8_t *key, int *ret);
+
+void
+bch_hmap_delete(bch_hmap_t *map, uint32_t x);
+
+bool
+bch_hmap_set(bch_hmap_t *map, const uint8_t *key, void *value);
+
+void *
+bch_hmap_get(const bch_hmap_t *map, const uint8_t *key);
+
+bool
+bch_hmap_has(const bch_hmap_t *map, const uint8_t *key);
+
+bool
+bch_hmap_del(bch_hmap_t *map, const uint8_t *key);
+#endif
@@ -0,0 +1,1154 @@
+/*
+ * Parts of this software are based on khash.h:
+ *
+ *  The MIT License
+ *
+ *  Copyright (c) 2008, 2009, 2011 by Attractive Chaos <attractor@live.co.uk>
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ *  BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ *  ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ *  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cpu.h"
+#include "map.h"
+
+// Old buckets migrated per operation
+// while an incremental resize is pending.
+#define BCH_MAP_MIGRATE_STEP 64
+
+// Keys hashed ahead of insertion by bch_map_put_many.
+#define BCH_MAP_BATCH 32
+
+#if defined(__GNUC__)
+#define bch_map_prefetch(p) __builtin_prefetch((p), 1, 0)
+#define BCH_MAP_VECTOR
+#else
+#define bch_map_prefetch(p) ((void)(p))
+#endif
+
+// Seeds kept in registers per pass of bch_map_tweak3_many.
+#define BCH_MAP_TWEAK_STRIP 64
+
+static void
+bch_map_migrate(bch_map_t *map, uint32_t max);
+
+/*
+ * Map
+ */
+
+void
+bch_map_init(
+  bch_map_t *map,
+  bool is_map,
+  bch_map_hash_func hash_func,
+  bch_map_equal_func equal_func,
+  bch_map_free_func free_func
+) {
+  assert(map && "map is null");
+  assert(hash_func && "hash_func is null");
+  assert(equal_func && "equal_func is null");
+
+  map->n_buckets = 0;
+  map->size = 0;
+  map->n_occupied = 0;
+  map->upper_bound = 0;
+  map->flags = NULL;
+  map->keys = NULL;
+  map->vals = NULL;
+  map->is_map = is_map;
+  map->hash_func = hash_func;
+  map->equal_func = equal_func;
+  map->free_func = free_func;
+  map->incremental = false;
+  map->old_n_buckets = 0;
+  map->old_pos = 0;
+  map->old_flags = NULL;
+  map->old_keys = NULL;
+  map->old_vals = NULL;
+}
+
+void
+bch_map_init_map(
+  bch_map_t *map,
+  bch_map_hash_func hash_func,
+  bch_map_equal_func equal_func,
+  bch_map_free_func free_func
+) {
+  bch_map_init(map, true, hash_func, equal_func, free_func);
+}
+
+void
+bch_map_init_set(
+  bch_map_t *map,
+  bch_map_hash_func hash_func,
+  bch_map_equal_func equal_func
+) {
+  bch_map_init(map, false, hash_func, equal_func, NULL);
+}
+
+void
+bch_map_init_hash_map(bch_map_t *map, bch_map_free_func free_func) {
+  bch_map_init_map(map, bch_map_hash_hash, bch_map_equal_hash, free_func);
+}
+
+void
+bch_map_init_hash_set(bch_map_t *map) {
+  bch_map_init_set(map, bch_map_hash_hash, bch_map_equal_hash);
+}
+
+void
+bch_map_init_hash160_map(bch_map_t *map, bch_map_free_func free_func) {
+  bch_map_init_map(
+    map,
+    bch_map_hash_hash160,
+    bch_map_equal_hash160,
+    free_func
+  );
+}
+
+void
+bch_map_init_hash160_set(bch_map_t *map) {
+  bch_map_init_set(map, bch_map_hash_hash160, bch_map_equal_hash160);
+}
+
+void
+bch_map_init_str_map(bch_map_t *map, bch_map_free_func free_func) {
+  bch_map_init_map(map, bch_map_hash_str, bch_map_equal_str, free_func);
+}
+
+void
+bch_map_init_str_set(bch_map_t *map) {
+  bch_map_init_set(map, bch_map_hash_str, bch_map_equal_str);
+}
+
+void
+bch_map_init_int_map(bch_map_t *map, bch_map_free_func free_func) {
+  bch_map_init_map(map, bch_map_hash_int, bch_map_equal_int, free_func);
+}
+
+void
+bch_map_init_int_set(bch_map_t *map) {
+  bch_map_init_set(map, bch_map_hash_int, bch_map_equal_int);
+}
+
+static void
+bch_map_free_old(bch_map_t *map) {
+  free(map->old_flags);
+  free(map->old_keys);
+  free(map->old_vals);
+
+  map->old_n_buckets = 0;
+  map->old_pos = 0;
+  map->old_flags = NULL;
+  map->old_keys = NULL;
+  map->old_vals = NULL;
+}
+
+void
+bch_map_uninit(bch_map_t *map) {
+  if (!map)
+    return;
+
+  bch_map_clear(map);
+
+  free(map->flags);
+  free(map->keys);
+  free(map->vals);
+
+  map->n_buckets = 0;
+  map->n_occupied = 0;
+  map->upper_bound = 0;
+  map->flags = NULL;
+  map->keys = NULL;
+  map->vals = NULL;
+}
+
+bch_map_t *
+bch_map_alloc(
+  bool is_map,
+  bch_map_hash_func hash_func,
+  bch_map_equal_func equal_func,
+  bch_map_free_func free_func
+) {
+  bch_map_t *map = malloc(sizeof(bch_map_t));
+
+  if (!map)
+    return NULL;
+
+  bch_map_init(map, is_map, hash_func, equal_func, free_func);
+
+  return map;
+}
+
+bch_map_t *
+bch_map_alloc_map(
+  bch_map_hash_func hash_func,
+  bch_map_equal_func equal_func,
+  bch_map_free_func free_func
+) {
+  return bch_map_alloc(true, hash_func, equal_func, free_func);
+}
+
+bch_map_t *
+bch_map_alloc_set(
+  bch_map_hash_func hash_func,
+  bch_map_equal_func equal_func
+) {
+  return bch_map_alloc(false, hash_func, equal_func, NULL);
+}
+
+bch_map_t *
+bch_map_alloc_hash_map(bch_map_free_func free_func) {
+  return bch_map_alloc_map(bch_map_hash_hash, bch_map_equal_hash, free_func);
+}
+
+bch_map_t *
+bch_map_alloc_hash_set(void) {
+  return bch_map_alloc_set(bch_map_hash_hash, bch_map_equal_hash);
+}
+
+bch_map_t *
+bch_map_alloc_hash160_map(bch_map_free_func free_func) {
+  return bch_map_alloc_map(
+    bch_map_hash_hash160,
+    bch_map_equal_hash160,
+    free_func
+  );
+}
+
+bch_map_t *
+bch_map_alloc_hash160_set(void) {
+  return bch_map_alloc_set(bch_map_hash_hash160, bch_map_equal_hash160);
+}
+
+bch_map_t *
+bch_map_alloc_str_map(bch_map_free_func free_func) {
+  return bch_map_alloc_map(bch_map_hash_str, bch_map_equal_str, free_func);
+}
+
+bch_map_t *
+bch_map_alloc_str_set(void) {
+  return bch_map_alloc_set(bch_map_hash_str, bch_map_equal_str);
+}
+
+bch_map_t *
+bch_map_alloc_int_map(bch_map_free_func free_func) {
+  return bch_map_alloc_map(bch_map_hash_int, bch_map_equal_int, free_func);
+}
+
+bch_map_t *
+bch_map_alloc_int_set(void) {
+  return bch_map_alloc_set(bch_map_hash_int, bch_map_equal_int);
+}
+
+void
+bch_map_free(bch_map_t *map) {
+  if (!map)
+    return;
+
+  bch_map_uninit(map);
+  free(map);
+}
+
+void
+bch_map_reset(bch_map_t *map) {
+  if (!map)
+    return;
+
+  bch_map_free_old(map);
+
+  if (map->flags) {
+    memset(map->flags, 0xaa, __bch_fsize(map->n_buckets) * sizeof(uint32_t));
+    map->size = 0;
+    map->n_occupied = 0;
+  }
+}
+
+void
+bch_map_incremental(bch_map_t *map, bool incremental) {
+  assert(map && "map is null");
+
+  if (!incremental)
+    bch_map_finish_resize(map);
+
+  map->incremental = incremental;
+}
+
+void
+bch_map_finish_resize(bch_map_t *map) {
+  assert(map && "map is null");
+
+  if (map->old_flags)
+    bch_map_migrate(map, UINT32_MAX);
+}
+
+/*
+ * Table primitives
+ */
+
+static uint32_t
+bch_map_probe(
+  const bch_map_t *map,
+  const uint32_t *flags,
+  void **keys,
+  uint32_t n_buckets,
+  const void *key
+) {
+  uint32_t k, i, last, mask, step = 0;
+
+  if (n_buckets == 0)
+    return 0;
+
+  mask = n_buckets - 1;
+  k = map->hash_func(key);
+  i = k & mask;
+  last = i;
+
+  while (!__bch_isempty(flags, i)
+         && (__bch_isdel(flags, i) || !map->equal_func(keys[i], key))) {
+    i = (i + (++step)) & mask;
+
+    if (i == last)
+      return n_buckets;
+  }
+
+  return __bch_iseither(flags, i) ? n_buckets : i;
+}
+
+// Place a key known to be absent from the current
+// table. Used when moving entries between tables.
+static uint32_t
+bch_map_place(bch_map_t *map, void *key, void *val) {
+  uint32_t mask = map->n_buckets - 1;
+  uint32_t i = map->hash_func(key) & mask;
+  uint32_t step = 0;
+
+  while (!__bch_iseither(map->flags, i))
+    i = (i + (++step)) & mask;
+
+  if (__bch_isempty(map->flags, i))
+    map->n_occupied += 1;
+
+  __bch_set_isboth_false(map->flags, i);
+
+  map->keys[i] = key;
+
+  if (map->is_map)
+    map->vals[i] = val;
+
+  return i;
+}
+
+// Move up to `max` old buckets into the current table.
+static void
+bch_map_migrate(bch_map_t *map, uint32_t max) {
+  uint32_t i;
+
+  while (max > 0 && map->old_pos < map->old_n_buckets) {
+    i = map->old_pos++;
+    max -= 1;
+
+    if (__bch_iseither(map->old_flags, i))
+      continue;
+
+    bch_map_place(
+      map,
+      map->old_keys[i],
+      map->is_map ? map->old_vals[i] : NULL
+    );
+
+    __bch_set_isdel_true(map->old_flags, i);
+  }
+
+  if (map->old_pos == map->old_n_buckets)
+    bch_map_free_old(map);
+}
+
+// If `key` is still in the old table, move it over
+// now so that a put never duplicates it across tables.
+static void
+bch_map_migrate_key(bch_map_t *map, const void *key) {
+  uint32_t i = bch_map_probe(
+    map,
+    map->old_flags,
+    map->old_keys,
+    map->old_n_buckets,
+    key
+  );
+
+  if (i == map->old_n_buckets)
+    return;
+
+  bch_map_place(
+    map,
+    map->old_keys[i],
+    map->is_map ? map->old_vals[i] : NULL
+  );
+
+  __bch_set_isdel_true(map->old_flags, i);
+}
+
+static int
+bch_map_rehash(bch_map_t *map, uint32_t new_n_buckets, bool incremental) {
+  uint32_t *new_flags = NULL;
+  void **new_keys = NULL;
+  void **new_vals = NULL;
+
+  __bch_roundup32(new_n_buckets);
+
+  if (new_n_buckets < 4)
+    new_n_buckets = 4;
+
+  // Requested size is too small.
+  if (map->size >= (uint32_t)(new_n_buckets * __bch_hash_upper + 0.5))
+    return 0;
+
+  new_flags = malloc(__bch_fsize(new_n_buckets) * sizeof(uint32_t));
+  new_keys = malloc(new_n_buckets * sizeof(void *));
+
+  if (map->is_map)
+    new_vals = malloc(new_n_buckets * sizeof(void *));
+
+  if (!new_flags || !new_keys || (map->is_map && !new_vals)) {
+    free(new_flags);
+    free(new_keys);
+    free(new_vals);
+    return -1;
+  }
+
+  memset(new_flags, 0xaa, __bch_fsize(new_n_buckets) * sizeof(uint32_t));
+
+  assert(!map->old_flags && "migration pending");
+
+  map->old_n_buckets = map->n_buckets;
+  map->old_pos = 0;
+  map->old_flags = map->flags;
+  map->old_keys = map->keys;
+  map->old_vals = map->vals;
+
+  map->n_buckets = new_n_buckets;
+  map->n_occupied = 0;
+  map->upper_bound = (uint32_t)(new_n_buckets * __bch_hash_upper + 0.5);
+  map->flags = new_flags;
+  map->keys = new_keys;
+  map->vals = new_vals;
+
+  if (!map->old_flags) {
+    map->old_n_buckets = 0;
+    return 0;
+  }
+
+  bch_map_migrate(map, incremental ? BCH_MAP_MIGRATE_STEP : UINT32_MAX);
+
+  return 0;
+}
+
+int
+bch_map_resize(bch_map_t *map, uint32_t new_n_buckets) {
+  assert(map && "map is null");
+
+  // An explicit resize always completes.
+  bch_map_finish_resize(map);
+
+  return bch_map_rehash(map, new_n_buckets, false);
+}
+
+uint32_t
+bch_map_lookup(const bch_map_t *map, const void *key) {
+  assert(map && "map is null");
+
+  uint32_t i = bch_map_probe(map, map->flags, map->keys, map->n_buckets, key);
+
+  if (i != map->n_buckets || !map->old_flags)
+    return i;
+
+  // Not migrated yet: address the old table
+  // through the indices past bch_map_end().
+  i = bch_map_probe(
+    map,
+    map->old_flags,
+    map->old_keys,
+    map->old_n_buckets,
+    key
+  );
+
+  if (i == map->old_n_buckets)
+    return map->n_buckets;
+
+  return map->n_buckets + 1 + i;
+}
+
+static uint32_t
+bch_map_put_hash(bch_map_t *map, const void *key, uint32_t k, int *ret) {
+  uint32_t x;
+
+  if (map->old_flags) {
+    bch_map_migrate_key(map, key);
+    bch_map_migrate(map, BCH_MAP_MIGRATE_STEP);
+  }
+
+  if (map->n_occupied >= map->upper_bound) {
+    uint32_t new_n_buckets = map->n_buckets + 1;
+
+    // Mostly deleted entries: rebuild at the same size.
+    if (map->n_buckets > (map->size << 1))
+      new_n_buckets = map->n_buckets - 1;
+
+    // Growing again before the last migration
+    // finished; settle it first.
+    bch_map_finish_resize(map);
+
+    if (bch_map_rehash(map, new_n_buckets, map->incremental) < 0) {
+      *ret = -1;
+      return map->n_buckets;
+    }
+
+    if (map->old_flags)
+      bch_map_migrate_key(map, key);
+  }
+
+  {
+    uint32_t i, site, last, mask = map->n_buckets - 1, step = 0;
+
+    x = site = map->n_buckets;
+    i = k & mask;
+
+    if (__bch_isempty(map->flags, i)) {
+      x = i;
+    } else {
+      last = i;
+
+      while (!__bch_isempty(map->flags, i)
+             && (__bch_isdel(map->flags, i)
+                 || !map->equal_func(map->keys[i], key))) {
+        if (__bch_isdel(map->flags, i))
+          site = i;
+
+        i = (i + (++step)) & mask;
+
+        if (i == last) {
+          x = site;
+          break;
+        }
+      }
+
+      if (x == map->n_buckets) {
+        if (__bch_isempty(map->flags, i) && site != map->n_buckets)
+          x = site;
+        else
+          x = i;
+      }
+    }
+  }
+
+  if (__bch_isempty(map->flags, x)) {
+    map->keys[x] = (void *)key;
+    __bch_set_isboth_false(map->flags, x);
+    map->size += 1;
+    map->n_occupied += 1;
+    *ret = 1;
+  } else if (__bch_isdel(map->flags, x)) {
+    map->keys[x] = (void *)key;
+    __bch_set_isboth_false(map->flags, x);
+    map->size += 1;
+    *ret = 2;
+  } else {
+    *ret = 0;
+  }
+
+  return x;
+}
+
+uint32_t
+bch_map_put(bch_map_t *map, const void *key, int *ret) {
+  assert(map && "map is null");
+  assert(ret && "ret is null");
+
+  return bch_map_put_hash(map, key, map->hash_func(key), ret);
+}
+
+bool
+bch_map_reserve(bch_map_t *map, uint32_t size) {
+  assert(map && "map is null");
+
+  uint32_t n_buckets;
+
+  if (size > (uint32_t)(((uint32_t)1 << 31) * __bch_hash_upper))
+    return false;
+
+  if (map->old_flags) {
+    // The table being migrated into may already have
+    // room, even if every bucket it holds were deleted.
+    if ((uint64_t)size + map->n_occupied < map->upper_bound)
+      return true;
+
+    // Growing again; settle the pending migration first.
+    bch_map_finish_resize(map);
+  }
+
+  // Deleted buckets count toward the load bound
+  // until the next rehash clears them.
+  if ((uint64_t)size + (map->n_occupied - map->size) < map->upper_bound)
+    return true;
+
+  n_buckets = (uint32_t)(size / __bch_hash_upper) + 1;
+
+  return bch_map_rehash(map, n_buckets, map->incremental) == 0;
+}
+
+bool
+bch_map_put_many(
+  bch_map_t *map,
+  const void **keys,
+  void **vals,
+  size_t len
+) {
+  assert(map && "map is null");
+  assert(keys && "keys is null");
+  assert((!vals || map->is_map) && "map is a set");
+
+  uint32_t hashes[BCH_MAP_BATCH];
+  size_t i, j, n;
+  int ret;
+
+  if ((uint64_t)map->size + len > UINT32_MAX)
+    return false;
+
+  // Size for the worst case (all keys new) up front.
+  if (!bch_map_reserve(map, map->size + (uint32_t)len))
+    return false;
+
+  for (i = 0; i < len; i += n) {
+    uint32_t mask = map->n_buckets - 1;
+
+    n = len - i < BCH_MAP_BATCH ? len - i : BCH_MAP_BATCH;
+
+    // Hash the whole chunk and prefetch each home bucket
+    // so the probes below mostly hit cache.
+    for (j = 0; j < n; j++) {
+      uint32_t b;
+
+      hashes[j] = map->hash_func(keys[i + j]);
+      b = hashes[j] & mask;
+
+      bch_map_prefetch(&map->flags[b >> 4]);
+      bch_map_prefetch(&map->keys[b]);
+
+      if (vals)
+        bch_map_prefetch(&map->vals[b]);
+    }
+
+    for (j = 0; j < n; j++) {
+      uint32_t x = bch_map_put_hash(map, keys[i + j], hashes[j], &ret);
+
+      if (ret == -1)
+        return false;
+
+      map->keys[x] = (void *)keys[i + j];
+
+      if (vals)
+        map->vals[x] = vals[i + j];
+      else if (map->is_map && ret > 0)
+        map->vals[x] = NULL;
+    }
+  }
+
+  return true;
+}
+
+void
+bch_map_delete(bch_map_t *map, uint32_t x) {
+  assert(map && "map is null");
+
+  if (__bch_isold(map, x)) {
+    uint32_t i = __bch_oldidx(map, x);
+
+    if (map->old_flags
+        && i < map->old_n_buckets
+        && !__bch_iseither(map->old_flags, i)) {
+      __bch_set_isdel_true(map->old_flags, i);
+      map->size -= 1;
+    }
+
+    return;
+  }
+
+  if (x != map->n_buckets && !__bch_iseither(map->flags, x)) {
+    __bch_set_isdel_true(map->flags, x);
+    map->size -= 1;
+  }
+}
+
+void
+bch_map_clear(bch_map_t *map) {
+  assert(map && "map is null");
+
+  if (map->is_map && map->free_func) {
+    uint32_t i;
+
+    for (i = map->old_pos; i < map->old_n_buckets; i++) {
+      if (!__bch_iseither(map->old_flags, i) && map->old_vals[i])
+        map->free_func(map->old_vals[i]);
+    }
+
+    for (i = 0; i < map->n_buckets; i++) {
+      if (!__bch_iseither(map->flags, i) && map->vals[i])
+        map->free_func(map->vals[i]);
+    }
+  }
+
+  bch_map_reset(map);
+}
+
+bool
+bch_map_set(bch_map_t *map, const void *key, void *value) {
+  int ret;
+  uint32_t i = bch_map_put(map, key, &ret);
+
+  if (ret == -1)
+    return false;
+
+  map->keys[i] = (void *)key;
+
+  if (map->is_map)
+    map->vals[i] = value;
+
+  return true;
+}
+
+void *
+bch_map_get(const bch_map_t *map, const void *key) {
+  assert(map && "map is null");
+  assert(map->is_map && "map is a set");
+
+  uint32_t i = bch_map_lookup(map, key);
+
+  if (i == map->n_buckets)
+    return NULL;
+
+  return bch_map_value(map, i);
+}
+
+bool
+bch_map_has(const bch_map_t *map, const void *key) {
+  uint32_t i = bch_map_lookup(map, key);
+  return i != map->n_buckets;
+}
+
+bool
+bch_map_del(bch_map_t *map, const void *key) {
+  uint32_t i;
+
+  assert(map && "map is null");
+
+  if (map->old_flags)
+    bch_map_migrate(map, BCH_MAP_MIGRATE_STEP);
+
+  i = bch_map_lookup(map, key);
+
+  if (i == map->n_buckets)
+    return false;
+
+  bch_map_delete(map, i);
+
+  return true;
+}
+
+/*
+ * Hashing
+ */
+
+uint32_t
+bch_map_hash_str(const void *key) {
+  const char *s = (const char *)key;
+  uint32_t h = (uint32_t)*s;
+
+  if (h) {
+    for (++s; *s; ++s)
+      h = (h << 5) - h + (uint32_t)*s;
+  }
+
+  return h;
+}
+
+bool
+bch_map_equal_str(const void *a, const void *b) {
+  return strcmp((const char *)a, (const char *)b) == 0;
+}
+
+uint32_t
+bch_map_hash_int(const void *key) {
+  return *((const uint32_t *)key);
+}
+
+bool
+bch_map_equal_int(const void *a, const void *b) {
+  return *((const uint32_t *)a) == *((const uint32_t *)b);
+}
+
+uint32_t
+bch_map_hash_hash(const void *key) {
+  return bch_map_murmur3((const uint8_t *)key, 32, 0xfba4c795);
+}
+
+bool
+bch_map_equal_hash(const void *a, const void *b) {
+  return memcmp(a, b, 32) == 0;
+}
+
+uint32_t
+bch_map_hash_hash160(const void *key) {
+  return bch_map_murmur3((const uint8_t *)key, 20, 0xfba4c795);
+}
+
+bool
+bch_map_equal_hash160(const void *a, const void *b) {
+  return memcmp(a, b, 20) == 0;
+}
+
+static inline uint32_t
+bch_map_rotl32(uint32_t x, int8_t r) {
+  return (x << r) | (x >> (32 - r));
+}
+
+uint32_t
+bch_map_murmur3(const uint8_t *data, size_t data_len, uint32_t seed) {
+  const uint32_t c1 = 0xcc9e2d51;
+  const uint32_t c2 = 0x1b873593;
+  uint32_t h1 = seed;
+  uint32_t k1;
+  size_t nblocks = data_len / 4;
+  size_t i;
+
+  for (i = 0; i < nblocks; i++) {
+    const uint8_t *p = &data[i * 4];
+
+    k1 = (uint32_t)p[0]
+       | ((uint32_t)p[1] << 8)
+       | ((uint32_t)p[2] << 16)
+       | ((uint32_t)p[3] << 24);
+
+    k1 *= c1;
+    k1 = bch_map_rotl32(k1, 15);
+    k1 *= c2;
+
+    h1 ^= k1;
+    h1 = bch_map_rotl32(h1, 13);
+    h1 = h1 * 5 + 0xe6546b64;
+  }
+
+  const uint8_t *tail = &data[nblocks * 4];
+
+  k1 = 0;
+
+  switch (data_len & 3) {
+    case 3:
+      k1 ^= (uint32_t)tail[2] << 16;
+      // fall through
+    case 2:
+      k1 ^= (uint32_t)tail[1] << 8;
+      // fall through
+    case 1:
+      k1 ^= (uint32_t)tail[0];
+      k1 *= c1;
+      k1 = bch_map_rotl32(k1, 15);
+      k1 *= c2;
+      h1 ^= k1;
+  }
+
+  h1 ^= (uint32_t)data_len;
+  h1 ^= h1 >> 16;
+  h1 *= 0x85ebca6b;
+  h1 ^= h1 >> 13;
+  h1 *= 0xc2b2ae35;
+  h1 ^= h1 >> 16;
+
+  return h1;
+}
+
+uint32_t
+bch_map_tweak3(
+  const uint8_t *data,
+  size_t data_len,
+  uint32_t n,
+  uint32_t tweak
+) {
+  uint32_t seed = (n * 0xfba4c795) + tweak;
+  return bch_map_murmur3(data, data_len, seed);
+}
+
+static void
+bch_map_tweak3_many_scalar(
+  const uint8_t *data,
+  size_t data_len,
+  uint32_t count,
+  uint32_t tweak,
+  uint32_t *out
+) {
+  const uint32_t c1 = 0xcc9e2d51;
+  const uint32_t c2 = 0x1b873593;
+  size_t nblocks = data_len / 4;
+  uint32_t k1;
+  uint32_t h1;
+  size_t i;
+  uint32_t j;
+
+  for (j = 0; j < count; j++)
+    out[j] = (j * 0xfba4c795) + tweak;
+
+  for (i = 0; i < nblocks; i++) {
+    const uint8_t *p = &data[i * 4];
+
+    k1 = (uint32_t)p[0]
+       | ((uint32_t)p[1] << 8)
+       | ((uint32_t)p[2] << 16)
+       | ((uint32_t)p[3] << 24);
+
+    k1 *= c1;
+    k1 = bch_map_rotl32(k1, 15);
+    k1 *= c2;
+
+    for (j = 0; j < count; j++) {
+      h1 = out[j] ^ k1;
+      h1 = bch_map_rotl32(h1, 13);
+      out[j] = h1 * 5 + 0xe6546b64;
+    }
+  }
+
+  const uint8_t *tail = &data[nblocks * 4];
+
+  k1 = 0;
+
+  switch (data_len & 3) {
+    case 3:
+      k1 ^= (uint32_t)tail[2] << 16;
+      // fall through
+    case 2:
+      k1 ^= (uint32_t)tail[1] << 8;
+      // fall through
+    case 1:
+      k1 ^= (uint32_t)tail[0];
+      k1 *= c1;
+      k1 = bch_map_rotl32(k1, 15);
+      k1 *= c2;
+  }
+
+  for (j = 0; j < count; j++) {
+    h1 = out[j] ^ k1;
+    h1 ^= (uint32_t)data_len;
+    h1 ^= h1 >> 16;
+    h1 *= 0x85ebca6b;
+    h1 ^= h1 >> 13;
+    h1 *= 0xc2b2ae35;
+    h1 ^= h1 >> 16;
+    out[j] = h1;
+  }
+}
+
+/*
+ * 8-way
+ *
+ * Each vector lane carries one seed. The compiler lowers
+ * the vector type to 2x SSE2, 2x NEON, or a single AVX2
+ * register in the AVX2 clone below.
+ */
+
+#ifdef BCH_MAP_VECTOR
+
+typedef uint32_t bch_map_v8_t __attribute__((vector_size(32)));
+
+#define BCH_MAP_ROTL(x, r) (((x) << (r)) | ((x) >> (32 - (r))))
+
+static inline __attribute__((always_inline)) void
+bch_map_tweak3_x8_body(
+  const uint8_t *data,
+  size_t data_len,
+  uint32_t count,
+  uint32_t tweak,
+  uint32_t *out
+) {
+  const uint32_t c1 = 0xcc9e2d51;
+  const uint32_t c2 = 0x1b873593;
+  const bch_map_v8_t step = {0, 1, 2, 3, 4, 5, 6, 7};
+  bch_map_v8_t h[BCH_MAP_TWEAK_STRIP / 8];
+  size_t nblocks = data_len / 4;
+  uint32_t k1;
+  uint32_t base, vecs, v;
+  size_t i;
+
+  // More than BCH_MAP_TWEAK_STRIP seeds means
+  // another pass over the data.
+  for (base = 0; base < count; base += BCH_MAP_TWEAK_STRIP) {
+    uint32_t left = count - base;
+
+    if (left > BCH_MAP_TWEAK_STRIP)
+      left = BCH_MAP_TWEAK_STRIP;
+
+    vecs = (left + 7) / 8;
+
+    for (v = 0; v < vecs; v++)
+      h[v] = (step + (base + v * 8)) * 0xfba4c795 + tweak;
+
+    for (i = 0; i < nblocks; i++) {
+      const uint8_t *p = &data[i * 4];
+
+      k1 = (uint32_t)p[0]
+         | ((uint32_t)p[1] << 8)
+         | ((uint32_t)p[2] << 16)
+         | ((uint32_t)p[3] << 24);
+
+      k1 *= c1;
+      k1 = bch_map_rotl32(k1, 15);
+      k1 *= c2;
+
+      for (v = 0; v < vecs; v++) {
+        bch_map_v8_t x = h[v] ^ k1;
+        h[v] = BCH_MAP_ROTL(x, 13) * 5 + 0xe6546b64;
+      }
+    }
+
+    const uint8_t *tail = &data[nblocks * 4];
+
+    k1 = 0;
+
+    switch (data_len & 3) {
+      case 3:
+        k1 ^= (uint32_t)tail[2] << 16;
+        // fall through
+      case 2:
+        k1 ^= (uint32_t)tail[1] << 8;
+        // fall through
+      case 1:
+        k1 ^= (uint32_t)tail[0];
+        k1 *= c1;
+        k1 = bch_map_rotl32(k1, 15);
+        k1 *= c2;
+    }
+
+    k1 ^= (uint32_t)data_len;
+
+    for (v = 0; v < vecs; v++) {
+      bch_map_v8_t x = h[v] ^ k1;
+
+      x ^= x >> 16;
+      x *= 0x85ebca6b;
+      x ^= x >> 13;
+      x *= 0xc2b2ae35;
+      x ^= x >> 16;
+
+      if (left - v * 8 >= 8)
+        memcpy(&out[base + v * 8], &x, 32);
+      else
+        memcpy(&out[base + v * 8], &x, (left - v * 8) * 4);
+    }
+  }
+}
+
+static void
+bch_map_tweak3_x8(
+  const uint8_t *data,
+  size_t data_len,
+  uint32_t count,
+  uint32_t tweak,
+  uint32_t *out
+) {
+  bch_map_tweak3_x8_body(data, data_len, count, tweak, out);
+}
+
+#ifdef BCH_CPU_X86
+__attribute__((target("avx2"))) static void
+bch_map_tweak3_avx2(
+  const uint8_t *data,
+  size_t data_len,
+  uint32_t count,
+  uint32_t tweak,
+  uint32_t *out
+) {
+  bch_map_tweak3_x8_body(data, data_len, count, tweak, out);
+}
+#endif
+
+#endif /* BCH_MAP_VECTOR */
+
+typedef void bch_map_tweak3_many_func(
+  const uint8_t *data,
+  size_t data_len,
+  uint32_t count,
+  uint32_t tweak,
+  uint32_t *out
+);
+
+// Detected once per process; racing threads
+// all store the same pointer.
+static _Atomic(bch_map_tweak3_many_func *) bch_map_tweak3_impl = NULL;
+
+static bch_map_tweak3_many_func *
+bch_map_tweak3_detect(void) {
+#if defined(BCH_MAP_VECTOR) && defined(BCH_CPU_X86)
+  if (bch_cpu_has_avx2())
+    return bch_map_tweak3_avx2;
+#endif
+
+#ifdef BCH_MAP_VECTOR
+  return bch_map_tweak3_x8;
+#else
+  return bch_map_tweak3_many_scalar;
+#endif
+}
+
+// Compute bch_map_tweak3() for n = 0..count-1 in one
+// pass. The block mixing does not depend on the seed,
+// so each input word is loaded and mixed once and then
+// folded into every lane.
+void
+bch_map_tweak3_many(
+  const uint8_t *data,
+  size_t data_len,
+  uint32_t count,
+  uint32_t tweak,
+  uint32_t *out
+) {
+  assert((data || data_len == 0) && "data is null");
+  assert((out || count == 0) && "out is null");
+
+  // Too few seeds to fill a vector.
+  if (count < 4) {
+    bch_map_tweak3_many_scalar(data, data_len, count, tweak, out);
+    return;
+  }
+
+  bch_map_tweak3_many_func *impl =
+    atomic_load_explicit(&bch_map_tweak3_impl, memory_order_relaxed);
+
+  if (impl == NULL) {
+    impl = bch_map_tweak3_detect();
+    atomic_store_explicit(&bch_map_tweak3_impl, impl, memory_order_relaxed);
+  }
+
+  impl(data, data_len, count, tweak, out);
+}
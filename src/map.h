@@ -51,6 +51,16 @@ typedef struct bch_map_s {
   bch_map_hash_func hash_func;
   bch_map_equal_func equal_func;
   bch_map_free_func free_func;
+
+  // Incremental resize. While `old_flags` is set, the
+  // previous table is still live and its buckets from
+  // `old_pos` onward have not been migrated yet.
+  bool incremental;
+  uint32_t old_n_buckets;
+  uint32_t old_pos;
+  uint32_t *old_flags;
+  void **old_keys;
+  void **old_vals;
 } bch_map_t;
 
 typedef uint32_t bch_map_iter_t;
@@ -76,37 +86,59 @@ typedef uint32_t bch_map_iter_t;
 
 static const double __bch_hash_upper = 0.77;
 
+// While a migration is pending, indices past
+// bch_map_end() address the old table, so lookups
+// and iteration never have to move entries. The
+// end index itself is never a valid entry. Loops
+// run to bch_map_limit() and may remove the current
+// entry with bch_map_delete(); put/set/del can move
+// entries between tables and must not be mixed in.
+#define __bch_isold(map, i) ((i) > (map)->n_buckets)
+#define __bch_oldidx(map, i) ((i) - (map)->n_buckets - 1)
+
 #define bch_map_begin(map) ((bch_map_iter_t)0)
 #define bch_map_end(map) ((map)->n_buckets)
-#define bch_map_exists(map, i) (!__bch_iseither((map)->flags, (i)))
-#define bch_map_key(map, i) ((map)->keys[i])
-#define bch_map_value(map, i) ((map)->vals[i])
-
-#define bch_map_each(map, kvar, vvar, code)                         \
-  do {                                                              \
-    bch_map_iter_t __i;                                             \
-    for (__i = bch_map_begin(map); __i < bch_map_end(map); __i++) { \
-      if (!bch_map_exists(map, i))                                  \
-        continue;                                                   \
-                                                                    \
-      (kvar) = bch_map_key(map, __i);                               \
-      (vvar) = bch_map_value(map, __i);                             \
-                                                                    \
-      code;                                                         \
-    }                                                               \
+#define bch_map_limit(map) \
+  ((map)->n_buckets + ((map)->old_flags ? (map)->old_n_buckets + 1 : 0))
+#define bch_map_exists(map, i)                                  \
+  (__bch_isold(map, i)                                          \
+    ? !__bch_iseither((map)->old_flags, __bch_oldidx(map, i))   \
+    : ((i) < (map)->n_buckets                                   \
+       && !__bch_iseither((map)->flags, (i))))
+#define bch_map_key(map, i)                                     \
+  (__bch_isold(map, i)                                          \
+    ? (map)->old_keys[__bch_oldidx(map, i)]                     \
+    : (map)->keys[i])
+#define bch_map_value(map, i)                                   \
+  (__bch_isold(map, i)                                          \
+    ? (map)->old_vals[__bch_oldidx(map, i)]                     \
+    : (map)->vals[i])
+
+#define bch_map_each(map, kvar, vvar, code)                           \
+  do {                                                                \
+    bch_map_iter_t __i;                                               \
+    for (__i = bch_map_begin(map); __i < bch_map_limit(map); __i++) { \
+      if (!bch_map_exists(map, __i))                                  \
+        continue;                                                     \
+                                                                      \
+      (kvar) = bch_map_key(map, __i);                                 \
+      (vvar) = bch_map_value(map, __i);                               \
+                                                                      \
+      code;                                                           \
+    }                                                                 \
   } while (0)
 
-#define bch_map_each_value(map, vvar, code)                         \
-  do {                                                              \
-    bch_map_iter_t __i;                                             \
-    for (__i = bch_map_begin(map); __i < bch_map_end(map); __i++) { \
-      if (!bch_map_exists(map, i))                                  \
-        continue;                                                   \
-                                                                    \
-      (vvar) = bch_map_value(map, __i);                             \
-                                                                    \
-      code;                                                         \
-    }                                                               \
+#define bch_map_each_value(map, vvar, code)                           \
+  do {                                                                \
+    bch_map_iter_t __i;                                               \
+    for (__i = bch_map_begin(map); __i < bch_map_limit(map); __i++) { \
+      if (!bch_map_exists(map, __i))                                  \
+        continue;                                                     \
+                                                                      \
+      (vvar) = bch_map_value(map, __i);                               \
+                                                                      \
+      code;                                                           \
+    }                                                                 \
   } while (0)
 
 void
@@ -211,6 +243,12 @@ bch_map_free(bch_map_t *map);
 void
 bch_map_reset(bch_map_t *map);
 
+void
+bch_map_incremental(bch_map_t *map, bool incremental);
+
+void
+bch_map_finish_resize(bch_map_t *map);
+
 uint32_t
 bch_map_lookup(const bch_map_t *map, const void *key);
 
@@ -220,6 +258,17 @@ bch_map_resize(bch_map_t *map, uint32_t new_n_buckets);
 uint32_t
 bch_map_put(bch_map_t *map, const void *key, int *ret);
 
+bool
+bch_map_reserve(bch_map_t *map, uint32_t size);
+
+bool
+bch_map_put_many(
+  bch_map_t *map,
+  const void **keys,
+  void **vals,
+  size_t len
+);
+
 void
 bch_map_delete(bch_map_t *map, uint32_t x);
 
@@ -272,4 +321,13 @@ bch_map_tweak3(
   uint32_t n,
   uint32_t tweak
 );
+
+void
+bch_map_tweak3_many(
+  const uint8_t *data,
+  size_t data_len,
+  uint32_t count,
+  uint32_t tweak,
+  uint32_t *out
+);
 #endif
@@ -16,6 +16,7 @@
 static int hsk_secp256k1_ecdsa_sig_parse(hsk_secp256k1_scalar *r, hsk_secp256k1_scalar *s, const unsigned char *sig, size_t size);
 static int hsk_secp256k1_ecdsa_sig_serialize(unsigned char *sig, size_t *size, const hsk_secp256k1_scalar *r, const hsk_secp256k1_scalar *s);
 static int hsk_secp256k1_ecdsa_sig_verify(const hsk_secp256k1_ecmult_context *ctx, const hsk_secp256k1_scalar* r, const hsk_secp256k1_scalar* s, const hsk_secp256k1_ge *pubkey, const hsk_secp256k1_scalar *message);
+static int hsk_secp256k1_ecdsa_sig_verify_inv(const hsk_secp256k1_ecmult_context *ctx, const hsk_secp256k1_scalar* r, const hsk_secp256k1_scalar* sn, const hsk_secp256k1_ge *pubkey, const hsk_secp256k1_scalar *message);
 static int hsk_secp256k1_ecdsa_sig_sign(const hsk_secp256k1_ecmult_gen_context *ctx, hsk_secp256k1_scalar* r, hsk_secp256k1_scalar* s, const hsk_secp256k1_scalar *seckey, const hsk_secp256k1_scalar *message, const hsk_secp256k1_scalar *nonce, int *recid);
 
 #endif /* HSK_SECP256K1_ECDSA_H */
@@ -198,22 +198,19 @@ static int hsk_secp256k1_ecdsa_sig_serialize(unsigned char *sig, size_t *size, c
     return 1;
 }
 
-static int hsk_secp256k1_ecdsa_sig_verify(const hsk_secp256k1_ecmult_context *ctx, const hsk_secp256k1_scalar *sigr, const hsk_secp256k1_scalar *sigs, const hsk_secp256k1_ge *pubkey, const hsk_secp256k1_scalar *message) {
+/* Verify with sn = sigs^-1 already computed, so that callers checking many
+ * signatures can share a single inversion. sigr and sn must be nonzero. */
+static int hsk_secp256k1_ecdsa_sig_verify_inv(const hsk_secp256k1_ecmult_context *ctx, const hsk_secp256k1_scalar *sigr, const hsk_secp256k1_scalar *sn, const hsk_secp256k1_ge *pubkey, const hsk_secp256k1_scalar *message) {
     unsigned char c[32];
-    hsk_secp256k1_scalar sn, u1, u2;
+    hsk_secp256k1_scalar u1, u2;
 #if !defined(EXHAUSTIVE_TEST_ORDER)
     hsk_secp256k1_fe xr;
 #endif
     hsk_secp256k1_gej pubkeyj;
     hsk_secp256k1_gej pr;
 
-    if (hsk_secp256k1_scalar_is_zero(sigr) || hsk_secp256k1_scalar_is_zero(sigs)) {
-        return 0;
-    }
-
-    hsk_secp256k1_scalar_inverse_var(&sn, sigs);
-    hsk_secp256k1_scalar_mul(&u1, &sn, message);
-    hsk_secp256k1_scalar_mul(&u2, &sn, sigr);
+    hsk_secp256k1_scalar_mul(&u1, sn, message);
+    hsk_secp256k1_scalar_mul(&u2, sn, sigr);
     hsk_secp256k1_gej_set_ge(&pubkeyj, pubkey);
     hsk_secp256k1_ecmult(ctx, &pr, &pubkeyj, &u2, &u1);
     if (hsk_secp256k1_gej_is_infinity(&pr)) {
@@ -268,6 +265,17 @@ static int hsk_secp256k1_ecdsa_sig_verify(const hsk_secp256k1_ecmult_context *ct
 #endif
 }
 
+static int hsk_secp256k1_ecdsa_sig_verify(const hsk_secp256k1_ecmult_context *ctx, const hsk_secp256k1_scalar *sigr, const hsk_secp256k1_scalar *sigs, const hsk_secp256k1_ge *pubkey, const hsk_secp256k1_scalar *message) {
+    hsk_secp256k1_scalar sn;
+
+    if (hsk_secp256k1_scalar_is_zero(sigr) || hsk_secp256k1_scalar_is_zero(sigs)) {
+        return 0;
+    }
+
+    hsk_secp256k1_scalar_inverse_var(&sn, sigs);
+    return hsk_secp256k1_ecdsa_sig_verify_inv(ctx, sigr, &sn, pubkey, message);
+}
+
 static int hsk_secp256k1_ecdsa_sig_sign(const hsk_secp256k1_ecmult_gen_context *ctx, hsk_secp256k1_scalar *sigr, hsk_secp256k1_scalar *sigs, const hsk_secp256k1_scalar *seckey, const hsk_secp256k1_scalar *message, const hsk_secp256k1_scalar *nonce, int *recid) {
     unsigned char b[32];
     hsk_secp256k1_gej rp;
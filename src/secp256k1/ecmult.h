@@ -12,12 +12,22 @@
 #include "scalar.h"
 #include "scratch.h"
 
+#define PIPPENGER_MAX_BUCKET_WINDOW 12
+
 typedef struct {
     /* For accelerating the computation of a*P + b*G: */
     hsk_secp256k1_ge_storage (*pre_g)[];    /* odd multiples of the generator */
 #ifdef HSK_USE_ENDOMORPHISM
     hsk_secp256k1_ge_storage (*pre_g_128)[]; /* odd multiples of 2^128*generator */
 #endif
+    int window_g;    /* window size of the tables above */
+    int pre_g_owned; /* whether the tables were allocated by this context */
+    /* hsk_secp256k1_ecmult_multi_var tuning: the number of points from which
+     * Pippenger is used instead of Strauss, and the largest number of points
+     * for which each Pippenger bucket window (1..PIPPENGER_MAX_BUCKET_WINDOW)
+     * is optimal. */
+    size_t pippenger_threshold;
+    size_t pippenger_window_max[PIPPENGER_MAX_BUCKET_WINDOW];
 } hsk_secp256k1_ecmult_context;
 
 static void hsk_secp256k1_ecmult_context_init(hsk_secp256k1_ecmult_context *ctx);
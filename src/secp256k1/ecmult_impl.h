@@ -42,6 +42,29 @@
 #endif
 #endif
 
+/* The range hsk_secp256k1_ecmult_context_set_window accepts. WINDOW_G
+ * above is only the default. */
+#define ECMULT_WINDOW_G_MIN 2
+#define ECMULT_WINDOW_G_MAX 24
+#if WINDOW_G < ECMULT_WINDOW_G_MIN || WINDOW_G > ECMULT_WINDOW_G_MAX
+#error "WINDOW_G is out of range"
+#endif
+
+/* The static tables hold odd multiples of the real generator, so the
+ * exhaustive tests (which use a different one) always build theirs. */
+#if defined(HSK_USE_ECMULT_STATIC_PRECOMPUTATION) && !defined(EXHAUSTIVE_TEST_ORDER)
+#define HSK_USE_ECMULT_STATIC_PRE_G
+#include "ecmult_static_pre_g.h"
+/* Any window up to the size of the static tables just uses a prefix of
+ * them; larger ones are built at runtime. */
+#ifdef HSK_USE_ENDOMORPHISM
+#define ECMULT_STATIC_WINDOW_MAX \
+    (ECMULT_STATIC_WINDOW_G < ECMULT_STATIC_WINDOW_G_128 ? ECMULT_STATIC_WINDOW_G : ECMULT_STATIC_WINDOW_G_128)
+#else
+#define ECMULT_STATIC_WINDOW_MAX ECMULT_STATIC_WINDOW_G
+#endif
+#endif
+
 #ifdef HSK_USE_ENDOMORPHISM
     #define WNAF_BITS 128
 #else
@@ -56,15 +79,24 @@
 #define PIPPENGER_SCRATCH_OBJECTS 6
 #define STRAUSS_SCRATCH_OBJECTS 6
 
-#define PIPPENGER_MAX_BUCKET_WINDOW 12
-
-/* Minimum number of points for which pippenger_wnaf is faster than strauss wnaf */
+/* Default minimum number of points for which pippenger_wnaf is faster than
+ * strauss wnaf. Contexts can be retuned at runtime, see
+ * hsk_secp256k1_context_set_ecmult_multi. */
 #ifdef HSK_USE_ENDOMORPHISM
     #define ECMULT_PIPPENGER_THRESHOLD 88
 #else
     #define ECMULT_PIPPENGER_THRESHOLD 160
 #endif
 
+/** Default maximum optimal number of points for each bucket_window. */
+static const size_t hsk_secp256k1_pippenger_default_window_max[PIPPENGER_MAX_BUCKET_WINDOW] = {
+#ifdef HSK_USE_ENDOMORPHISM
+    1, 4, 20, 57, 136, 235, 1260, 1260, 4420, 7880, 16050, SIZE_MAX
+#else
+    1, 11, 45, 100, 275, 625, 1850, 3400, 9630, 17900, 32800, SIZE_MAX
+#endif
+};
+
 #ifdef HSK_USE_ENDOMORPHISM
     #define ECMULT_MAX_POINTS_PER_BATCH 5000000
 #else
@@ -181,63 +213,121 @@ static void hsk_secp256k1_ecmult_odd_multiples_table_storage_var(int n, hsk_secp
     } \
 } while(0)
 
-static void hsk_secp256k1_ecmult_context_init(hsk_secp256k1_ecmult_context *ctx) {
-    ctx->pre_g = NULL;
+/** Number of bytes taken by the G tables for a given window: ECMULT_TABLE_SIZE(w)
+ *  odd multiples of G, followed by as many of 2^128*G with the endomorphism. */
+static size_t hsk_secp256k1_ecmult_table_size(int window) {
+    size_t n = sizeof(hsk_secp256k1_ge_storage) * ECMULT_TABLE_SIZE(window);
 #ifdef HSK_USE_ENDOMORPHISM
-    ctx->pre_g_128 = NULL;
+    n *= 2;
 #endif
+    return n;
 }
 
-static void hsk_secp256k1_ecmult_context_build(hsk_secp256k1_ecmult_context *ctx, const hsk_secp256k1_callback *cb) {
+/** Fill a table laid out as described above. */
+static void hsk_secp256k1_ecmult_table_build(hsk_secp256k1_ge_storage *table, int window, const hsk_secp256k1_callback *cb) {
     hsk_secp256k1_gej gj;
 
-    if (ctx->pre_g != NULL) {
-        return;
-    }
-
     /* get the generator */
     hsk_secp256k1_gej_set_ge(&gj, &hsk_secp256k1_ge_const_g);
 
-    ctx->pre_g = (hsk_secp256k1_ge_storage (*)[])checked_malloc(cb, sizeof((*ctx->pre_g)[0]) * ECMULT_TABLE_SIZE(WINDOW_G));
-
     /* precompute the tables with odd multiples */
-    hsk_secp256k1_ecmult_odd_multiples_table_storage_var(ECMULT_TABLE_SIZE(WINDOW_G), *ctx->pre_g, &gj, cb);
+    hsk_secp256k1_ecmult_odd_multiples_table_storage_var(ECMULT_TABLE_SIZE(window), table, &gj, cb);
 
 #ifdef HSK_USE_ENDOMORPHISM
     {
         hsk_secp256k1_gej g_128j;
         int i;
 
-        ctx->pre_g_128 = (hsk_secp256k1_ge_storage (*)[])checked_malloc(cb, sizeof((*ctx->pre_g_128)[0]) * ECMULT_TABLE_SIZE(WINDOW_G));
-
         /* calculate 2^128*generator */
         g_128j = gj;
         for (i = 0; i < 128; i++) {
             hsk_secp256k1_gej_double_var(&g_128j, &g_128j, NULL);
         }
-        hsk_secp256k1_ecmult_odd_multiples_table_storage_var(ECMULT_TABLE_SIZE(WINDOW_G), *ctx->pre_g_128, &g_128j, cb);
+        hsk_secp256k1_ecmult_odd_multiples_table_storage_var(ECMULT_TABLE_SIZE(window), table + ECMULT_TABLE_SIZE(window), &g_128j, cb);
     }
 #endif
 }
 
-static void hsk_secp256k1_ecmult_context_clone(hsk_secp256k1_ecmult_context *dst,
-                                           const hsk_secp256k1_ecmult_context *src, const hsk_secp256k1_callback *cb) {
-    if (src->pre_g == NULL) {
-        dst->pre_g = NULL;
-    } else {
-        size_t size = sizeof((*dst->pre_g)[0]) * ECMULT_TABLE_SIZE(WINDOW_G);
-        dst->pre_g = (hsk_secp256k1_ge_storage (*)[])checked_malloc(cb, size);
-        memcpy(dst->pre_g, src->pre_g, size);
+/* Point the context at a table laid out as by hsk_secp256k1_ecmult_table_build. */
+static void hsk_secp256k1_ecmult_context_set_table(hsk_secp256k1_ecmult_context *ctx, const hsk_secp256k1_ge_storage *table, int owned) {
+    ctx->pre_g = (hsk_secp256k1_ge_storage (*)[])table;
+#ifdef HSK_USE_ENDOMORPHISM
+    ctx->pre_g_128 = (hsk_secp256k1_ge_storage (*)[])(table + ECMULT_TABLE_SIZE(ctx->window_g));
+#endif
+    ctx->pre_g_owned = owned;
+}
+
+static void hsk_secp256k1_ecmult_context_init(hsk_secp256k1_ecmult_context *ctx) {
+    ctx->pre_g = NULL;
+#ifdef HSK_USE_ENDOMORPHISM
+    ctx->pre_g_128 = NULL;
+#endif
+    ctx->pre_g_owned = 0;
+    ctx->window_g = WINDOW_G;
+    ctx->pippenger_threshold = ECMULT_PIPPENGER_THRESHOLD;
+    memcpy(ctx->pippenger_window_max, hsk_secp256k1_pippenger_default_window_max, sizeof(ctx->pippenger_window_max));
+}
+
+static void hsk_secp256k1_ecmult_context_build(hsk_secp256k1_ecmult_context *ctx, const hsk_secp256k1_callback *cb) {
+    hsk_secp256k1_ge_storage *table;
+
+    if (ctx->pre_g != NULL) {
+        return;
     }
+
+#ifdef HSK_USE_ECMULT_STATIC_PRE_G
+    /* The static tables live in read-only data, so building is free and
+     * every process mapping the library shares the same pages. */
+    if (ctx->window_g <= ECMULT_STATIC_WINDOW_MAX) {
+        ctx->pre_g = (hsk_secp256k1_ge_storage (*)[])hsk_secp256k1_ecmult_static_pre_g;
 #ifdef HSK_USE_ENDOMORPHISM
-    if (src->pre_g_128 == NULL) {
-        dst->pre_g_128 = NULL;
-    } else {
-        size_t size = sizeof((*dst->pre_g_128)[0]) * ECMULT_TABLE_SIZE(WINDOW_G);
-        dst->pre_g_128 = (hsk_secp256k1_ge_storage (*)[])checked_malloc(cb, size);
-        memcpy(dst->pre_g_128, src->pre_g_128, size);
+        ctx->pre_g_128 = (hsk_secp256k1_ge_storage (*)[])hsk_secp256k1_ecmult_static_pre_g_128;
+#endif
+        ctx->pre_g_owned = 0;
+        return;
+    }
+#endif
+
+    table = (hsk_secp256k1_ge_storage *)checked_malloc(cb, hsk_secp256k1_ecmult_table_size(ctx->window_g));
+    hsk_secp256k1_ecmult_table_build(table, ctx->window_g, cb);
+    hsk_secp256k1_ecmult_context_set_table(ctx, table, 1);
+}
+
+/** Switch the context to another window. With a NULL table the context
+ *  builds (or, for small enough windows with static precomputation, borrows)
+ *  its own; otherwise it borrows the given one, which must outlive it. */
+static void hsk_secp256k1_ecmult_context_set_window(hsk_secp256k1_ecmult_context *ctx, int window,
+                                                const hsk_secp256k1_ge_storage *table, const hsk_secp256k1_callback *cb) {
+    VERIFY_CHECK(window >= ECMULT_WINDOW_G_MIN && window <= ECMULT_WINDOW_G_MAX);
+
+    if (ctx->pre_g_owned) {
+        free(ctx->pre_g);
     }
+    ctx->pre_g = NULL;
+#ifdef HSK_USE_ENDOMORPHISM
+    ctx->pre_g_128 = NULL;
 #endif
+    ctx->pre_g_owned = 0;
+    ctx->window_g = window;
+
+    if (table != NULL) {
+        hsk_secp256k1_ecmult_context_set_table(ctx, table, 0);
+    } else {
+        hsk_secp256k1_ecmult_context_build(ctx, cb);
+    }
+}
+
+static void hsk_secp256k1_ecmult_context_clone(hsk_secp256k1_ecmult_context *dst,
+                                           const hsk_secp256k1_ecmult_context *src, const hsk_secp256k1_callback *cb) {
+    *dst = *src;
+
+    /* Borrowed tables (static or caller-provided) are shared. */
+    if (src->pre_g_owned) {
+        size_t size = hsk_secp256k1_ecmult_table_size(src->window_g);
+        hsk_secp256k1_ge_storage *table = (hsk_secp256k1_ge_storage *)checked_malloc(cb, size);
+        memcpy(table, src->pre_g, size);
+        hsk_secp256k1_ecmult_context_set_table(dst, table, 1);
+    }
 }
 
 static int hsk_secp256k1_ecmult_context_is_built(const hsk_secp256k1_ecmult_context *ctx) {
@@ -245,10 +335,9 @@ static int hsk_secp256k1_ecmult_context_is_built(const hsk_secp256k1_ecmult_cont
 }
 
 static void hsk_secp256k1_ecmult_context_clear(hsk_secp256k1_ecmult_context *ctx) {
-    free(ctx->pre_g);
-#ifdef HSK_USE_ENDOMORPHISM
-    free(ctx->pre_g_128);
-#endif
+    if (ctx->pre_g_owned) {
+        free(ctx->pre_g);
+    }
     hsk_secp256k1_ecmult_context_init(ctx);
 }
 
@@ -423,8 +512,8 @@ static void hsk_secp256k1_ecmult_strauss_wnaf(const hsk_secp256k1_ecmult_context
         hsk_secp256k1_scalar_split_128(&ng_1, &ng_128, ng);
 
         /* Build wnaf representation for ng_1 and ng_128 */
-        bits_ng_1   = hsk_secp256k1_ecmult_wnaf(wnaf_ng_1,   129, &ng_1,   WINDOW_G);
-        bits_ng_128 = hsk_secp256k1_ecmult_wnaf(wnaf_ng_128, 129, &ng_128, WINDOW_G);
+        bits_ng_1   = hsk_secp256k1_ecmult_wnaf(wnaf_ng_1,   129, &ng_1,   ctx->window_g);
+        bits_ng_128 = hsk_secp256k1_ecmult_wnaf(wnaf_ng_128, 129, &ng_128, ctx->window_g);
         if (bits_ng_1 > bits) {
             bits = bits_ng_1;
         }
@@ -434,7 +523,7 @@ static void hsk_secp256k1_ecmult_strauss_wnaf(const hsk_secp256k1_ecmult_context
     }
 #else
     if (ng) {
-        bits_ng     = hsk_secp256k1_ecmult_wnaf(wnaf_ng,     256, ng,      WINDOW_G);
+        bits_ng     = hsk_secp256k1_ecmult_wnaf(wnaf_ng,     256, ng,      ctx->window_g);
         if (bits_ng > bits) {
             bits = bits_ng;
         }
@@ -458,11 +547,11 @@ static void hsk_secp256k1_ecmult_strauss_wnaf(const hsk_secp256k1_ecmult_context
             }
         }
         if (i < bits_ng_1 && (n = wnaf_ng_1[i])) {
-            ECMULT_TABLE_GET_GE_STORAGE(&tmpa, *ctx->pre_g, n, WINDOW_G);
+            ECMULT_TABLE_GET_GE_STORAGE(&tmpa, *ctx->pre_g, n, ctx->window_g);
             hsk_secp256k1_gej_add_zinv_var(r, r, &tmpa, &Z);
         }
         if (i < bits_ng_128 && (n = wnaf_ng_128[i])) {
-            ECMULT_TABLE_GET_GE_STORAGE(&tmpa, *ctx->pre_g_128, n, WINDOW_G);
+            ECMULT_TABLE_GET_GE_STORAGE(&tmpa, *ctx->pre_g_128, n, ctx->window_g);
             hsk_secp256k1_gej_add_zinv_var(r, r, &tmpa, &Z);
         }
 #else
@@ -473,7 +562,7 @@ static void hsk_secp256k1_ecmult_strauss_wnaf(const hsk_secp256k1_ecmult_context
             }
         }
         if (i < bits_ng && (n = wnaf_ng[i])) {
-            ECMULT_TABLE_GET_GE_STORAGE(&tmpa, *ctx->pre_g, n, WINDOW_G);
+            ECMULT_TABLE_GET_GE_STORAGE(&tmpa, *ctx->pre_g, n, ctx->window_g);
             hsk_secp256k1_gej_add_zinv_var(r, r, &tmpa, &Z);
         }
 #endif
@@ -714,97 +803,26 @@ static int hsk_secp256k1_ecmult_pippenger_wnaf(hsk_secp256k1_gej *buckets, int b
  * Returns optimal bucket_window (number of bits of a scalar represented by a
  * set of buckets) for a given number of points.
  */
-static int hsk_secp256k1_pippenger_bucket_window(size_t n) {
-#ifdef HSK_USE_ENDOMORPHISM
-    if (n <= 1) {
-        return 1;
-    } else if (n <= 4) {
-        return 2;
-    } else if (n <= 20) {
-        return 3;
-    } else if (n <= 57) {
-        return 4;
-    } else if (n <= 136) {
-        return 5;
-    } else if (n <= 235) {
-        return 6;
-    } else if (n <= 1260) {
-        return 7;
-    } else if (n <= 4420) {
-        return 9;
-    } else if (n <= 7880) {
-        return 10;
-    } else if (n <= 16050) {
-        return 11;
-    } else {
-        return PIPPENGER_MAX_BUCKET_WINDOW;
-    }
-#else
-    if (n <= 1) {
-        return 1;
-    } else if (n <= 11) {
-        return 2;
-    } else if (n <= 45) {
-        return 3;
-    } else if (n <= 100) {
-        return 4;
-    } else if (n <= 275) {
-        return 5;
-    } else if (n <= 625) {
-        return 6;
-    } else if (n <= 1850) {
-        return 7;
-    } else if (n <= 3400) {
-        return 8;
-    } else if (n <= 9630) {
-        return 9;
-    } else if (n <= 17900) {
-        return 10;
-    } else if (n <= 32800) {
-        return 11;
-    } else {
-        return PIPPENGER_MAX_BUCKET_WINDOW;
+static int hsk_secp256k1_pippenger_bucket_window(const hsk_secp256k1_ecmult_context *ctx, size_t n) {
+    int bucket_window;
+    for (bucket_window = 1; bucket_window < PIPPENGER_MAX_BUCKET_WINDOW; bucket_window++) {
+        if (n <= ctx->pippenger_window_max[bucket_window - 1]) {
+            break;
+        }
     }
-#endif
+    return bucket_window;
 }
 
 /**
  * Returns the maximum optimal number of points for a bucket_window.
  */
-static size_t hsk_secp256k1_pippenger_bucket_window_inv(int bucket_window) {
-    switch(bucket_window) {
-#ifdef HSK_USE_ENDOMORPHISM
-        case 1: return 1;
-        case 2: return 4;
-        case 3: return 20;
-        case 4: return 57;
-        case 5: return 136;
-        case 6: return 235;
-        case 7: return 1260;
-        case 8: return 1260;
-        case 9: return 4420;
-        case 10: return 7880;
-        case 11: return 16050;
-        case PIPPENGER_MAX_BUCKET_WINDOW: return SIZE_MAX;
-#else
-        case 1: return 1;
-        case 2: return 11;
-        case 3: return 45;
-        case 4: return 100;
-        case 5: return 275;
-        case 6: return 625;
-        case 7: return 1850;
-        case 8: return 3400;
-        case 9: return 9630;
-        case 10: return 17900;
-        case 11: return 32800;
-        case PIPPENGER_MAX_BUCKET_WINDOW: return SIZE_MAX;
-#endif
-    }
-    return 0;
+static size_t hsk_secp256k1_pippenger_bucket_window_inv(const hsk_secp256k1_ecmult_context *ctx, int bucket_window) {
+    if (bucket_window < 1 || bucket_window > PIPPENGER_MAX_BUCKET_WINDOW) {
+        return 0;
+    }
+    return ctx->pippenger_window_max[bucket_window - 1];
 }
 
-
 #ifdef HSK_USE_ENDOMORPHISM
 HSK_SECP256K1_INLINE static void hsk_secp256k1_ecmult_endo_split(hsk_secp256k1_scalar *s1, hsk_secp256k1_scalar *s2, hsk_secp256k1_ge *p1, hsk_secp256k1_ge *p2) {
     hsk_secp256k1_scalar tmp = *s1;
@@ -854,13 +872,12 @@ static int hsk_secp256k1_ecmult_pippenger_batch(const hsk_secp256k1_ecmult_conte
     int i, j;
     int bucket_window;
 
-    (void)ctx;
     hsk_secp256k1_gej_set_infinity(r);
     if (inp_g_sc == NULL && n_points == 0) {
         return 1;
     }
 
-    bucket_window = hsk_secp256k1_pippenger_bucket_window(n_points);
+    bucket_window = hsk_secp256k1_pippenger_bucket_window(ctx, n_points);
     if (!hsk_secp256k1_scratch_resize(scratch, hsk_secp256k1_pippenger_scratch_size(n_points, bucket_window), PIPPENGER_SCRATCH_OBJECTS)) {
         return 0;
     }
@@ -920,14 +937,14 @@ static int hsk_secp256k1_ecmult_pippenger_batch_single(const hsk_secp256k1_ecmul
  * a given scratch space. The function ensures that fewer points may also be
  * used.
  */
-static size_t hsk_secp256k1_pippenger_max_points(hsk_secp256k1_scratch *scratch) {
+static size_t hsk_secp256k1_pippenger_max_points(const hsk_secp256k1_ecmult_context *ctx, hsk_secp256k1_scratch *scratch) {
     size_t max_alloc = hsk_secp256k1_scratch_max_allocation(scratch, PIPPENGER_SCRATCH_OBJECTS);
     int bucket_window;
     size_t res = 0;
 
     for (bucket_window = 1; bucket_window <= PIPPENGER_MAX_BUCKET_WINDOW; bucket_window++) {
         size_t n_points;
-        size_t max_points = hsk_secp256k1_pippenger_bucket_window_inv(bucket_window);
+        size_t max_points = hsk_secp256k1_pippenger_bucket_window_inv(ctx, bucket_window);
         size_t space_for_points;
         size_t space_overhead;
         size_t entry_size = sizeof(hsk_secp256k1_ge) + sizeof(hsk_secp256k1_scalar) + sizeof(struct hsk_secp256k1_pippenger_point_state) + (WNAF_SIZE(bucket_window+1)+1)*sizeof(int);
@@ -975,7 +992,7 @@ static int hsk_secp256k1_ecmult_multi_var(const hsk_secp256k1_ecmult_context *ct
         return 1;
     }
 
-    max_points = hsk_secp256k1_pippenger_max_points(scratch);
+    max_points = hsk_secp256k1_pippenger_max_points(ctx, scratch);
     if (max_points == 0) {
         return 0;
     } else if (max_points > ECMULT_MAX_POINTS_PER_BATCH) {
@@ -984,7 +1001,7 @@ static int hsk_secp256k1_ecmult_multi_var(const hsk_secp256k1_ecmult_context *ct
     n_batches = (n+max_points-1)/max_points;
     n_batch_points = (n+n_batches-1)/n_batches;
 
-    if (n_batch_points >= ECMULT_PIPPENGER_THRESHOLD) {
+    if (n_batch_points >= ctx->pippenger_threshold) {
         f = hsk_secp256k1_ecmult_pippenger_batch;
     } else {
         max_points = hsk_secp256k1_strauss_max_points(scratch);
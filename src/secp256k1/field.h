@@ -102,6 +102,15 @@ static void hsk_secp256k1_fe_sqr(hsk_secp256k1_fe *r, const hsk_secp256k1_fe *a)
  *  itself. */
 static int hsk_secp256k1_fe_sqrt(hsk_secp256k1_fe *r, const hsk_secp256k1_fe *a);
 
+/** Number of square roots hsk_secp256k1_fe_sqrt_all computes in lockstep. */
+#define FE_SQRT_LANES 4
+
+/** Compute hsk_secp256k1_fe_sqrt of a batch of field elements, setting ret[i] to
+ *  its return value for each. The addition chains of up to FE_SQRT_LANES
+ *  elements run in lockstep, so their independent multiplications overlap.
+ *  The inputs and outputs must not overlap in memory. */
+static void hsk_secp256k1_fe_sqrt_all(int *ret, hsk_secp256k1_fe *r, const hsk_secp256k1_fe *a, size_t len);
+
 /** Checks whether a field element is a quadratic residue. */
 static int hsk_secp256k1_fe_is_quad_var(const hsk_secp256k1_fe *a);
 
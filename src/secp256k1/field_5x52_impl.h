@@ -14,6 +14,7 @@
 #include "util.h"
 #include "num.h"
 #include "field.h"
+#include "modinv64_impl.h"
 
 #if defined(HSK_USE_ASM_X86_64)
 #include "field_5x52_asm_impl.h"
@@ -493,4 +494,65 @@ static HSK_SECP256K1_INLINE void hsk_secp256k1_fe_from_storage(hsk_secp256k1_fe
 #endif
 }
 
+static void hsk_secp256k1_fe_from_signed62(hsk_secp256k1_fe *r, const hsk_secp256k1_modinv64_signed62 *a) {
+    const uint64_t M52 = UINT64_MAX >> 12;
+    const uint64_t a0 = a->v[0], a1 = a->v[1], a2 = a->v[2], a3 = a->v[3], a4 = a->v[4];
+
+    /* The output from hsk_secp256k1_modinv64_var is normalized to range [0,modulus), and
+     * have limbs in [0,2^62). The modulus is < 2^256, so the top limb must be below 2^(256-62*4).
+     */
+    VERIFY_CHECK(a0 >> 62 == 0);
+    VERIFY_CHECK(a1 >> 62 == 0);
+    VERIFY_CHECK(a2 >> 62 == 0);
+    VERIFY_CHECK(a3 >> 62 == 0);
+    VERIFY_CHECK(a4 >> 8 == 0);
+
+    r->n[0] =  a0                   & M52;
+    r->n[1] = (a0 >> 52 | a1 << 10) & M52;
+    r->n[2] = (a1 >> 42 | a2 << 20) & M52;
+    r->n[3] = (a2 >> 32 | a3 << 30) & M52;
+    r->n[4] = (a3 >> 22 | a4 << 40);
+
+#ifdef VERIFY
+    r->magnitude = 1;
+    r->normalized = 1;
+    hsk_secp256k1_fe_verify(r);
+#endif
+}
+
+static void hsk_secp256k1_fe_to_signed62(hsk_secp256k1_modinv64_signed62 *r, const hsk_secp256k1_fe *a) {
+    const uint64_t M62 = UINT64_MAX >> 2;
+    const uint64_t a0 = a->n[0], a1 = a->n[1], a2 = a->n[2], a3 = a->n[3], a4 = a->n[4];
+
+#ifdef VERIFY
+    VERIFY_CHECK(a->normalized);
+#endif
+
+    r->v[0] = (a0       | a1 << 52) & M62;
+    r->v[1] = (a1 >> 10 | a2 << 42) & M62;
+    r->v[2] = (a2 >> 20 | a3 << 32) & M62;
+    r->v[3] = (a3 >> 30 | a4 << 22) & M62;
+    r->v[4] =  a4 >> 40;
+}
+
+static const hsk_secp256k1_modinv64_modinfo hsk_secp256k1_const_modinfo_fe = {
+    {{-0x1000003D1LL, 0, 0, 0, 256}},
+    0x27C7F6E22DDACACFLL
+};
+
+static void hsk_secp256k1_fe_inv_var(hsk_secp256k1_fe *r, const hsk_secp256k1_fe *x) {
+    hsk_secp256k1_fe tmp;
+    hsk_secp256k1_modinv64_signed62 s;
+
+    tmp = *x;
+    hsk_secp256k1_fe_normalize_var(&tmp);
+    hsk_secp256k1_fe_to_signed62(&s, &tmp);
+    hsk_secp256k1_modinv64_var(&s, &hsk_secp256k1_const_modinfo_fe);
+    hsk_secp256k1_fe_from_signed62(r, &s);
+
+#ifdef VERIFY
+    VERIFY_CHECK(hsk_secp256k1_fe_normalizes_to_zero(r) == hsk_secp256k1_fe_normalizes_to_zero(&tmp));
+#endif
+}
+
 #endif /* HSK_SECP256K1_FIELD_REPR_IMPL_H */
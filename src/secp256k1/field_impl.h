@@ -11,6 +11,8 @@
 #include "config.h"
 #endif
 
+#include <string.h>
+
 #include "util.h"
 
 #if defined(HSK_USE_FIELD_10X26)
@@ -133,6 +135,93 @@ static int hsk_secp256k1_fe_sqrt(hsk_secp256k1_fe *r, const hsk_secp256k1_fe *a)
     return hsk_secp256k1_fe_equal(&t1, a);
 }
 
+/* r[i] = r[i]^(2^k) for each lane */
+static void hsk_secp256k1_fe_sqr_lanes(hsk_secp256k1_fe *r, int k, size_t n) {
+    size_t i;
+    int j;
+    for (j = 0; j < k; j++) {
+        for (i = 0; i < n; i++) {
+            hsk_secp256k1_fe_sqr(&r[i], &r[i]);
+        }
+    }
+}
+
+/* r[i] = r[i] * a[i] for each lane */
+static void hsk_secp256k1_fe_mul_lanes(hsk_secp256k1_fe *r, const hsk_secp256k1_fe *a, size_t n) {
+    size_t i;
+    for (i = 0; i < n; i++) {
+        hsk_secp256k1_fe_mul(&r[i], &r[i], &a[i]);
+    }
+}
+
+static void hsk_secp256k1_fe_sqrt_all(int *ret, hsk_secp256k1_fe *r, const hsk_secp256k1_fe *a, size_t len) {
+    /* The same addition chain as hsk_secp256k1_fe_sqrt. */
+    hsk_secp256k1_fe x2[FE_SQRT_LANES], x3[FE_SQRT_LANES], x11[FE_SQRT_LANES];
+    hsk_secp256k1_fe x22[FE_SQRT_LANES], x44[FE_SQRT_LANES], x88[FE_SQRT_LANES];
+    hsk_secp256k1_fe t1[FE_SQRT_LANES];
+    size_t i, n;
+
+    VERIFY_CHECK(r + len <= a || a + len <= r);
+
+    for (; len > 0; len -= n, r += n, a += n, ret += n) {
+        n = len < FE_SQRT_LANES ? len : FE_SQRT_LANES;
+
+        for (i = 0; i < n; i++) {
+            hsk_secp256k1_fe_sqr(&x2[i], &a[i]);
+        }
+        hsk_secp256k1_fe_mul_lanes(x2, a, n);
+
+        for (i = 0; i < n; i++) {
+            hsk_secp256k1_fe_sqr(&x3[i], &x2[i]);
+        }
+        hsk_secp256k1_fe_mul_lanes(x3, a, n);
+
+        /* x6, x9, x11 */
+        memcpy(t1, x3, n * sizeof(t1[0]));
+        hsk_secp256k1_fe_sqr_lanes(t1, 3, n);
+        hsk_secp256k1_fe_mul_lanes(t1, x3, n);
+        hsk_secp256k1_fe_sqr_lanes(t1, 3, n);
+        hsk_secp256k1_fe_mul_lanes(t1, x3, n);
+        hsk_secp256k1_fe_sqr_lanes(t1, 2, n);
+        hsk_secp256k1_fe_mul_lanes(t1, x2, n);
+        memcpy(x11, t1, n * sizeof(t1[0]));
+
+        hsk_secp256k1_fe_sqr_lanes(t1, 11, n);
+        hsk_secp256k1_fe_mul_lanes(t1, x11, n);
+        memcpy(x22, t1, n * sizeof(t1[0]));
+
+        hsk_secp256k1_fe_sqr_lanes(t1, 22, n);
+        hsk_secp256k1_fe_mul_lanes(t1, x22, n);
+        memcpy(x44, t1, n * sizeof(t1[0]));
+
+        hsk_secp256k1_fe_sqr_lanes(t1, 44, n);
+        hsk_secp256k1_fe_mul_lanes(t1, x44, n);
+        memcpy(x88, t1, n * sizeof(t1[0]));
+
+        /* x176, x220, x223 */
+        hsk_secp256k1_fe_sqr_lanes(t1, 88, n);
+        hsk_secp256k1_fe_mul_lanes(t1, x88, n);
+        hsk_secp256k1_fe_sqr_lanes(t1, 44, n);
+        hsk_secp256k1_fe_mul_lanes(t1, x44, n);
+        hsk_secp256k1_fe_sqr_lanes(t1, 3, n);
+        hsk_secp256k1_fe_mul_lanes(t1, x3, n);
+
+        /* The final result is then assembled using a sliding window over the blocks. */
+        hsk_secp256k1_fe_sqr_lanes(t1, 23, n);
+        hsk_secp256k1_fe_mul_lanes(t1, x22, n);
+        hsk_secp256k1_fe_sqr_lanes(t1, 6, n);
+        hsk_secp256k1_fe_mul_lanes(t1, x2, n);
+        hsk_secp256k1_fe_sqr_lanes(t1, 2, n);
+
+        /* Check that square roots were actually calculated */
+        for (i = 0; i < n; i++) {
+            r[i] = t1[i];
+            hsk_secp256k1_fe_sqr(&t1[i], &r[i]);
+            ret[i] = hsk_secp256k1_fe_equal(&t1[i], &a[i]);
+        }
+    }
+}
+
 static void hsk_secp256k1_fe_inv(hsk_secp256k1_fe *r, const hsk_secp256k1_fe *a) {
     hsk_secp256k1_fe x2, x3, x6, x9, x11, x22, x44, x88, x176, x220, x223, t1;
     int j;
@@ -223,9 +312,12 @@ static void hsk_secp256k1_fe_inv(hsk_secp256k1_fe *r, const hsk_secp256k1_fe *a)
     hsk_secp256k1_fe_mul(r, a, &t1);
 }
 
+#ifndef HSK_USE_FIELD_5X52
+/* The 5x52 representation provides a safegcd-based variable-time inverse. */
 static void hsk_secp256k1_fe_inv_var(hsk_secp256k1_fe *r, const hsk_secp256k1_fe *a) {
   hsk_secp256k1_fe_inv(r, a);
 }
+#endif
 
 static void hsk_secp256k1_fe_inv_all_var(hsk_secp256k1_fe *r, const hsk_secp256k1_fe *a, size_t len) {
     hsk_secp256k1_fe u;
@@ -0,0 +1,96 @@
+/**********************************************************************
+ * Copyright (c) 2013, 2014, 2015 Thomas Daede, Cory Fields           *
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+/* Generates ecmult_static_pre_g.h, the static odd-multiples tables used by
+ * hsk_secp256k1_ecmult when HSK_USE_ECMULT_STATIC_PRECOMPUTATION is defined.
+ *
+ * Build with the same field/scalar flags as the library, for example:
+ *
+ *   cc -O2 -DHSK_USE_FIELD_5X52 -DHSK_USE_SCALAR_4X64 -DHAVE___INT128 \
+ *     -o gen_ecmult_static_pre_g gen_ecmult_static_pre_g.c
+ *   ./gen_ecmult_static_pre_g > ecmult_static_pre_g.h
+ *
+ * The output does not depend on the field representation or on
+ * HSK_USE_ENDOMORPHISM. */
+
+#include <stdio.h>
+
+/* The tables are what we are generating. */
+#undef HSK_USE_ECMULT_STATIC_PRECOMPUTATION
+
+#include "secp256k1.h"
+#include "util.h"
+#include "num_impl.h"
+#include "field_impl.h"
+#include "scalar_impl.h"
+#include "group_impl.h"
+#include "scratch_impl.h"
+#include "ecmult_impl.h"
+
+/* Window of the pre_g table. Any smaller window uses a prefix of it. */
+#define STATIC_WINDOW_G 16
+
+/* Window of the pre_g_128 table, only used with the endomorphism. */
+#define STATIC_WINDOW_G_128 15
+
+static void default_error_callback_fn(const char* str, void* data) {
+    (void)data;
+    fprintf(stderr, "[libsecp256k1] internal consistency check failed: %s\n", str);
+    abort();
+}
+
+static const hsk_secp256k1_callback default_error_callback = {
+    default_error_callback_fn,
+    NULL
+};
+
+static void print_table(FILE *fp, const char *name, int window, const hsk_secp256k1_gej *gj) {
+    int n = ECMULT_TABLE_SIZE(window);
+    hsk_secp256k1_ge_storage *table;
+    int i;
+
+    table = (hsk_secp256k1_ge_storage *)checked_malloc(&default_error_callback, sizeof(*table) * n);
+    hsk_secp256k1_ecmult_odd_multiples_table_storage_var(n, table, gj, &default_error_callback);
+
+    fprintf(fp, "static const hsk_secp256k1_ge_storage %s[%d] = {\n", name, n);
+    for (i = 0; i < n; i++) {
+        fprintf(fp, "    SC(%uu, %uu, %uu, %uu, %uu, %uu, %uu, %uu, %uu, %uu, %uu, %uu, %uu, %uu, %uu, %uu)",
+                HSK_SECP256K1_GE_STORAGE_CONST_GET(table[i]));
+        fprintf(fp, i != n - 1 ? ",\n" : "\n");
+    }
+    fprintf(fp, "};\n");
+
+    free(table);
+}
+
+int main(void) {
+    hsk_secp256k1_gej gj, g_128j;
+    FILE *fp = stdout;
+    int i;
+
+    hsk_secp256k1_gej_set_ge(&gj, &hsk_secp256k1_ge_const_g);
+
+    g_128j = gj;
+    for (i = 0; i < 128; i++) {
+        hsk_secp256k1_gej_double_var(&g_128j, &g_128j, NULL);
+    }
+
+    fprintf(fp, "#ifndef _HSK_SECP256K1_ECMULT_STATIC_PRE_G_\n");
+    fprintf(fp, "#define _HSK_SECP256K1_ECMULT_STATIC_PRE_G_\n");
+    fprintf(fp, "/* Generated by gen_ecmult_static_pre_g.c; do not edit. */\n");
+    fprintf(fp, "#include \"group.h\"\n");
+    fprintf(fp, "#define ECMULT_STATIC_WINDOW_G %d\n", STATIC_WINDOW_G);
+    fprintf(fp, "#define ECMULT_STATIC_WINDOW_G_128 %d\n", STATIC_WINDOW_G_128);
+    fprintf(fp, "#define SC HSK_SECP256K1_GE_STORAGE_CONST\n");
+    print_table(fp, "hsk_secp256k1_ecmult_static_pre_g", STATIC_WINDOW_G, &gj);
+    fprintf(fp, "#ifdef HSK_USE_ENDOMORPHISM\n");
+    print_table(fp, "hsk_secp256k1_ecmult_static_pre_g_128", STATIC_WINDOW_G_128, &g_128j);
+    fprintf(fp, "#endif\n");
+    fprintf(fp, "#undef SC\n");
+    fprintf(fp, "#endif\n");
+
+    return 0;
+}
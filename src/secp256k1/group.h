@@ -53,6 +53,10 @@ static int hsk_secp256k1_ge_set_xquad(hsk_secp256k1_ge *r, const hsk_secp256k1_f
  *  for Y. Return value indicates whether the result is valid. */
 static int hsk_secp256k1_ge_set_xo_var(hsk_secp256k1_ge *r, const hsk_secp256k1_fe *x, int odd);
 
+/** Set a batch of group elements as by hsk_secp256k1_ge_set_xo_var, setting ret[i]
+ *  to its return value for each. The square roots are computed together. */
+static void hsk_secp256k1_ge_set_xo_all_var(int *ret, hsk_secp256k1_ge *r, const hsk_secp256k1_fe *x, const int *odd, size_t len);
+
 /** Check whether a group element is the point at infinity. */
 static int hsk_secp256k1_ge_is_infinity(const hsk_secp256k1_ge *a);
 
@@ -158,7 +158,7 @@ static void hsk_secp256k1_ge_set_table_gej_var(hsk_secp256k1_ge *r, const hsk_se
 
     if (len > 0) {
         /* Compute the inverse of the last z coordinate, and use it to compute the last affine output. */
-        hsk_secp256k1_fe_inv(&zi, &a[i].z);
+        hsk_secp256k1_fe_inv_var(&zi, &a[i].z);
         hsk_secp256k1_ge_set_gej_zinv(&r[i], &a[i], &zi);
 
         /* Work out way backwards, using the z-ratios to scale the x/y values. */
@@ -242,6 +242,36 @@ static int hsk_secp256k1_ge_set_xo_var(hsk_secp256k1_ge *r, const hsk_secp256k1_
 
 }
 
+static void hsk_secp256k1_ge_set_xo_all_var(int *ret, hsk_secp256k1_ge *r, const hsk_secp256k1_fe *x, const int *odd, size_t len) {
+    hsk_secp256k1_fe c[FE_SQRT_LANES];
+    hsk_secp256k1_fe y[FE_SQRT_LANES];
+    size_t i, n;
+
+    for (; len > 0; len -= n, ret += n, r += n, x += n, odd += n) {
+        n = len < FE_SQRT_LANES ? len : FE_SQRT_LANES;
+
+        for (i = 0; i < n; i++) {
+            hsk_secp256k1_fe x2, x3;
+            hsk_secp256k1_fe_sqr(&x2, &x[i]);
+            hsk_secp256k1_fe_mul(&x3, &x[i], &x2);
+            hsk_secp256k1_fe_set_int(&c[i], CURVE_B);
+            hsk_secp256k1_fe_add(&c[i], &x3);
+        }
+
+        hsk_secp256k1_fe_sqrt_all(ret, y, c, n);
+
+        for (i = 0; i < n; i++) {
+            r[i].x = x[i];
+            r[i].y = y[i];
+            r[i].infinity = 0;
+            hsk_secp256k1_fe_normalize_var(&r[i].y);
+            if (hsk_secp256k1_fe_is_odd(&r[i].y) != odd[i]) {
+                hsk_secp256k1_fe_negate(&r[i].y, &r[i].y, 1);
+            }
+        }
+    }
+}
+
 static void hsk_secp256k1_gej_set_ge(hsk_secp256k1_gej *r, const hsk_secp256k1_ge *a) {
    r->infinity = a->infinity;
    r->x = a->x;
@@ -13,6 +13,28 @@
 #include <stdint.h>
 #include <string.h>
 
+#if defined(__GNUC__) && defined(__x86_64__)
+# define HSK_SECP256K1_SHA256_SHANI
+# include <cpuid.h>
+# include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) && defined(__aarch64__) && (defined(__linux__) || defined(__APPLE__))
+# define HSK_SECP256K1_SHA256_ARMV8
+# include <arm_neon.h>
+# if defined(__linux__)
+#  include <sys/auxv.h>
+#  ifndef HWCAP_SHA2
+#   define HWCAP_SHA2 (1 << 6)
+#  endif
+# endif
+# if defined(__clang__)
+#  define HSK_SECP256K1_ARMV8_TARGET __attribute__((target("crypto")))
+# else
+#  define HSK_SECP256K1_ARMV8_TARGET __attribute__((target("+crypto")))
+# endif
+#endif
+
 #define Ch(x,y,z) ((z) ^ ((x) & ((y) ^ (z))))
 #define Maj(x,y,z) (((x) & (y)) | ((z) & ((x) | (y))))
 #define Sigma0(x) (((x) >> 2 | (x) << 30) ^ ((x) >> 13 | (x) << 19) ^ ((x) >> 22 | (x) << 10))
@@ -46,7 +68,7 @@ static void hsk_secp256k1_sha256_initialize(hsk_secp256k1_sha256 *hash) {
 }
 
 /** Perform one SHA-256 transformation, processing 16 big endian 32-bit words. */
-static void hsk_secp256k1_sha256_transform(uint32_t* s, const uint32_t* chunk) {
+static void hsk_secp256k1_sha256_transform_block(uint32_t* s, const uint32_t* chunk) {
     uint32_t a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
     uint32_t w0, w1, w2, w3, w4, w5, w6, w7, w8, w9, w10, w11, w12, w13, w14, w15;
 
@@ -128,18 +150,233 @@ static void hsk_secp256k1_sha256_transform(uint32_t* s, const uint32_t* chunk) {
     s[7] += h;
 }
 
+/* Transform backends. Each one processes `blocks` consecutive 64 byte
+ * blocks of the same message, so hardware implementations can keep the
+ * state in registers between blocks. The backend is chosen on first use;
+ * the portable round loop above is the fallback.
+ */
+typedef void (*hsk_secp256k1_sha256_transform_fn)(uint32_t *s, const unsigned char *chunk, size_t blocks);
+
+static void hsk_secp256k1_sha256_transform_generic(uint32_t *s, const unsigned char *chunk, size_t blocks) {
+    uint32_t buf[16];
+    while (blocks--) {
+        memcpy(buf, chunk, 64);
+        hsk_secp256k1_sha256_transform_block(s, buf);
+        chunk += 64;
+    }
+}
+
+#if defined(HSK_SECP256K1_SHA256_SHANI) || defined(HSK_SECP256K1_SHA256_ARMV8)
+static const uint32_t hsk_secp256k1_sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+#endif
+
+#if defined(HSK_SECP256K1_SHA256_SHANI)
+/* Four rounds. The state is kept in the ABEF/CDGH layout sha256rnds2 expects. */
+#define SHANI_QROUND(s0, s1, m, i) do { \
+    __m128i msg_ = _mm_add_epi32((m), _mm_loadu_si128((const __m128i*)&hsk_secp256k1_sha256_k[(i)])); \
+    (s1) = _mm_sha256rnds2_epu32((s1), (s0), msg_); \
+    (s0) = _mm_sha256rnds2_epu32((s0), (s1), _mm_shuffle_epi32(msg_, 0x0e)); \
+} while(0)
+
+#define SHANI_MSG1(m0, m1) ((m0) = _mm_sha256msg1_epu32((m0), (m1)))
+#define SHANI_MSG2(m0, m1, m2) ((m2) = _mm_sha256msg2_epu32(_mm_add_epi32((m2), _mm_alignr_epi8((m1), (m0), 4)), (m1)))
+
+__attribute__((target("sha,sse4.1")))
+static void hsk_secp256k1_sha256_transform_shani(uint32_t *s, const unsigned char *chunk, size_t blocks) {
+    const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bull, 0x0405060700010203ull);
+    __m128i m0, m1, m2, m3, s0, s1, so0, so1, t1, t2;
+
+    /* ABCD/EFGH -> ABEF/CDGH */
+    s0 = _mm_loadu_si128((const __m128i*)s);
+    s1 = _mm_loadu_si128((const __m128i*)(s + 4));
+    t1 = _mm_shuffle_epi32(s0, 0xb1);
+    t2 = _mm_shuffle_epi32(s1, 0x1b);
+    s0 = _mm_alignr_epi8(t1, t2, 0x08);
+    s1 = _mm_blend_epi16(t2, t1, 0xf0);
+
+    while (blocks--) {
+        so0 = s0;
+        so1 = s1;
+
+        m0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)chunk), mask);
+        SHANI_QROUND(s0, s1, m0, 0);
+        m1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(chunk + 16)), mask);
+        SHANI_QROUND(s0, s1, m1, 4);
+        SHANI_MSG1(m0, m1);
+        m2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(chunk + 32)), mask);
+        SHANI_QROUND(s0, s1, m2, 8);
+        SHANI_MSG1(m1, m2);
+        m3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(chunk + 48)), mask);
+        SHANI_QROUND(s0, s1, m3, 12);
+        SHANI_MSG2(m2, m3, m0); SHANI_MSG1(m2, m3);
+        SHANI_QROUND(s0, s1, m0, 16);
+        SHANI_MSG2(m3, m0, m1); SHANI_MSG1(m3, m0);
+        SHANI_QROUND(s0, s1, m1, 20);
+        SHANI_MSG2(m0, m1, m2); SHANI_MSG1(m0, m1);
+        SHANI_QROUND(s0, s1, m2, 24);
+        SHANI_MSG2(m1, m2, m3); SHANI_MSG1(m1, m2);
+        SHANI_QROUND(s0, s1, m3, 28);
+        SHANI_MSG2(m2, m3, m0); SHANI_MSG1(m2, m3);
+        SHANI_QROUND(s0, s1, m0, 32);
+        SHANI_MSG2(m3, m0, m1); SHANI_MSG1(m3, m0);
+        SHANI_QROUND(s0, s1, m1, 36);
+        SHANI_MSG2(m0, m1, m2); SHANI_MSG1(m0, m1);
+        SHANI_QROUND(s0, s1, m2, 40);
+        SHANI_MSG2(m1, m2, m3); SHANI_MSG1(m1, m2);
+        SHANI_QROUND(s0, s1, m3, 44);
+        SHANI_MSG2(m2, m3, m0); SHANI_MSG1(m2, m3);
+        SHANI_QROUND(s0, s1, m0, 48);
+        SHANI_MSG2(m3, m0, m1); SHANI_MSG1(m3, m0);
+        SHANI_QROUND(s0, s1, m1, 52);
+        SHANI_MSG2(m0, m1, m2);
+        SHANI_QROUND(s0, s1, m2, 56);
+        SHANI_MSG2(m1, m2, m3);
+        SHANI_QROUND(s0, s1, m3, 60);
+
+        s0 = _mm_add_epi32(s0, so0);
+        s1 = _mm_add_epi32(s1, so1);
+        chunk += 64;
+    }
+
+    /* ABEF/CDGH -> ABCD/EFGH */
+    t1 = _mm_shuffle_epi32(s0, 0x1b);
+    t2 = _mm_shuffle_epi32(s1, 0xb1);
+    s0 = _mm_blend_epi16(t1, t2, 0xf0);
+    s1 = _mm_alignr_epi8(t2, t1, 0x08);
+    _mm_storeu_si128((__m128i*)s, s0);
+    _mm_storeu_si128((__m128i*)(s + 4), s1);
+}
+
+#undef SHANI_QROUND
+#undef SHANI_MSG1
+#undef SHANI_MSG2
+
+static int hsk_secp256k1_sha256_has_shani(void) {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !((ecx >> 19) & 1)) {
+        return 0; /* No SSE4.1. */
+    }
+    if (__get_cpuid_max(0, NULL) < 7) {
+        return 0;
+    }
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    return (ebx >> 29) & 1;
+}
+#endif
+
+#if defined(HSK_SECP256K1_SHA256_ARMV8)
+HSK_SECP256K1_ARMV8_TARGET
+static void hsk_secp256k1_sha256_transform_armv8(uint32_t *s, const unsigned char *chunk, size_t blocks) {
+    uint32x4_t s0, s1, so0, so1, t0, t1;
+    uint32x4_t m[4];
+    int i;
+
+    s0 = vld1q_u32(&s[0]);
+    s1 = vld1q_u32(&s[4]);
+
+    while (blocks--) {
+        so0 = s0;
+        so1 = s1;
+
+        for (i = 0; i < 4; i++) {
+            m[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(chunk + 16 * i)));
+        }
+
+        /* Sixteen groups of four rounds. The message schedule for
+         * group i + 4 is produced while group i runs. */
+        for (i = 0; i < 16; i++) {
+            t0 = vaddq_u32(m[i & 3], vld1q_u32(&hsk_secp256k1_sha256_k[4 * i]));
+            if (i < 12) {
+                m[i & 3] = vsha256su0q_u32(m[i & 3], m[(i + 1) & 3]);
+            }
+            t1 = s0;
+            s0 = vsha256hq_u32(s0, s1, t0);
+            s1 = vsha256h2q_u32(s1, t1, t0);
+            if (i < 12) {
+                m[i & 3] = vsha256su1q_u32(m[i & 3], m[(i + 2) & 3], m[(i + 3) & 3]);
+            }
+        }
+
+        s0 = vaddq_u32(s0, so0);
+        s1 = vaddq_u32(s1, so1);
+        chunk += 64;
+    }
+
+    vst1q_u32(&s[0], s0);
+    vst1q_u32(&s[4], s1);
+}
+
+static int hsk_secp256k1_sha256_has_armv8(void) {
+#if defined(__APPLE__)
+    return 1;
+#else
+    return (getauxval(AT_HWCAP) & HWCAP_SHA2) != 0;
+#endif
+}
+#endif
+
+#if defined(HSK_SECP256K1_SHA256_SHANI) || defined(HSK_SECP256K1_SHA256_ARMV8)
+/* Several threads may select the backend at once. They all store the
+ * same pointer, so relaxed atomic accesses are enough to keep the
+ * selection race-free. */
+static hsk_secp256k1_sha256_transform_fn hsk_secp256k1_sha256_transform_impl = NULL;
+
+static hsk_secp256k1_sha256_transform_fn hsk_secp256k1_sha256_select(void) {
+#if defined(HSK_SECP256K1_SHA256_SHANI)
+    if (hsk_secp256k1_sha256_has_shani()) {
+        return hsk_secp256k1_sha256_transform_shani;
+    }
+#endif
+#if defined(HSK_SECP256K1_SHA256_ARMV8)
+    if (hsk_secp256k1_sha256_has_armv8()) {
+        return hsk_secp256k1_sha256_transform_armv8;
+    }
+#endif
+    return hsk_secp256k1_sha256_transform_generic;
+}
+
+static void hsk_secp256k1_sha256_transform(uint32_t *s, const unsigned char *chunk, size_t blocks) {
+    hsk_secp256k1_sha256_transform_fn impl = __atomic_load_n(&hsk_secp256k1_sha256_transform_impl, __ATOMIC_RELAXED);
+    if (impl == NULL) {
+        impl = hsk_secp256k1_sha256_select();
+        __atomic_store_n(&hsk_secp256k1_sha256_transform_impl, impl, __ATOMIC_RELAXED);
+    }
+    impl(s, chunk, blocks);
+}
+#else
+static void hsk_secp256k1_sha256_transform(uint32_t *s, const unsigned char *chunk, size_t blocks) {
+    hsk_secp256k1_sha256_transform_generic(s, chunk, blocks);
+}
+#endif
+
 static void hsk_secp256k1_sha256_write(hsk_secp256k1_sha256 *hash, const unsigned char *data, size_t len) {
     size_t bufsize = hash->bytes & 0x3F;
     hash->bytes += len;
-    while (bufsize + len >= 64) {
+    if (bufsize != 0 && bufsize + len >= 64) {
         /* Fill the buffer, and process it. */
         size_t chunk_len = 64 - bufsize;
         memcpy(((unsigned char*)hash->buf) + bufsize, data, chunk_len);
         data += chunk_len;
         len -= chunk_len;
-        hsk_secp256k1_sha256_transform(hash->s, hash->buf);
+        hsk_secp256k1_sha256_transform(hash->s, (const unsigned char*)hash->buf, 1);
         bufsize = 0;
     }
+    if (len >= 64) {
+        /* Process whole blocks straight from the input. */
+        size_t blocks = len >> 6;
+        hsk_secp256k1_sha256_transform(hash->s, data, blocks);
+        data += blocks << 6;
+        len -= blocks << 6;
+    }
     if (len) {
         /* Fill the buffer with what remains. */
         memcpy(((unsigned char*)hash->buf) + bufsize, data, len);
@@ -0,0 +1,46 @@
+/**********************************************************************
+ * Copyright (c) 2020 Peter Dettman                                   *
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+#ifndef HSK_SECP256K1_MODINV64_H
+#define HSK_SECP256K1_MODINV64_H
+
+#if defined HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "util.h"
+
+#ifndef HAVE___INT128
+#error "modinv64 requires 128-bit integer support"
+#endif
+
+/* A signed 62-bit limb representation of integers.
+ *
+ * Its value is sum(v[i] * 2^(62*i), i=0..4). */
+typedef struct {
+    int64_t v[5];
+} hsk_secp256k1_modinv64_signed62;
+
+typedef struct {
+    /* The modulus in signed62 notation, must be odd and in [3, 2^256]. */
+    hsk_secp256k1_modinv64_signed62 modulus;
+
+    /* modulus^{-1} mod 2^62 */
+    uint64_t modulus_inv62;
+} hsk_secp256k1_modinv64_modinfo;
+
+/* Replace x with its modular inverse mod modinfo->modulus. x must be in range [0, modulus).
+ * If x is zero, the result will be zero as well. If not, the inverse must exist (i.e., the gcd of
+ * x and modulus must be 1). These rules are automatically satisfied if the modulus is prime.
+ *
+ * On output, all of x's limbs will be in [0, 2^62).
+ *
+ * This is the variable-time safegcd algorithm of Bernstein and Yang ("Fast constant-time gcd
+ * computation and modular inversion", 2019), and must only be used on public data.
+ */
+static void hsk_secp256k1_modinv64_var(hsk_secp256k1_modinv64_signed62 *x, const hsk_secp256k1_modinv64_modinfo *modinfo);
+
+#endif /* HSK_SECP256K1_MODINV64_H */
@@ -63,6 +63,10 @@ static void hsk_secp256k1_scalar_inverse(hsk_secp256k1_scalar *r, const hsk_secp
 /** Compute the inverse of a scalar (modulo the group order), without constant-time guarantee. */
 static void hsk_secp256k1_scalar_inverse_var(hsk_secp256k1_scalar *r, const hsk_secp256k1_scalar *a);
 
+/** Invert len nonzero scalars at once with a single inversion (Montgomery's trick), without constant-time guarantee.
+ *  r and a must not overlap. */
+static void hsk_secp256k1_scalar_inverse_all_var(hsk_secp256k1_scalar *r, const hsk_secp256k1_scalar *a, size_t len);
+
 /** Compute the complement of a scalar (modulo the group order). */
 static void hsk_secp256k1_scalar_negate(hsk_secp256k1_scalar *r, const hsk_secp256k1_scalar *a);
 
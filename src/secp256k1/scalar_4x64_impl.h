@@ -7,6 +7,8 @@
 #ifndef HSK_SECP256K1_SCALAR_REPR_IMPL_H
 #define HSK_SECP256K1_SCALAR_REPR_IMPL_H
 
+#include "modinv64_impl.h"
+
 /* Limbs of the secp256k1 order. */
 #define HSK_SECP256K1_N_0 ((uint64_t)0xBFD25E8CD0364141ULL)
 #define HSK_SECP256K1_N_1 ((uint64_t)0xBAAEDCE6AF48A03BULL)
@@ -946,4 +948,52 @@ HSK_SECP256K1_INLINE static void hsk_secp256k1_scalar_mul_shift_var(hsk_secp256k
     hsk_secp256k1_scalar_cadd_bit(r, 0, (l[(shift - 1) >> 6] >> ((shift - 1) & 0x3f)) & 1);
 }
 
+static void hsk_secp256k1_scalar_from_signed62(hsk_secp256k1_scalar *r, const hsk_secp256k1_modinv64_signed62 *a) {
+    const uint64_t a0 = a->v[0], a1 = a->v[1], a2 = a->v[2], a3 = a->v[3], a4 = a->v[4];
+
+    /* The output from hsk_secp256k1_modinv64_var is normalized to range [0,modulus), and
+     * have limbs in [0,2^62). The modulus is < 2^256, so the top limb must be below 2^(256-62*4).
+     */
+    VERIFY_CHECK(a0 >> 62 == 0);
+    VERIFY_CHECK(a1 >> 62 == 0);
+    VERIFY_CHECK(a2 >> 62 == 0);
+    VERIFY_CHECK(a3 >> 62 == 0);
+    VERIFY_CHECK(a4 >> 8 == 0);
+
+    r->d[0] = a0      | a1 << 62;
+    r->d[1] = a1 >> 2 | a2 << 60;
+    r->d[2] = a2 >> 4 | a3 << 58;
+    r->d[3] = a3 >> 6 | a4 << 56;
+
+    VERIFY_CHECK(hsk_secp256k1_scalar_check_overflow(r) == 0);
+}
+
+static void hsk_secp256k1_scalar_to_signed62(hsk_secp256k1_modinv64_signed62 *r, const hsk_secp256k1_scalar *a) {
+    const uint64_t M62 = UINT64_MAX >> 2;
+    const uint64_t a0 = a->d[0], a1 = a->d[1], a2 = a->d[2], a3 = a->d[3];
+
+    VERIFY_CHECK(hsk_secp256k1_scalar_check_overflow(a) == 0);
+
+    r->v[0] =  a0                   & M62;
+    r->v[1] = (a0 >> 62 | a1 <<  2) & M62;
+    r->v[2] = (a1 >> 60 | a2 <<  4) & M62;
+    r->v[3] = (a2 >> 58 | a3 <<  6) & M62;
+    r->v[4] =  a3 >> 56;
+}
+
+static const hsk_secp256k1_modinv64_modinfo hsk_secp256k1_const_modinfo_scalar = {
+    {{0x3FD25E8CD0364141LL, 0x2ABB739ABD2280EELL, -0x15LL, 0, 256}},
+    0x34F20099AA774EC1LL
+};
+
+static void hsk_secp256k1_scalar_inverse_var(hsk_secp256k1_scalar *r, const hsk_secp256k1_scalar *x) {
+    hsk_secp256k1_modinv64_signed62 s;
+
+    hsk_secp256k1_scalar_to_signed62(&s, x);
+    hsk_secp256k1_modinv64_var(&s, &hsk_secp256k1_const_modinfo_scalar);
+    hsk_secp256k1_scalar_from_signed62(r, &s);
+
+    VERIFY_CHECK(hsk_secp256k1_scalar_is_zero(r) == hsk_secp256k1_scalar_is_zero(x));
+}
+
 #endif /* HSK_SECP256K1_SCALAR_REPR_IMPL_H */
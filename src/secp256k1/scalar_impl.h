@@ -194,9 +194,39 @@ HSK_SECP256K1_INLINE static int hsk_secp256k1_scalar_is_even(const hsk_secp256k1
 }
 #endif
 
+#if defined(EXHAUSTIVE_TEST_ORDER) || !defined(HSK_USE_SCALAR_4X64)
+/* The 4x64 representation provides a safegcd-based variable-time inverse. */
 static void hsk_secp256k1_scalar_inverse_var(hsk_secp256k1_scalar *r, const hsk_secp256k1_scalar *x) {
   hsk_secp256k1_scalar_inverse(r, x);
 }
+#endif
+
+static void hsk_secp256k1_scalar_inverse_all_var(hsk_secp256k1_scalar *r, const hsk_secp256k1_scalar *a, size_t len) {
+    hsk_secp256k1_scalar u;
+    size_t i;
+    if (len < 1) {
+        return;
+    }
+
+    VERIFY_CHECK((r + len <= a) || (a + len <= r));
+
+    r[0] = a[0];
+
+    i = 0;
+    while (++i < len) {
+        hsk_secp256k1_scalar_mul(&r[i], &r[i - 1], &a[i]);
+    }
+
+    hsk_secp256k1_scalar_inverse_var(&u, &r[--i]);
+
+    while (i > 0) {
+        size_t j = i--;
+        hsk_secp256k1_scalar_mul(&r[j], &r[i], &u);
+        hsk_secp256k1_scalar_mul(&u, &u, &a[j]);
+    }
+
+    r[0] = u;
+}
 
 #ifdef HSK_USE_ENDOMORPHISM
 #if defined(EXHAUSTIVE_TEST_ORDER)
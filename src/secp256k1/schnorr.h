@@ -0,0 +1,92 @@
+#ifndef HSK_SECP256K1_SCHNORR_H
+#define HSK_SECP256K1_SCHNORR_H
+
+#include "secp256k1.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Schnorr signatures as specified for Bitcoin Cash (May 2019 upgrade).
+ *
+ *  A signature is 64 bytes: the x coordinate of R (32 bytes, big endian),
+ *  followed by s (32 bytes, big endian). The challenge is
+ *  e = SHA256(R.x || compressed(P) || msg32) mod n, and a signature is valid
+ *  iff R = s*G - e*P is not infinity, has a quadratic residue y coordinate,
+ *  and has x coordinate R.x.
+ */
+
+/** Verify a Schnorr signature.
+ *
+ *  Returns: 1: correct signature
+ *           0: incorrect signature
+ *  Args:    ctx:       a secp256k1 context object, initialized for verification.
+ *  In:      sig64:     the 64-byte signature being verified (cannot be NULL)
+ *           msg32:     the 32-byte message hash being verified (cannot be NULL)
+ *           pubkey:    pointer to an initialized public key to verify with (cannot be NULL)
+ */
+HSK_SECP256K1_API HSK_SECP256K1_WARN_UNUSED_RESULT int hsk_secp256k1_schnorr_verify(
+    const hsk_secp256k1_context* ctx,
+    const unsigned char *sig64,
+    const unsigned char *msg32,
+    const hsk_secp256k1_pubkey *pubkey
+) HSK_SECP256K1_ARG_NONNULL(1) HSK_SECP256K1_ARG_NONNULL(2) HSK_SECP256K1_ARG_NONNULL(3) HSK_SECP256K1_ARG_NONNULL(4);
+
+/** Verify a batch of Schnorr signatures.
+ *
+ *  Returns: 1: all signatures are correct
+ *           0: at least one signature is incorrect
+ *  Args:    ctx:     a secp256k1 context object, initialized for verification.
+ *           scratch: scratch space used for the multi-scalar multiplication
+ *  Out:     failed:  if not NULL and 0 is returned, set to the index of the
+ *                    first invalid signature (can be NULL)
+ *  In:      sigs64:  array of n pointers to 64-byte signatures
+ *           msgs32:  array of n pointers to 32-byte message hashes
+ *           pubkeys: array of n pointers to public keys
+ *           n:       number of signatures
+ *
+ * All n equations are combined with random weights into a single check
+ * sum(a_i*s_i)*G - sum(a_i*e_i*P_i) - sum(a_i*R_i) = 0, evaluated with one
+ * hsk_secp256k1_ecmult_multi_var call. The weights are derived by hashing the
+ * whole batch. If the combined check fails (or the scratch space is too small),
+ * the signatures are verified one by one to find the failing one.
+ */
+HSK_SECP256K1_API HSK_SECP256K1_WARN_UNUSED_RESULT int hsk_secp256k1_schnorr_verify_batch(
+    const hsk_secp256k1_context* ctx,
+    hsk_secp256k1_scratch_space *scratch,
+    const unsigned char *const *sigs64,
+    const unsigned char *const *msgs32,
+    const hsk_secp256k1_pubkey *const *pubkeys,
+    size_t n,
+    size_t *failed
+) HSK_SECP256K1_ARG_NONNULL(1) HSK_SECP256K1_ARG_NONNULL(2);
+
+/** Create a Schnorr signature.
+ *
+ *  Returns: 1: signature created
+ *           0: the nonce generation function failed, or the private key was invalid.
+ *  Args:    ctx:    pointer to a context object, initialized for signing (cannot be NULL)
+ *  Out:     sig64:  pointer to a 64-byte array where the signature will be placed (cannot be NULL)
+ *  In:      msg32:  the 32-byte message hash being signed (cannot be NULL)
+ *           seckey: pointer to a 32-byte secret key (cannot be NULL)
+ *           noncefp:pointer to a nonce generation function. If NULL, hsk_secp256k1_nonce_function_default is used
+ *           ndata:  pointer to arbitrary data used by the nonce generation function (can be NULL)
+ *
+ *  The nonce function is called with algo16 set to "Schnorr+SHA256  ", so
+ *  the default RFC6979 nonces never coincide with ECDSA nonces for the same
+ *  key and message.
+ */
+HSK_SECP256K1_API int hsk_secp256k1_schnorr_sign(
+    const hsk_secp256k1_context* ctx,
+    unsigned char *sig64,
+    const unsigned char *msg32,
+    const unsigned char *seckey,
+    hsk_secp256k1_nonce_function noncefp,
+    const void *ndata
+) HSK_SECP256K1_ARG_NONNULL(1) HSK_SECP256K1_ARG_NONNULL(2) HSK_SECP256K1_ARG_NONNULL(3) HSK_SECP256K1_ARG_NONNULL(4);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HSK_SECP256K1_SCHNORR_H */
@@ -0,0 +1,286 @@
+#ifndef HSK_SECP256K1_MODULE_SCHNORR_MAIN_H
+#define HSK_SECP256K1_MODULE_SCHNORR_MAIN_H
+
+#include "schnorr.h"
+
+/* e = SHA256(R.x || compressed(P) || msg32) mod n */
+static void hsk_secp256k1_schnorr_compute_e(hsk_secp256k1_scalar *e, const unsigned char *r32, hsk_secp256k1_ge *pubkey, const unsigned char *msg32) {
+    unsigned char pub[33];
+    unsigned char out[32];
+    size_t len = sizeof(pub);
+    hsk_secp256k1_sha256 sha;
+
+    hsk_secp256k1_eckey_pubkey_serialize(pubkey, pub, &len, 1);
+    hsk_secp256k1_sha256_initialize(&sha);
+    hsk_secp256k1_sha256_write(&sha, r32, 32);
+    hsk_secp256k1_sha256_write(&sha, pub, 33);
+    hsk_secp256k1_sha256_write(&sha, msg32, 32);
+    hsk_secp256k1_sha256_finalize(&sha, out);
+    hsk_secp256k1_scalar_set_b32(e, out, NULL);
+}
+
+static int hsk_secp256k1_schnorr_sig_verify(const hsk_secp256k1_ecmult_context *ctx, const unsigned char *sig64, hsk_secp256k1_ge *pubkey, const unsigned char *msg32) {
+    hsk_secp256k1_gej pj, rj;
+    hsk_secp256k1_fe rx;
+    hsk_secp256k1_scalar e, s;
+    int overflow = 0;
+
+    if (hsk_secp256k1_ge_is_infinity(pubkey)) {
+        return 0;
+    }
+
+    hsk_secp256k1_scalar_set_b32(&s, &sig64[32], &overflow);
+    if (overflow) {
+        return 0;
+    }
+
+    if (!hsk_secp256k1_fe_set_b32(&rx, &sig64[0])) {
+        return 0;
+    }
+
+    hsk_secp256k1_schnorr_compute_e(&e, &sig64[0], pubkey, msg32);
+
+    /* R = s*G - e*P */
+    hsk_secp256k1_scalar_negate(&e, &e);
+    hsk_secp256k1_gej_set_ge(&pj, pubkey);
+    hsk_secp256k1_ecmult(ctx, &rj, &pj, &e, &s);
+
+    if (hsk_secp256k1_gej_is_infinity(&rj)) {
+        return 0;
+    }
+
+    if (!hsk_secp256k1_gej_has_quad_y_var(&rj)) {
+        return 0;
+    }
+
+    return hsk_secp256k1_gej_eq_x_var(&rx, &rj);
+}
+
+int hsk_secp256k1_schnorr_verify(const hsk_secp256k1_context* ctx, const unsigned char *sig64, const unsigned char *msg32, const hsk_secp256k1_pubkey *pubkey) {
+    hsk_secp256k1_ge q;
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(hsk_secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(sig64 != NULL);
+    ARG_CHECK(msg32 != NULL);
+    ARG_CHECK(pubkey != NULL);
+
+    if (!hsk_secp256k1_pubkey_load(ctx, &q, pubkey)) {
+        return 0;
+    }
+
+    return hsk_secp256k1_schnorr_sig_verify(&ctx->ecmult_ctx, sig64, &q, msg32);
+}
+
+typedef struct {
+    const hsk_secp256k1_context *ctx;
+    const unsigned char *const *sigs64;
+    const unsigned char *const *msgs32;
+    const hsk_secp256k1_pubkey *const *pubkeys;
+    unsigned char seed[32];
+    size_t weight_idx;
+    hsk_secp256k1_scalar weight;
+} hsk_secp256k1_schnorr_batch;
+
+/* a_0 = 1, a_i = SHA256(seed || i) mod n */
+static void hsk_secp256k1_schnorr_batch_weight(hsk_secp256k1_scalar *a, const unsigned char *seed, size_t i) {
+    unsigned char buf[8];
+    unsigned char out[32];
+    hsk_secp256k1_sha256 sha;
+    int j;
+
+    if (i == 0) {
+        hsk_secp256k1_scalar_set_int(a, 1);
+        return;
+    }
+
+    for (j = 0; j < 8; j++) {
+        buf[j] = (unsigned char)((uint64_t)i >> (8 * j));
+    }
+
+    hsk_secp256k1_sha256_initialize(&sha);
+    hsk_secp256k1_sha256_write(&sha, seed, 32);
+    hsk_secp256k1_sha256_write(&sha, buf, 8);
+    hsk_secp256k1_sha256_finalize(&sha, out);
+    hsk_secp256k1_scalar_set_b32(a, out, NULL);
+}
+
+/* Point 2i is P_i with scalar -a_i*e_i, point 2i+1 is R_i with scalar -a_i. */
+static int hsk_secp256k1_schnorr_batch_cb(hsk_secp256k1_scalar *sc, hsk_secp256k1_ge *pt, size_t idx, void *data) {
+    hsk_secp256k1_schnorr_batch *batch = (hsk_secp256k1_schnorr_batch *)data;
+    size_t i = idx >> 1;
+
+    /* The multiplication backends ask for the points in order,
+     * so each weight is hashed once. */
+    if (batch->weight_idx != i) {
+        hsk_secp256k1_schnorr_batch_weight(&batch->weight, batch->seed, i);
+        batch->weight_idx = i;
+    }
+
+    if (idx & 1) {
+        hsk_secp256k1_fe rx;
+
+        if (!hsk_secp256k1_fe_set_b32(&rx, batch->sigs64[i])) {
+            return 0;
+        }
+
+        /* The root chosen by ge_set_xquad is itself a quadratic residue. */
+        if (!hsk_secp256k1_ge_set_xquad(pt, &rx)) {
+            return 0;
+        }
+
+        hsk_secp256k1_scalar_negate(sc, &batch->weight);
+    } else {
+        hsk_secp256k1_scalar e;
+
+        if (!hsk_secp256k1_pubkey_load(batch->ctx, pt, batch->pubkeys[i])) {
+            return 0;
+        }
+
+        hsk_secp256k1_schnorr_compute_e(&e, batch->sigs64[i], pt, batch->msgs32[i]);
+        hsk_secp256k1_scalar_mul(sc, &batch->weight, &e);
+        hsk_secp256k1_scalar_negate(sc, sc);
+    }
+
+    return 1;
+}
+
+int hsk_secp256k1_schnorr_verify_batch(const hsk_secp256k1_context* ctx, hsk_secp256k1_scratch_space *scratch, const unsigned char *const *sigs64, const unsigned char *const *msgs32, const hsk_secp256k1_pubkey *const *pubkeys, size_t n, size_t *failed) {
+    hsk_secp256k1_schnorr_batch batch;
+    hsk_secp256k1_sha256 sha;
+    hsk_secp256k1_scalar s, a, g_sc;
+    hsk_secp256k1_gej rj;
+    size_t i;
+    int overflow;
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(hsk_secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(scratch != NULL);
+    ARG_CHECK(n == 0 || sigs64 != NULL);
+    ARG_CHECK(n == 0 || msgs32 != NULL);
+    ARG_CHECK(n == 0 || pubkeys != NULL);
+
+    if (n == 0) {
+        return 1;
+    }
+
+    /* A lone signature is cheaper to check directly. */
+    if (n == 1) {
+        goto fallback;
+    }
+
+    /* The weights must be unpredictable to whoever chose the
+     * signatures, so they are derived from the whole batch. */
+    hsk_secp256k1_sha256_initialize(&sha);
+    for (i = 0; i < n; i++) {
+        hsk_secp256k1_sha256_write(&sha, sigs64[i], 64);
+        hsk_secp256k1_sha256_write(&sha, msgs32[i], 32);
+        hsk_secp256k1_sha256_write(&sha, pubkeys[i]->data, 64);
+    }
+    hsk_secp256k1_sha256_finalize(&sha, batch.seed);
+
+    batch.ctx = ctx;
+    batch.sigs64 = sigs64;
+    batch.msgs32 = msgs32;
+    batch.pubkeys = pubkeys;
+    batch.weight_idx = 0;
+    hsk_secp256k1_scalar_set_int(&batch.weight, 1);
+
+    /* g_sc = sum(a_i*s_i) */
+    hsk_secp256k1_scalar_set_int(&g_sc, 0);
+    for (i = 0; i < n; i++) {
+        hsk_secp256k1_scalar_set_b32(&s, &sigs64[i][32], &overflow);
+        if (overflow) {
+            goto fallback;
+        }
+        hsk_secp256k1_schnorr_batch_weight(&a, batch.seed, i);
+        hsk_secp256k1_scalar_mul(&a, &a, &s);
+        hsk_secp256k1_scalar_add(&g_sc, &g_sc, &a);
+    }
+
+    if (hsk_secp256k1_ecmult_multi_var(&ctx->ecmult_ctx, scratch, &rj, &g_sc, hsk_secp256k1_schnorr_batch_cb, &batch, 2 * n) &&
+        hsk_secp256k1_gej_is_infinity(&rj)) {
+        return 1;
+    }
+
+fallback:
+    for (i = 0; i < n; i++) {
+        if (!hsk_secp256k1_schnorr_verify(ctx, sigs64[i], msgs32[i], pubkeys[i])) {
+            if (failed != NULL) {
+                *failed = i;
+            }
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+int hsk_secp256k1_schnorr_sign(const hsk_secp256k1_context* ctx, unsigned char *sig64, const unsigned char *msg32, const unsigned char *seckey, hsk_secp256k1_nonce_function noncefp, const void *ndata) {
+    static const unsigned char algo16[16] = {
+        'S', 'c', 'h', 'n', 'o', 'r', 'r', '+',
+        'S', 'H', 'A', '2', '5', '6', ' ', ' '
+    };
+    hsk_secp256k1_scalar sec, non, e;
+    hsk_secp256k1_gej pj, rj;
+    hsk_secp256k1_ge pub, r;
+    unsigned char nonce32[32];
+    unsigned int count = 0;
+    int overflow = 0;
+    int ret = 0;
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(hsk_secp256k1_ecmult_gen_context_is_built(&ctx->ecmult_gen_ctx));
+    ARG_CHECK(sig64 != NULL);
+    ARG_CHECK(msg32 != NULL);
+    ARG_CHECK(seckey != NULL);
+    if (noncefp == NULL) {
+        noncefp = hsk_secp256k1_nonce_function_default;
+    }
+
+    hsk_secp256k1_scalar_set_b32(&sec, seckey, &overflow);
+    /* Fail if the secret key is invalid. */
+    if (!overflow && !hsk_secp256k1_scalar_is_zero(&sec)) {
+        while (1) {
+            ret = noncefp(nonce32, msg32, seckey, algo16, (void*)ndata, count);
+            if (!ret) {
+                break;
+            }
+            hsk_secp256k1_scalar_set_b32(&non, nonce32, &overflow);
+            if (!overflow && !hsk_secp256k1_scalar_is_zero(&non)) {
+                break;
+            }
+            count++;
+        }
+    }
+
+    if (ret) {
+        hsk_secp256k1_ecmult_gen(&ctx->ecmult_gen_ctx, &pj, &sec);
+        hsk_secp256k1_ge_set_gej(&pub, &pj);
+
+        hsk_secp256k1_ecmult_gen(&ctx->ecmult_gen_ctx, &rj, &non);
+        hsk_secp256k1_ge_set_gej(&r, &rj);
+
+        /* Use k or -k, whichever gives R a quadratic residue y. */
+        if (!hsk_secp256k1_fe_is_quad_var(&r.y)) {
+            hsk_secp256k1_scalar_negate(&non, &non);
+        }
+
+        hsk_secp256k1_fe_normalize(&r.x);
+        hsk_secp256k1_fe_get_b32(&sig64[0], &r.x);
+
+        /* s = k + e*x */
+        hsk_secp256k1_schnorr_compute_e(&e, &sig64[0], &pub, msg32);
+        hsk_secp256k1_scalar_mul(&e, &e, &sec);
+        hsk_secp256k1_scalar_add(&e, &e, &non);
+        hsk_secp256k1_scalar_get_b32(&sig64[32], &e);
+
+        hsk_secp256k1_scalar_clear(&e);
+    } else {
+        memset(sig64, 0, 64);
+    }
+
+    memset(nonce32, 0, 32);
+    hsk_secp256k1_scalar_clear(&non);
+    hsk_secp256k1_scalar_clear(&sec);
+    return ret;
+}
+
+#endif /* HSK_SECP256K1_MODULE_SCHNORR_MAIN_H */
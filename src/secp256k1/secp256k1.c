@@ -126,6 +126,136 @@ void hsk_secp256k1_scratch_space_destroy(hsk_secp256k1_scratch_space* scratch) {
     hsk_secp256k1_scratch_destroy(scratch);
 }
 
+#if HSK_SECP256K1_ECMULT_MULTI_WINDOWS != PIPPENGER_MAX_BUCKET_WINDOW - 1
+#error "HSK_SECP256K1_ECMULT_MULTI_WINDOWS does not match PIPPENGER_MAX_BUCKET_WINDOW"
+#endif
+
+int hsk_secp256k1_context_set_ecmult_multi(hsk_secp256k1_context* ctx, size_t threshold, const size_t *window_max) {
+    int i;
+    VERIFY_CHECK(ctx != NULL);
+
+    if (window_max == NULL) {
+        ctx->ecmult_ctx.pippenger_threshold = ECMULT_PIPPENGER_THRESHOLD;
+        memcpy(ctx->ecmult_ctx.pippenger_window_max, hsk_secp256k1_pippenger_default_window_max, sizeof(ctx->ecmult_ctx.pippenger_window_max));
+        return 1;
+    }
+
+    /* hsk_secp256k1_pippenger_max_points relies on the limits growing with the window. */
+    for (i = 1; i < HSK_SECP256K1_ECMULT_MULTI_WINDOWS; i++) {
+        if (window_max[i] < window_max[i - 1]) {
+            return 0;
+        }
+    }
+
+    ctx->ecmult_ctx.pippenger_threshold = threshold;
+    for (i = 0; i < HSK_SECP256K1_ECMULT_MULTI_WINDOWS; i++) {
+        ctx->ecmult_ctx.pippenger_window_max[i] = window_max[i];
+    }
+    ctx->ecmult_ctx.pippenger_window_max[PIPPENGER_MAX_BUCKET_WINDOW - 1] = SIZE_MAX;
+    return 1;
+}
+
+int hsk_secp256k1_context_get_ecmult_multi(const hsk_secp256k1_context* ctx, size_t *threshold, size_t *window_max) {
+    int i;
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(threshold != NULL);
+    ARG_CHECK(window_max != NULL);
+
+    *threshold = ctx->ecmult_ctx.pippenger_threshold;
+    for (i = 0; i < HSK_SECP256K1_ECMULT_MULTI_WINDOWS; i++) {
+        window_max[i] = ctx->ecmult_ctx.pippenger_window_max[i];
+    }
+    return 1;
+}
+
+#if HSK_SECP256K1_ECMULT_WINDOW_MIN != ECMULT_WINDOW_G_MIN || HSK_SECP256K1_ECMULT_WINDOW_MAX != ECMULT_WINDOW_G_MAX
+#error "HSK_SECP256K1_ECMULT_WINDOW_MIN/MAX do not match ECMULT_WINDOW_G_MIN/MAX"
+#endif
+
+size_t hsk_secp256k1_ecmult_window_table_size(int window) {
+    if (window < ECMULT_WINDOW_G_MIN || window > ECMULT_WINDOW_G_MAX) {
+        return 0;
+    }
+    return hsk_secp256k1_ecmult_table_size(window);
+}
+
+int hsk_secp256k1_ecmult_window_table_build(const hsk_secp256k1_context* ctx, void *table, int window) {
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(table != NULL);
+    ARG_CHECK(((uintptr_t)table & 7) == 0);
+    ARG_CHECK(window >= ECMULT_WINDOW_G_MIN && window <= ECMULT_WINDOW_G_MAX);
+
+    hsk_secp256k1_ecmult_table_build((hsk_secp256k1_ge_storage *)table, window, &ctx->error_callback);
+    return 1;
+}
+
+/* Number of entries compared per row, evenly spaced and including the first and last. */
+#define ECMULT_TABLE_CHECK_SAMPLES 9
+
+static int hsk_secp256k1_ecmult_table_check_row(const hsk_secp256k1_ge_storage *pre, int n, const hsk_secp256k1_ge *base) {
+    int i;
+
+    for (i = 0; i < ECMULT_TABLE_CHECK_SAMPLES; i++) {
+        int k = (int)(((int64_t)(n - 1) * i) / (ECMULT_TABLE_CHECK_SAMPLES - 1));
+        hsk_secp256k1_scalar sc;
+        hsk_secp256k1_gej rj;
+        hsk_secp256k1_ge r, e;
+
+        /* Entry k is (2k+1)*base. */
+        hsk_secp256k1_scalar_set_int(&sc, 2 * (unsigned int)k + 1);
+        hsk_secp256k1_ecmult_const(&rj, base, &sc);
+        hsk_secp256k1_ge_set_gej_var(&r, &rj);
+        hsk_secp256k1_ge_from_storage(&e, &pre[k]);
+
+        if (!hsk_secp256k1_fe_equal_var(&r.x, &e.x) || !hsk_secp256k1_fe_equal_var(&r.y, &e.y)) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+int hsk_secp256k1_ecmult_window_table_check(const hsk_secp256k1_context* ctx, const void *table, int window) {
+    const hsk_secp256k1_ge_storage *pre = (const hsk_secp256k1_ge_storage *)table;
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(table != NULL);
+    ARG_CHECK(((uintptr_t)table & 7) == 0);
+    ARG_CHECK(window >= ECMULT_WINDOW_G_MIN && window <= ECMULT_WINDOW_G_MAX);
+
+    if (!hsk_secp256k1_ecmult_table_check_row(pre, ECMULT_TABLE_SIZE(window), &hsk_secp256k1_ge_const_g)) {
+        return 0;
+    }
+
+#ifdef HSK_USE_ENDOMORPHISM
+    {
+        hsk_secp256k1_gej g_128j;
+        hsk_secp256k1_ge g_128;
+        int i;
+
+        hsk_secp256k1_gej_set_ge(&g_128j, &hsk_secp256k1_ge_const_g);
+        for (i = 0; i < 128; i++) {
+            hsk_secp256k1_gej_double_var(&g_128j, &g_128j, NULL);
+        }
+        hsk_secp256k1_ge_set_gej_var(&g_128, &g_128j);
+
+        if (!hsk_secp256k1_ecmult_table_check_row(pre + ECMULT_TABLE_SIZE(window), ECMULT_TABLE_SIZE(window), &g_128)) {
+            return 0;
+        }
+    }
+#endif
+
+    return 1;
+}
+
+int hsk_secp256k1_context_set_ecmult_window(hsk_secp256k1_context* ctx, int window, const void *table) {
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(((uintptr_t)table & 7) == 0);
+    ARG_CHECK(window >= ECMULT_WINDOW_G_MIN && window <= ECMULT_WINDOW_G_MAX);
+
+    hsk_secp256k1_ecmult_context_set_window(&ctx->ecmult_ctx, window, (const hsk_secp256k1_ge_storage *)table, &ctx->error_callback);
+    return 1;
+}
+
 static int hsk_secp256k1_pubkey_load(const hsk_secp256k1_context* ctx, hsk_secp256k1_ge* ge, const hsk_secp256k1_pubkey* pubkey) {
     if (sizeof(hsk_secp256k1_ge_storage) == 64) {
         /* When the hsk_secp256k1_ge_storage type is exactly 64 byte, use its
@@ -174,6 +304,75 @@ int hsk_secp256k1_ec_pubkey_parse(const hsk_secp256k1_context* ctx, hsk_secp256k
     return 1;
 }
 
+/* Compressed keys are gathered in chunks of this size and decompressed together. */
+#define PUBKEY_PARSE_CHUNK 64
+
+int hsk_secp256k1_ec_pubkey_parse_batch(const hsk_secp256k1_context* ctx, hsk_secp256k1_pubkey *pubkeys, int *results, const unsigned char *const *inputs, const size_t *inputlens, size_t n) {
+    hsk_secp256k1_ge P;
+    hsk_secp256k1_ge Q[PUBKEY_PARSE_CHUNK];
+    hsk_secp256k1_fe x[PUBKEY_PARSE_CHUNK];
+    int odd[PUBKEY_PARSE_CHUNK];
+    int ok[PUBKEY_PARSE_CHUNK];
+    size_t idx[PUBKEY_PARSE_CHUNK];
+    size_t i = 0, j, len;
+    int ret = 1;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(n == 0 || pubkeys != NULL);
+    ARG_CHECK(n == 0 || inputs != NULL);
+    ARG_CHECK(n == 0 || inputlens != NULL);
+
+    /* Public keys are not secret, so unlike the single parse the
+     * intermediate points are not cleared. */
+    while (i < n) {
+        len = 0;
+
+        for (; i < n && len < PUBKEY_PARSE_CHUNK; i++) {
+            const unsigned char *input = inputs[i];
+            int valid = 0;
+
+            if (input != NULL && inputlens[i] == 33 &&
+                (input[0] == HSK_SECP256K1_TAG_PUBKEY_EVEN || input[0] == HSK_SECP256K1_TAG_PUBKEY_ODD)) {
+                if (hsk_secp256k1_fe_set_b32(&x[len], input + 1)) {
+                    odd[len] = input[0] == HSK_SECP256K1_TAG_PUBKEY_ODD;
+                    idx[len] = i;
+                    len++;
+                    continue;
+                }
+            } else if (input != NULL && hsk_secp256k1_eckey_pubkey_parse(&P, input, inputlens[i])) {
+                hsk_secp256k1_pubkey_save(&pubkeys[i], &P);
+                valid = 1;
+            }
+
+            if (!valid) {
+                memset(&pubkeys[i], 0, sizeof(pubkeys[i]));
+                ret = 0;
+            }
+
+            if (results != NULL) {
+                results[i] = valid;
+            }
+        }
+
+        hsk_secp256k1_ge_set_xo_all_var(ok, Q, x, odd, len);
+
+        for (j = 0; j < len; j++) {
+            if (ok[j]) {
+                hsk_secp256k1_pubkey_save(&pubkeys[idx[j]], &Q[j]);
+            } else {
+                memset(&pubkeys[idx[j]], 0, sizeof(pubkeys[idx[j]]));
+                ret = 0;
+            }
+
+            if (results != NULL) {
+                results[idx[j]] = ok[j];
+            }
+        }
+    }
+
+    return ret;
+}
+
 int hsk_secp256k1_ec_pubkey_serialize(const hsk_secp256k1_context* ctx, unsigned char *output, size_t *outputlen, const hsk_secp256k1_pubkey* pubkey, unsigned int flags) {
     hsk_secp256k1_ge Q;
     size_t len;
@@ -319,6 +518,67 @@ int hsk_secp256k1_ecdsa_verify(const hsk_secp256k1_context* ctx, const hsk_secp2
             hsk_secp256k1_ecdsa_sig_verify(&ctx->ecmult_ctx, &r, &s, &q, &m));
 }
 
+#define HSK_SECP256K1_ECDSA_BATCH 64
+
+int hsk_secp256k1_ecdsa_verify_batch(const hsk_secp256k1_context* ctx, const hsk_secp256k1_ecdsa_signature *const *sigs, const unsigned char *const *msgs32, const hsk_secp256k1_pubkey *const *pubkeys, size_t n, size_t *failed) {
+    hsk_secp256k1_scalar r[HSK_SECP256K1_ECDSA_BATCH];
+    hsk_secp256k1_scalar s[HSK_SECP256K1_ECDSA_BATCH];
+    hsk_secp256k1_scalar sn[HSK_SECP256K1_ECDSA_BATCH];
+    hsk_secp256k1_scalar m;
+    hsk_secp256k1_ge q;
+    size_t i, j, len;
+    int bad;
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(hsk_secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(n == 0 || sigs != NULL);
+    ARG_CHECK(n == 0 || msgs32 != NULL);
+    ARG_CHECK(n == 0 || pubkeys != NULL);
+
+    for (i = 0; i < n; i += len) {
+        len = n - i;
+        if (len > HSK_SECP256K1_ECDSA_BATCH) {
+            len = HSK_SECP256K1_ECDSA_BATCH;
+        }
+
+        /* A malformed signature ends the chunk early, so that the
+         * signatures before it are still checked and the reported
+         * index is the first failure. */
+        bad = 0;
+        for (j = 0; j < len; j++) {
+            hsk_secp256k1_ecdsa_signature_load(ctx, &r[j], &s[j], sigs[i + j]);
+            if (hsk_secp256k1_scalar_is_zero(&r[j]) ||
+                hsk_secp256k1_scalar_is_zero(&s[j]) ||
+                hsk_secp256k1_scalar_is_high(&s[j])) {
+                bad = 1;
+                len = j;
+                break;
+            }
+        }
+
+        hsk_secp256k1_scalar_inverse_all_var(sn, s, len);
+
+        for (j = 0; j < len; j++) {
+            hsk_secp256k1_scalar_set_b32(&m, msgs32[i + j], NULL);
+            if (!hsk_secp256k1_pubkey_load(ctx, &q, pubkeys[i + j]) ||
+                !hsk_secp256k1_ecdsa_sig_verify_inv(&ctx->ecmult_ctx, &r[j], &sn[j], &q, &m)) {
+                if (failed != NULL) {
+                    *failed = i + j;
+                }
+                return 0;
+            }
+        }
+
+        if (bad) {
+            if (failed != NULL) {
+                *failed = i + len;
+            }
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
 static HSK_SECP256K1_INLINE void buffer_append(unsigned char *buf, unsigned int *offset, const void *data, unsigned int len) {
     memcpy(buf + *offset, data, len);
     *offset += len;
@@ -592,3 +852,4 @@ int hsk_secp256k1_ec_pubkey_combine(const hsk_secp256k1_context* ctx, hsk_secp25
 
 #include "ecdh_impl.h"
 #include "recovery_impl.h"
+#include "schnorr_impl.h"
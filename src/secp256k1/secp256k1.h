@@ -278,6 +278,125 @@ HSK_SECP256K1_API void hsk_secp256k1_scratch_space_destroy(
     hsk_secp256k1_scratch_space* scratch
 );
 
+/** Number of Pippenger bucket windows with a tunable point limit. */
+#define HSK_SECP256K1_ECMULT_MULTI_WINDOWS 11
+
+/** Override the multi-scalar multiplication tuning of a context.
+ *
+ *  Batch verification uses Strauss' algorithm for small batches and
+ *  Pippenger's for large ones. The crossover and the Pippenger window sizes
+ *  are compiled-in defaults; this replaces them with values measured on the
+ *  host (see bench/ecmult.c).
+ *
+ *  Returns: 1 if the tuning was applied, 0 if it was invalid.
+ *  Args: ctx:        an existing context object (cannot be NULL)
+ *  In:   threshold:  number of points from which Pippenger's algorithm is
+ *                    used instead of Strauss'
+ *        window_max: array of HSK_SECP256K1_ECMULT_MULTI_WINDOWS
+ *                    non-decreasing point counts; entry i is the largest
+ *                    number of points for which bucket window i+1 is used.
+ *                    Larger inputs use the largest window. If NULL, both
+ *                    settings are reset to the defaults.
+ *
+ *  The context must not be in use by other threads while it is retuned.
+ */
+HSK_SECP256K1_API int hsk_secp256k1_context_set_ecmult_multi(
+    hsk_secp256k1_context* ctx,
+    size_t threshold,
+    const size_t *window_max
+) HSK_SECP256K1_ARG_NONNULL(1);
+
+/** Get the multi-scalar multiplication tuning of a context.
+ *
+ *  Returns: 1 always.
+ *  Args: ctx:        an existing context object (cannot be NULL)
+ *  Out:  threshold:  the Strauss/Pippenger crossover (cannot be NULL)
+ *        window_max: array with room for HSK_SECP256K1_ECMULT_MULTI_WINDOWS
+ *                    entries (cannot be NULL)
+ */
+HSK_SECP256K1_API int hsk_secp256k1_context_get_ecmult_multi(
+    const hsk_secp256k1_context* ctx,
+    size_t *threshold,
+    size_t *window_max
+) HSK_SECP256K1_ARG_NONNULL(1) HSK_SECP256K1_ARG_NONNULL(2) HSK_SECP256K1_ARG_NONNULL(3);
+
+/** Smallest and largest window accepted for the generator tables. */
+#define HSK_SECP256K1_ECMULT_WINDOW_MIN 2
+#define HSK_SECP256K1_ECMULT_WINDOW_MAX 24
+
+/** Get the size of the verification tables for a window.
+ *
+ *  Returns: the number of bytes hsk_secp256k1_ecmult_window_table_build
+ *           writes, or 0 if the window is out of range. The size grows as
+ *           2^window and depends on how the library was configured.
+ *  In:   window: window size of the generator tables
+ */
+HSK_SECP256K1_API size_t hsk_secp256k1_ecmult_window_table_size(
+    int window
+);
+
+/** Compute the verification tables for a window into caller memory.
+ *
+ *  The result is meant to be placed in memory shared between processes
+ *  (and mapped read-only by all but the one that built it), then handed to
+ *  hsk_secp256k1_context_set_ecmult_window. It is only valid for this
+ *  build of the library.
+ *
+ *  Returns: 1 on success, 0 if the window is out of range.
+ *  Args: ctx:    an existing context object (cannot be NULL)
+ *  Out:  table:  pointer to hsk_secp256k1_ecmult_window_table_size(window)
+ *                bytes, aligned to 8 bytes (cannot be NULL)
+ *  In:   window: window size of the generator tables
+ */
+HSK_SECP256K1_API int hsk_secp256k1_ecmult_window_table_build(
+    const hsk_secp256k1_context* ctx,
+    void *table,
+    int window
+) HSK_SECP256K1_ARG_NONNULL(1) HSK_SECP256K1_ARG_NONNULL(2);
+
+/** Spot-check verification tables against the generator.
+ *
+ *  Recomputes evenly spaced entries of each table, including the first and
+ *  last, and compares them. Meant for tables obtained from memory another
+ *  process wrote, before handing them to hsk_secp256k1_context_set_ecmult_window.
+ *
+ *  Returns: 1 if every sampled entry matched, 0 otherwise.
+ *  Args: ctx:    an existing context object (cannot be NULL)
+ *  In:   table:  pointer to hsk_secp256k1_ecmult_window_table_size(window)
+ *                bytes, aligned to 8 bytes (cannot be NULL)
+ *        window: window size of the generator tables
+ */
+HSK_SECP256K1_API HSK_SECP256K1_WARN_UNUSED_RESULT int hsk_secp256k1_ecmult_window_table_check(
+    const hsk_secp256k1_context* ctx,
+    const void *table,
+    int window
+) HSK_SECP256K1_ARG_NONNULL(1) HSK_SECP256K1_ARG_NONNULL(2);
+
+/** Select the window of the generator tables used for verification.
+ *
+ *  Larger windows make verification slightly faster at the cost of tables
+ *  growing as 2^window. The context becomes usable for verification even if
+ *  it was created without HSK_SECP256K1_CONTEXT_VERIFY, so a context that
+ *  only needs a shared table never builds a private one.
+ *
+ *  Returns: 1 if the window was applied, 0 if it was out of range.
+ *  Args: ctx:    an existing context object (cannot be NULL)
+ *  In:   window: window size of the generator tables
+ *        table:  tables built by hsk_secp256k1_ecmult_window_table_build for
+ *                the same window, which must stay valid (and unchanged)
+ *                until this context and all its clones are destroyed. If
+ *                NULL, the context builds its own tables; with static
+ *                precomputation windows up to the compiled-in size use the
+ *                read-only static tables instead.
+ *
+ *  The context must not be in use by other threads while it is changed.
+ */
+HSK_SECP256K1_API int hsk_secp256k1_context_set_ecmult_window(
+    hsk_secp256k1_context* ctx,
+    int window,
+    const void *table
+) HSK_SECP256K1_ARG_NONNULL(1);
+
 /** Parse a variable-length public key into the pubkey object.
  *
  *  Returns: 1 if the public key was fully valid.
@@ -299,6 +418,33 @@ HSK_SECP256K1_API HSK_SECP256K1_WARN_UNUSED_RESULT int hsk_secp256k1_ec_pubkey_p
     size_t inputlen
 ) HSK_SECP256K1_ARG_NONNULL(1) HSK_SECP256K1_ARG_NONNULL(2) HSK_SECP256K1_ARG_NONNULL(3);
 
+/** Parse many variable-length public keys into pubkey objects.
+ *
+ *  Equivalent to calling hsk_secp256k1_ec_pubkey_parse on each input, for
+ *  bulk imports such as watch lists. Compressed keys are gathered and their
+ *  square roots computed several at a time, which keeps the multiplier
+ *  busy. Like the single parse, every output holds a normalized affine
+ *  point.
+ *
+ *  Returns: 1 if every public key was fully valid, 0 otherwise.
+ *  Args: ctx:       a secp256k1 context object.
+ *  Out:  pubkeys:   array of n pubkey objects. Each one whose input is
+ *                   invalid is zeroed, as by hsk_secp256k1_ec_pubkey_parse.
+ *        results:   array of n ints set to 1 or 0 for each key, or NULL.
+ *  In:   inputs:    array of n pointers to serialized public keys. NULL
+ *                   entries are reported as invalid.
+ *        inputlens: array of n lengths of the serialized public keys
+ *        n:         number of public keys
+ */
+HSK_SECP256K1_API int hsk_secp256k1_ec_pubkey_parse_batch(
+    const hsk_secp256k1_context* ctx,
+    hsk_secp256k1_pubkey *pubkeys,
+    int *results,
+    const unsigned char *const *inputs,
+    const size_t *inputlens,
+    size_t n
+) HSK_SECP256K1_ARG_NONNULL(1);
+
 /** Serialize a pubkey object into a serialized byte sequence.
  *
  *  Returns: 1 always.
@@ -423,6 +569,33 @@ HSK_SECP256K1_API HSK_SECP256K1_WARN_UNUSED_RESULT int hsk_secp256k1_ecdsa_verif
     const hsk_secp256k1_pubkey *pubkey
 ) HSK_SECP256K1_ARG_NONNULL(1) HSK_SECP256K1_ARG_NONNULL(2) HSK_SECP256K1_ARG_NONNULL(3) HSK_SECP256K1_ARG_NONNULL(4);
 
+/** Verify a batch of ECDSA signatures.
+ *
+ *  Returns: 1: all signatures are correct
+ *           0: at least one signature is incorrect or unparseable
+ *  Args:    ctx:     a secp256k1 context object, initialized for verification.
+ *  Out:     failed:  if not NULL and 0 is returned, set to the index of the
+ *                    first invalid signature (can be NULL)
+ *  In:      sigs:    array of n pointers to signatures
+ *           msgs32:  array of n pointers to 32-byte message hashes
+ *           pubkeys: array of n pointers to public keys
+ *           n:       number of signatures
+ *
+ * Each signature is checked exactly as by hsk_secp256k1_ecdsa_verify. The
+ * s^-1 inversions are shared across the batch. An ECDSA signature does not
+ * determine the y coordinate of R, so the checks cannot be soundly folded into
+ * a single multi-scalar multiplication; each signature still costs one
+ * ecmult.
+ */
+HSK_SECP256K1_API HSK_SECP256K1_WARN_UNUSED_RESULT int hsk_secp256k1_ecdsa_verify_batch(
+    const hsk_secp256k1_context* ctx,
+    const hsk_secp256k1_ecdsa_signature *const *sigs,
+    const unsigned char *const *msgs32,
+    const hsk_secp256k1_pubkey *const *pubkeys,
+    size_t n,
+    size_t *failed
+) HSK_SECP256K1_ARG_NONNULL(1);
+
 /** Convert a signature to a normalized lower-S form.
  *
  *  Returns: 1 if sigin was not normalized, 0 if it already was.
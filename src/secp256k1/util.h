@@ -116,6 +116,22 @@ static HSK_SECP256K1_INLINE void *checked_realloc(const hsk_secp256k1_callback*
 #  define HSK_SECP256K1_GNUC_EXT
 # endif
 HSK_SECP256K1_GNUC_EXT typedef unsigned __int128 uint128_t;
+HSK_SECP256K1_GNUC_EXT typedef __int128 int128_t;
 #endif
 
+/* Count the trailing zero bits of a nonzero x. */
+static HSK_SECP256K1_INLINE int hsk_secp256k1_ctz64_var(uint64_t x) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(x);
+#else
+    static const uint8_t debruijn[64] = {
+        0, 1, 2, 53, 3, 7, 54, 27, 4, 38, 41, 8, 34, 55, 48, 28,
+        62, 5, 39, 46, 44, 42, 22, 9, 24, 35, 59, 56, 49, 18, 29, 11,
+        63, 52, 6, 26, 37, 40, 33, 47, 61, 45, 43, 21, 23, 58, 17, 10,
+        51, 25, 36, 32, 60, 20, 57, 16, 50, 31, 19, 15, 30, 14, 13, 12
+    };
+    return debruijn[((x & -x) * 0x022FDD63CC95386DULL) >> 58];
+#endif
+}
+
 #endif /* HSK_SECP256K1_UTIL_H */
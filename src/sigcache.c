@@ -0,0 +1,344 @@
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sigcache.h"
+
+// The vendored secp256k1 SHA-256 is the only one in the tree.
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-function"
+#endif
+#include "secp256k1/hash_impl.h"
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+
+/*
+ * Slots
+ */
+
+static void
+bch_sigcache_load(const uint8_t *key, uint64_t *words) {
+  memcpy(words, key, 32);
+}
+
+static bool
+bch_sigcache_empty(const uint64_t *words) {
+  return (words[0] | words[1] | words[2] | words[3]) == 0;
+}
+
+// Digests are salted hashes, so any two words
+// are independent bucket indices.
+static size_t
+bch_sigcache_bucket(const bch_sigcache_t *cache, const uint64_t *words, int i) {
+  size_t b1 = (size_t)words[0] & cache->mask;
+  size_t b2 = (size_t)words[1] & cache->mask;
+
+  if (b2 == b1)
+    b2 = b1 ^ 1;
+
+  return i == 0 ? b1 : b2;
+}
+
+static size_t
+bch_sigcache_other(const bch_sigcache_t *cache, const uint64_t *words, size_t b) {
+  size_t b1 = bch_sigcache_bucket(cache, words, 0);
+
+  return b == b1 ? bch_sigcache_bucket(cache, words, 1) : b1;
+}
+
+static bool
+bch_sigcache_read(const bch_sigcache_slot_t *slot, uint64_t *words) {
+  uint_fast64_t seq1, seq2;
+  int i;
+
+  seq1 = atomic_load_explicit((atomic_uint_fast64_t *)&slot->seq,
+                              memory_order_acquire);
+
+  if (seq1 & 1)
+    return false;
+
+  for (i = 0; i < 4; i++) {
+    words[i] = atomic_load_explicit((atomic_uint_fast64_t *)&slot->key[i],
+                                    memory_order_relaxed);
+  }
+
+  atomic_thread_fence(memory_order_acquire);
+
+  seq2 = atomic_load_explicit((atomic_uint_fast64_t *)&slot->seq,
+                              memory_order_relaxed);
+
+  return seq1 == seq2;
+}
+
+static bool
+bch_sigcache_lock(bch_sigcache_slot_t *slot, uint_fast64_t *seq) {
+  uint_fast64_t cur = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+
+  if (cur & 1)
+    return false;
+
+  if (!atomic_compare_exchange_strong_explicit(&slot->seq, &cur, cur + 1,
+                                               memory_order_acquire,
+                                               memory_order_relaxed)) {
+    return false;
+  }
+
+  atomic_thread_fence(memory_order_release);
+
+  *seq = cur;
+
+  return true;
+}
+
+static void
+bch_sigcache_unlock(bch_sigcache_slot_t *slot, uint_fast64_t seq) {
+  atomic_store_explicit(&slot->seq, seq + 2, memory_order_release);
+}
+
+// Swap `words` into a locked slot, returning
+// the previous contents in `words`.
+static void
+bch_sigcache_swap(bch_sigcache_slot_t *slot, uint64_t *words) {
+  uint64_t old;
+  int i;
+
+  for (i = 0; i < 4; i++) {
+    old = atomic_load_explicit(&slot->key[i], memory_order_relaxed);
+    atomic_store_explicit(&slot->key[i], words[i], memory_order_relaxed);
+    words[i] = old;
+  }
+}
+
+// Claim an empty slot in a bucket.
+static bool
+bch_sigcache_place(bch_sigcache_t *cache, size_t b, const uint64_t *words) {
+  bch_sigcache_slot_t *bucket = &cache->slots[b * BCH_SIGCACHE_WAYS];
+  uint64_t cur[4];
+  uint_fast64_t seq;
+  int i;
+
+  for (i = 0; i < BCH_SIGCACHE_WAYS; i++) {
+    bch_sigcache_slot_t *slot = &bucket[i];
+
+    if (!bch_sigcache_read(slot, cur) || !bch_sigcache_empty(cur))
+      continue;
+
+    if (!bch_sigcache_lock(slot, &seq))
+      continue;
+
+    memcpy(cur, words, 32);
+    bch_sigcache_swap(slot, cur);
+
+    // Filled by someone else in the meantime: put it back.
+    if (!bch_sigcache_empty(cur)) {
+      bch_sigcache_swap(slot, cur);
+      bch_sigcache_unlock(slot, seq);
+      continue;
+    }
+
+    bch_sigcache_unlock(slot, seq);
+
+    return true;
+  }
+
+  return false;
+}
+
+/*
+ * Sigcache
+ */
+
+void
+bch_sigcache_init(bch_sigcache_t *cache) {
+  assert(cache && "cache is null");
+
+  cache->slots = NULL;
+  cache->mask = 0;
+  memset(cache->midstate, 0, sizeof(cache->midstate));
+  atomic_init(&cache->counter, 0);
+}
+
+void
+bch_sigcache_uninit(bch_sigcache_t *cache) {
+  if (!cache)
+    return;
+
+  if (cache->slots) {
+    free(cache->slots);
+    cache->slots = NULL;
+  }
+
+  cache->mask = 0;
+}
+
+// Size the table to at most `size` bytes (rounded down
+// to a power of two buckets) and drop all entries. The
+// salt is 32 secret random bytes. Not thread safe.
+bool
+bch_sigcache_reset(bch_sigcache_t *cache, size_t size, const uint8_t *salt) {
+  assert(cache && "cache is null");
+  assert(salt && "salt is null");
+
+  const size_t bucket_size = sizeof(bch_sigcache_slot_t) * BCH_SIGCACHE_WAYS;
+  hsk_secp256k1_sha256 sha;
+  uint8_t block[64];
+  size_t buckets = 2;
+  size_t i;
+
+  while (buckets * 2 <= size / bucket_size)
+    buckets *= 2;
+
+  bch_sigcache_slot_t *slots = malloc(buckets * bucket_size);
+
+  if (!slots)
+    return false;
+
+  for (i = 0; i < buckets * BCH_SIGCACHE_WAYS; i++) {
+    atomic_init(&slots[i].seq, 0);
+    atomic_init(&slots[i].key[0], 0);
+    atomic_init(&slots[i].key[1], 0);
+    atomic_init(&slots[i].key[2], 0);
+    atomic_init(&slots[i].key[3], 0);
+  }
+
+  bch_sigcache_uninit(cache);
+
+  cache->slots = slots;
+  cache->mask = buckets - 1;
+
+  // Pad the salt to a full block so every key
+  // starts from the same midstate.
+  memset(block, 0, sizeof(block));
+  memcpy(block, salt, 32);
+
+  hsk_secp256k1_sha256_initialize(&sha);
+  hsk_secp256k1_sha256_write(&sha, block, sizeof(block));
+  memcpy(cache->midstate, sha.s, sizeof(cache->midstate));
+
+  return true;
+}
+
+// key = SHA256(salt || type || msg || len(pub) || pub || len(sig) || sig)
+void
+bch_sigcache_key(
+  const bch_sigcache_t *cache,
+  uint8_t *key,
+  uint8_t type,
+  const uint8_t *msg,
+  const uint8_t *pub,
+  size_t pub_len,
+  const uint8_t *sig,
+  size_t sig_len
+) {
+  assert(cache && "cache is null");
+  assert(key && "key is null");
+  assert(msg && "msg is null");
+  assert(pub && "pub is null");
+  assert(sig && "sig is null");
+  assert(pub_len <= 0xff && "pub_len too large");
+  assert(sig_len <= 0xff && "sig_len too large");
+
+  hsk_secp256k1_sha256 sha;
+  uint8_t len;
+
+  memcpy(sha.s, cache->midstate, sizeof(cache->midstate));
+  sha.bytes = 64;
+
+  hsk_secp256k1_sha256_write(&sha, &type, 1);
+  hsk_secp256k1_sha256_write(&sha, msg, 32);
+
+  len = (uint8_t)pub_len;
+  hsk_secp256k1_sha256_write(&sha, &len, 1);
+  hsk_secp256k1_sha256_write(&sha, pub, pub_len);
+
+  len = (uint8_t)sig_len;
+  hsk_secp256k1_sha256_write(&sha, &len, 1);
+  hsk_secp256k1_sha256_write(&sha, sig, sig_len);
+
+  hsk_secp256k1_sha256_finalize(&sha, key);
+}
+
+bool
+bch_sigcache_has(const bch_sigcache_t *cache, const uint8_t *key) {
+  assert(cache && "cache is null");
+  assert(key && "key is null");
+
+  uint64_t words[4];
+  uint64_t cur[4];
+  int i, j;
+
+  if (!cache->slots)
+    return false;
+
+  bch_sigcache_load(key, words);
+
+  for (i = 0; i < 2; i++) {
+    size_t b = bch_sigcache_bucket(cache, words, i);
+    const bch_sigcache_slot_t *bucket = &cache->slots[b * BCH_SIGCACHE_WAYS];
+
+    for (j = 0; j < BCH_SIGCACHE_WAYS; j++) {
+      if (bch_sigcache_read(&bucket[j], cur) && memcmp(cur, words, 32) == 0)
+        return true;
+    }
+  }
+
+  return false;
+}
+
+void
+bch_sigcache_add(bch_sigcache_t *cache, const uint8_t *key) {
+  assert(cache && "cache is null");
+  assert(key && "key is null");
+
+  uint64_t words[4];
+  uint_fast64_t seq;
+  size_t b, n;
+  int i;
+
+  if (!cache->slots)
+    return;
+
+  bch_sigcache_load(key, words);
+
+  // An all-zero digest marks an empty slot.
+  if (bch_sigcache_empty(words))
+    return;
+
+  if (bch_sigcache_has(cache, key))
+    return;
+
+  if (bch_sigcache_place(cache, bch_sigcache_bucket(cache, words, 0), words))
+    return;
+
+  b = bch_sigcache_bucket(cache, words, 1);
+
+  for (i = 0; i < BCH_SIGCACHE_MAX_KICKS; i++) {
+    bch_sigcache_slot_t *slot;
+
+    if (bch_sigcache_place(cache, b, words))
+      return;
+
+    // Both buckets are full: evict a pseudo-random
+    // slot and move its entry to its other bucket.
+    n = atomic_fetch_add_explicit(&cache->counter, 1, memory_order_relaxed);
+    slot = &cache->slots[b * BCH_SIGCACHE_WAYS + (n % BCH_SIGCACHE_WAYS)];
+
+    if (!bch_sigcache_lock(slot, &seq))
+      return;
+
+    bch_sigcache_swap(slot, words);
+    bch_sigcache_unlock(slot, seq);
+
+    if (bch_sigcache_empty(words))
+      return;
+
+    b = bch_sigcache_other(cache, words, b);
+  }
+
+  // The last displaced entry is dropped.
+}
@@ -0,0 +1,75 @@
+#ifndef _BCH_SIGCACHE_H
+#define _BCH_SIGCACHE_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+/*
+ * Signature cache.
+ *
+ * Remembers signatures that verified, keyed by a salted
+ * SHA-256 of (type, sighash, pubkey, sig), so a transaction
+ * seen once from relay and again in a block or from another
+ * peer is only verified once. The salt is secret and chosen
+ * per process, so peers cannot aim collisions at the table.
+ *
+ * The table is a bounded cuckoo hash of 32-byte digests:
+ * each digest may live in one of two buckets of
+ * BCH_SIGCACHE_WAYS slots, and an insert into two full
+ * buckets displaces an entry into its other bucket, at most
+ * BCH_SIGCACHE_MAX_KICKS times before the last displaced
+ * entry is dropped.
+ *
+ * Lookups and inserts are lock-free and safe from any
+ * thread. Each slot is guarded by a sequence counter: a
+ * reader that races a writer just misses (and verifies
+ * again), and a writer that races another skips the slot.
+ */
+
+#define BCH_SIGCACHE_WAYS 4
+#define BCH_SIGCACHE_MAX_KICKS 8
+#define BCH_SIGCACHE_DEFAULT_SIZE (32 << 20)
+
+typedef struct bch_sigcache_slot_s {
+  // Odd while being written.
+  atomic_uint_fast64_t seq;
+  atomic_uint_fast64_t key[4];
+} bch_sigcache_slot_t;
+
+typedef struct bch_sigcache_s {
+  bch_sigcache_slot_t *slots;
+  size_t mask;
+  // SHA-256 state after the salt block.
+  uint32_t midstate[8];
+  atomic_size_t counter;
+} bch_sigcache_t;
+
+void
+bch_sigcache_init(bch_sigcache_t *cache);
+
+void
+bch_sigcache_uninit(bch_sigcache_t *cache);
+
+bool
+bch_sigcache_reset(bch_sigcache_t *cache, size_t size, const uint8_t *salt);
+
+void
+bch_sigcache_key(
+  const bch_sigcache_t *cache,
+  uint8_t *key,
+  uint8_t type,
+  const uint8_t *msg,
+  const uint8_t *pub,
+  size_t pub_len,
+  const uint8_t *sig,
+  size_t sig_len
+);
+
+bool
+bch_sigcache_has(const bch_sigcache_t *cache, const uint8_t *key);
+
+void
+bch_sigcache_add(bch_sigcache_t *cache, const uint8_t *key);
+#endif
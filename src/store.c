@@ -0,0 +1,265 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "header.h"
+#include "store.h"
+
+// Bytes consumed by a single height across all columns.
+#define BCH_STORE_STRIDE (32 * 4 + 4 * 4)
+
+#define BCH_STORE_MIN_CAPACITY 2048
+
+static void
+bch_store_layout(bch_store_t *store, uint8_t *slab, uint32_t capacity) {
+  uint8_t *p = slab;
+
+  store->slab = slab;
+  store->capacity = capacity;
+
+  store->hashes = (uint8_t (*)[32])p;
+  p += (size_t)capacity * 32;
+
+  store->prev_blocks = (uint8_t (*)[32])p;
+  p += (size_t)capacity * 32;
+
+  store->works = (uint8_t (*)[32])p;
+  p += (size_t)capacity * 32;
+
+  store->merkle_roots = (uint8_t (*)[32])p;
+  p += (size_t)capacity * 32;
+
+  store->bits = (uint32_t *)p;
+  p += (size_t)capacity * 4;
+
+  store->times = (uint32_t *)p;
+  p += (size_t)capacity * 4;
+
+  store->versions = (uint32_t *)p;
+  p += (size_t)capacity * 4;
+
+  store->nonces = (uint8_t (*)[4])p;
+}
+
+void
+bch_store_init(bch_store_t *store, uint32_t start) {
+  assert(store && "store is null");
+
+  store->start = start;
+  store->size = 0;
+  store->capacity = 0;
+  store->slab = NULL;
+  store->hashes = NULL;
+  store->prev_blocks = NULL;
+  store->works = NULL;
+  store->bits = NULL;
+  store->times = NULL;
+  store->merkle_roots = NULL;
+  store->versions = NULL;
+  store->nonces = NULL;
+}
+
+void
+bch_store_uninit(bch_store_t *store) {
+  assert(store && "store is null");
+
+  if (store->slab)
+    free(store->slab);
+
+  bch_store_init(store, store->start);
+}
+
+bch_store_t *
+bch_store_alloc(uint32_t start) {
+  bch_store_t *store = malloc(sizeof(bch_store_t));
+
+  if (!store)
+    return NULL;
+
+  bch_store_init(store, start);
+
+  return store;
+}
+
+void
+bch_store_free(bch_store_t *store) {
+  assert(store && "store is null");
+  bch_store_uninit(store);
+  free(store);
+}
+
+bool
+bch_store_reserve(bch_store_t *store, uint32_t capacity) {
+  assert(store && "store is null");
+
+  if (capacity <= store->capacity)
+    return true;
+
+  // Only a 32 bit size_t can overflow here.
+#if SIZE_MAX <= UINT32_MAX
+  if ((size_t)capacity > SIZE_MAX / BCH_STORE_STRIDE)
+    return false;
+#endif
+
+  uint8_t *slab = malloc((size_t)capacity * BCH_STORE_STRIDE);
+
+  if (!slab)
+    return false;
+
+  bch_store_t next;
+  bch_store_layout(&next, slab, capacity);
+
+  size_t n = store->size;
+
+  if (n > 0) {
+    memcpy(next.hashes, store->hashes, n * 32);
+    memcpy(next.prev_blocks, store->prev_blocks, n * 32);
+    memcpy(next.works, store->works, n * 32);
+    memcpy(next.merkle_roots, store->merkle_roots, n * 32);
+    memcpy(next.bits, store->bits, n * 4);
+    memcpy(next.times, store->times, n * 4);
+    memcpy(next.versions, store->versions, n * 4);
+    memcpy(next.nonces, store->nonces, n * 4);
+  }
+
+  if (store->slab)
+    free(store->slab);
+
+  bch_store_layout(store, slab, capacity);
+
+  return true;
+}
+
+bool
+bch_store_push(bch_store_t *store, const bch_header_t *hdr) {
+  assert(store && "store is null");
+  assert(hdr && "hdr is null");
+
+  // Headers must be appended in height order.
+  if (hdr->height != bch_store_end(store))
+    return false;
+
+  if (hdr->time > 0xffffffff)
+    return false;
+
+  // The hash and work are stored as given and
+  // handed back as valid by bch_store_get().
+  if (!hdr->cache)
+    return false;
+
+  if (store->size == store->capacity) {
+    uint32_t capacity = store->capacity;
+
+    if (capacity < BCH_STORE_MIN_CAPACITY)
+      capacity = BCH_STORE_MIN_CAPACITY;
+    else if (capacity > UINT32_MAX / 2)
+      capacity = UINT32_MAX;
+    else
+      capacity *= 2;
+
+    if (capacity == store->capacity)
+      return false;
+
+    if (!bch_store_reserve(store, capacity))
+      return false;
+  }
+
+  uint32_t i = store->size;
+
+  memcpy(store->hashes[i], hdr->hash, 32);
+  memcpy(store->prev_blocks[i], hdr->prev_block, 32);
+  memcpy(store->works[i], hdr->work, 32);
+  memcpy(store->merkle_roots[i], hdr->merkle_root, 32);
+  store->bits[i] = hdr->bits;
+  store->times[i] = (uint32_t)hdr->time;
+  store->versions[i] = hdr->version;
+  memcpy(store->nonces[i], hdr->nonce, 4);
+
+  store->size += 1;
+
+  return true;
+}
+
+bool
+bch_store_get(const bch_store_t *store, uint32_t height, bch_header_t *hdr) {
+  assert(store && "store is null");
+  assert(hdr && "hdr is null");
+
+  if (!bch_store_has(store, height))
+    return false;
+
+  uint32_t i = height - store->start;
+
+  bch_header_init(hdr);
+
+  hdr->version = store->versions[i];
+  memcpy(hdr->prev_block, store->prev_blocks[i], 32);
+  memcpy(hdr->merkle_root, store->merkle_roots[i], 32);
+  hdr->time = (uint64_t)store->times[i];
+  hdr->bits = store->bits[i];
+  memcpy(hdr->nonce, store->nonces[i], 4);
+
+  hdr->cache = true;
+  memcpy(hdr->hash, store->hashes[i], 32);
+  hdr->height = height;
+  memcpy(hdr->work, store->works[i], 32);
+
+  return true;
+}
+
+bool
+bch_store_tip(const bch_store_t *store, bch_header_t *hdr) {
+  assert(store && "store is null");
+
+  if (store->size == 0)
+    return false;
+
+  return bch_store_get(store, bch_store_end(store) - 1, hdr);
+}
+
+void
+bch_store_truncate(bch_store_t *store, uint32_t height) {
+  assert(store && "store is null");
+
+  // Keep everything up to and including `height`.
+  if (height < store->start) {
+    store->size = 0;
+    return;
+  }
+
+  if (height - store->start + 1 < store->size)
+    store->size = height - store->start + 1;
+}
+
+bool
+bch_store_find(
+  const bch_store_t *store,
+  const uint8_t *hash,
+  uint32_t limit,
+  uint32_t *height
+) {
+  assert(store && "store is null");
+  assert(hash && "hash is null");
+
+  uint32_t i = store->size;
+  uint32_t end = 0;
+
+  // Scan backwards from the tip: forks
+  // almost always land near the top.
+  if (limit != 0 && limit < store->size)
+    end = store->size - limit;
+
+  while (i > end) {
+    i -= 1;
+
+    if (memcmp(store->hashes[i], hash, 32) == 0) {
+      if (height)
+        *height = store->start + i;
+      return true;
+    }
+  }
+
+  return false;
+}
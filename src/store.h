@@ -0,0 +1,86 @@
+#ifndef _BCH_STORE_H
+#define _BCH_STORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "header.h"
+
+/*
+ * Header chain store.
+ *
+ * Headers are kept in a single height-indexed arena rather than
+ * as individually allocated `bch_header_t` objects. Each field
+ * lives in its own column so that walks over the hot fields
+ * (hash, prev_block, bits, time, work) touch contiguous memory.
+ */
+
+typedef struct bch_store_s {
+  uint32_t start;
+  uint32_t size;
+  uint32_t capacity;
+  uint8_t *slab;
+
+  // Hot columns.
+  uint8_t (*hashes)[32];
+  uint8_t (*prev_blocks)[32];
+  uint8_t (*works)[32];
+  uint32_t *bits;
+  uint32_t *times;
+
+  // Cold columns.
+  uint8_t (*merkle_roots)[32];
+  uint32_t *versions;
+  uint8_t (*nonces)[4];
+} bch_store_t;
+
+#define bch_store_start(store) ((store)->start)
+#define bch_store_end(store) ((store)->start + (store)->size)
+#define bch_store_has(store, h) \
+  ((h) >= (store)->start && (h) - (store)->start < (store)->size)
+
+// Unchecked column accessors. Callers must
+// test the height with `bch_store_has` first.
+#define bch_store_hash(store, h) ((store)->hashes[(h) - (store)->start])
+#define bch_store_prev_block(store, h) \
+  ((store)->prev_blocks[(h) - (store)->start])
+#define bch_store_work(store, h) ((store)->works[(h) - (store)->start])
+#define bch_store_bits(store, h) ((store)->bits[(h) - (store)->start])
+#define bch_store_time(store, h) ((store)->times[(h) - (store)->start])
+
+void
+bch_store_init(bch_store_t *store, uint32_t start);
+
+void
+bch_store_uninit(bch_store_t *store);
+
+bch_store_t *
+bch_store_alloc(uint32_t start);
+
+void
+bch_store_free(bch_store_t *store);
+
+bool
+bch_store_reserve(bch_store_t *store, uint32_t capacity);
+
+bool
+bch_store_push(bch_store_t *store, const bch_header_t *hdr);
+
+bool
+bch_store_get(const bch_store_t *store, uint32_t height, bch_header_t *hdr);
+
+bool
+bch_store_tip(const bch_store_t *store, bch_header_t *hdr);
+
+void
+bch_store_truncate(bch_store_t *store, uint32_t height);
+
+bool
+bch_store_find(
+  const bch_store_t *store,
+  const uint8_t *hash,
+  uint32_t limit,
+  uint32_t *height
+);
+#endif
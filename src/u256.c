@@ -0,0 +1,540 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "u256.h"
+
+/*
+ * Limb helpers
+ */
+
+#ifdef __SIZEOF_INT128__
+typedef unsigned __int128 bch_u128_t;
+
+static inline uint64_t
+bch_mul64(uint64_t a, uint64_t b, uint64_t *hi) {
+  bch_u128_t p = (bch_u128_t)a * b;
+  *hi = (uint64_t)(p >> 64);
+  return (uint64_t)p;
+}
+#else
+static inline uint64_t
+bch_mul64(uint64_t a, uint64_t b, uint64_t *hi) {
+  uint64_t al = a & 0xffffffff;
+  uint64_t ah = a >> 32;
+  uint64_t bl = b & 0xffffffff;
+  uint64_t bh = b >> 32;
+  uint64_t ll = al * bl;
+  uint64_t lh = al * bh;
+  uint64_t hl = ah * bl;
+  uint64_t hh = ah * bh;
+  uint64_t mid = (ll >> 32) + (lh & 0xffffffff) + (hl & 0xffffffff);
+
+  *hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+
+  return (mid << 32) | (ll & 0xffffffff);
+}
+#endif
+
+static inline int
+bch_clz64(uint64_t x) {
+  assert(x != 0 && "clz of zero");
+#if defined(__GNUC__)
+  return __builtin_clzll(x);
+#else
+  int n = 0;
+
+  while (!(x & ((uint64_t)1 << 63))) {
+    x <<= 1;
+    n += 1;
+  }
+
+  return n;
+#endif
+}
+
+// Reciprocal of a normalized divisor:
+// floor((2^128 - 1) / d) - 2^64.
+static uint64_t
+bch_reciprocal_2by1(uint64_t d) {
+  assert((d & ((uint64_t)1 << 63)) && "divisor not normalized");
+#ifdef __SIZEOF_INT128__
+  return (uint64_t)(~(bch_u128_t)0 / d);
+#else
+  // Shift-subtract of (2^64 - 1 - d) * 2^64 + (2^64 - 1) by d.
+  uint64_t hi = ~d;
+  uint64_t lo = ~(uint64_t)0;
+  uint64_t q = 0;
+  int i;
+
+  for (i = 0; i < 64; i++) {
+    bool top = hi >> 63;
+
+    hi = (hi << 1) | (lo >> 63);
+    lo <<= 1;
+    q <<= 1;
+
+    if (top || hi >= d) {
+      hi -= d;
+      q |= 1;
+    }
+  }
+
+  return q;
+#endif
+}
+
+// Divide the two limb value (u1, u0) by the normalized
+// divisor d, given its reciprocal v. Requires u1 < d.
+// Möller & Granlund, "Improved division by invariant
+// integers", algorithm 4.
+static inline uint64_t
+bch_udivrem_2by1(
+  uint64_t u1,
+  uint64_t u0,
+  uint64_t d,
+  uint64_t v,
+  uint64_t *rem
+) {
+  uint64_t q1, q0, r;
+
+  q0 = bch_mul64(v, u1, &q1);
+  q0 += u0;
+  q1 += u1 + (q0 < u0);
+  q1 += 1;
+
+  r = u0 - q1 * d;
+
+  if (r > q0) {
+    q1 -= 1;
+    r += d;
+  }
+
+  if (r >= d) {
+    q1 += 1;
+    r -= d;
+  }
+
+  *rem = r;
+
+  return q1;
+}
+
+/*
+ * Conversion
+ */
+
+void
+bch_u256_set_u64(bch_u256_t *r, uint64_t v) {
+  assert(r && "r is null");
+
+  r->limbs[0] = v;
+  r->limbs[1] = 0;
+  r->limbs[2] = 0;
+  r->limbs[3] = 0;
+}
+
+// 32 bytes, big endian (same as `bch_bn_to_array`).
+void
+bch_u256_import(bch_u256_t *r, const uint8_t *data) {
+  assert(r && "r is null");
+  assert(data && "data is null");
+
+  int i;
+
+  for (i = 0; i < 4; i++) {
+    const uint8_t *p = &data[(3 - i) * 8];
+
+    r->limbs[i] = ((uint64_t)p[0] << 56)
+                | ((uint64_t)p[1] << 48)
+                | ((uint64_t)p[2] << 40)
+                | ((uint64_t)p[3] << 32)
+                | ((uint64_t)p[4] << 24)
+                | ((uint64_t)p[5] << 16)
+                | ((uint64_t)p[6] << 8)
+                | ((uint64_t)p[7]);
+  }
+}
+
+void
+bch_u256_export(const bch_u256_t *a, uint8_t *data) {
+  assert(a && "a is null");
+  assert(data && "data is null");
+
+  int i;
+
+  for (i = 0; i < 4; i++) {
+    uint8_t *p = &data[(3 - i) * 8];
+    uint64_t w = a->limbs[i];
+
+    p[0] = (uint8_t)(w >> 56);
+    p[1] = (uint8_t)(w >> 48);
+    p[2] = (uint8_t)(w >> 40);
+    p[3] = (uint8_t)(w >> 32);
+    p[4] = (uint8_t)(w >> 24);
+    p[5] = (uint8_t)(w >> 16);
+    p[6] = (uint8_t)(w >> 8);
+    p[7] = (uint8_t)w;
+  }
+}
+
+/*
+ * Comparison
+ */
+
+bool
+bch_u256_is_zero(const bch_u256_t *a) {
+  assert(a && "a is null");
+
+  return (a->limbs[0] | a->limbs[1] | a->limbs[2] | a->limbs[3]) == 0;
+}
+
+int
+bch_u256_cmp(const bch_u256_t *a, const bch_u256_t *b) {
+  assert(a && "a is null");
+  assert(b && "b is null");
+
+  int i;
+
+  for (i = 3; i >= 0; i--) {
+    if (a->limbs[i] != b->limbs[i])
+      return a->limbs[i] < b->limbs[i] ? -1 : 1;
+  }
+
+  return 0;
+}
+
+int
+bch_u256_bits(const bch_u256_t *a) {
+  assert(a && "a is null");
+
+  int i;
+
+  for (i = 3; i >= 0; i--) {
+    if (a->limbs[i] != 0)
+      return i * 64 + (64 - bch_clz64(a->limbs[i]));
+  }
+
+  return 0;
+}
+
+/*
+ * Arithmetic
+ */
+
+void
+bch_u256_not(bch_u256_t *r, const bch_u256_t *a) {
+  assert(r && "r is null");
+  assert(a && "a is null");
+
+  r->limbs[0] = ~a->limbs[0];
+  r->limbs[1] = ~a->limbs[1];
+  r->limbs[2] = ~a->limbs[2];
+  r->limbs[3] = ~a->limbs[3];
+}
+
+// Returns the carry out.
+bool
+bch_u256_add(bch_u256_t *r, const bch_u256_t *a, const bch_u256_t *b) {
+  assert(r && "r is null");
+  assert(a && "a is null");
+  assert(b && "b is null");
+
+  uint64_t c = 0;
+  int i;
+
+  for (i = 0; i < 4; i++) {
+    uint64_t x = a->limbs[i] + c;
+    uint64_t y = x + b->limbs[i];
+
+    c = (x < c) + (y < x);
+    r->limbs[i] = y;
+  }
+
+  return c != 0;
+}
+
+// Returns the borrow out.
+bool
+bch_u256_sub(bch_u256_t *r, const bch_u256_t *a, const bch_u256_t *b) {
+  assert(r && "r is null");
+  assert(a && "a is null");
+  assert(b && "b is null");
+
+  uint64_t c = 0;
+  int i;
+
+  for (i = 0; i < 4; i++) {
+    uint64_t x = a->limbs[i];
+    uint64_t y = x - b->limbs[i];
+    uint64_t z = y - c;
+
+    c = (y > x) + (z > y);
+    r->limbs[i] = z;
+  }
+
+  return c != 0;
+}
+
+bool
+bch_u256_add_u64(bch_u256_t *r, const bch_u256_t *a, uint64_t b) {
+  assert(r && "r is null");
+  assert(a && "a is null");
+
+  uint64_t c = b;
+  int i;
+
+  for (i = 0; i < 4; i++) {
+    uint64_t x = a->limbs[i] + c;
+
+    c = x < c;
+    r->limbs[i] = x;
+  }
+
+  return c != 0;
+}
+
+// Truncating multiply. Returns true if
+// the full product did not fit in 256 bits.
+bool
+bch_u256_mul(bch_u256_t *r, const bch_u256_t *a, const bch_u256_t *b) {
+  assert(r && "r is null");
+  assert(a && "a is null");
+  assert(b && "b is null");
+
+  uint64_t t[4] = {0, 0, 0, 0};
+  bool overflow = false;
+  int i, j;
+
+  for (i = 0; i < 4; i++) {
+    uint64_t c = 0;
+
+    if (a->limbs[i] == 0)
+      continue;
+
+    for (j = 0; i + j < 4; j++) {
+      uint64_t hi;
+      uint64_t lo = bch_mul64(a->limbs[i], b->limbs[j], &hi);
+
+      lo += c;
+      hi += lo < c;
+      lo += t[i + j];
+      hi += lo < t[i + j];
+
+      t[i + j] = lo;
+      c = hi;
+    }
+
+    if (c != 0)
+      overflow = true;
+
+    for (; j < 4; j++) {
+      if (b->limbs[j] != 0)
+        overflow = true;
+    }
+  }
+
+  memcpy(r->limbs, t, sizeof(t));
+
+  return overflow;
+}
+
+// Knuth's algorithm D with 64 bit digits. Quotient digits
+// are estimated with a 2-by-1 reciprocal division so the
+// inner loop has no hardware divide. Either output may be
+// NULL. Returns false on division by zero.
+bool
+bch_u256_divmod(
+  bch_u256_t *q,
+  bch_u256_t *r,
+  const bch_u256_t *a,
+  const bch_u256_t *b
+) {
+  assert(a && "a is null");
+  assert(b && "b is null");
+
+  uint64_t un[5];
+  uint64_t dn[4];
+  uint64_t qn[4] = {0, 0, 0, 0};
+  uint64_t d, v, rem;
+  int n, m, s, i, j;
+
+  n = 4;
+
+  while (n > 0 && b->limbs[n - 1] == 0)
+    n -= 1;
+
+  if (n == 0)
+    return false;
+
+  m = 4;
+
+  while (m > 0 && a->limbs[m - 1] == 0)
+    m -= 1;
+
+  if (m < n || bch_u256_cmp(a, b) < 0) {
+    if (r)
+      *r = *a;
+
+    if (q)
+      bch_u256_set_u64(q, 0);
+
+    return true;
+  }
+
+  // Normalize so the top divisor limb has its high bit set.
+  s = bch_clz64(b->limbs[n - 1]);
+
+  if (s == 0) {
+    for (i = 0; i < n; i++)
+      dn[i] = b->limbs[i];
+
+    for (i = 0; i < m; i++)
+      un[i] = a->limbs[i];
+
+    un[m] = 0;
+  } else {
+    for (i = n - 1; i > 0; i--)
+      dn[i] = (b->limbs[i] << s) | (b->limbs[i - 1] >> (64 - s));
+
+    dn[0] = b->limbs[0] << s;
+
+    un[m] = a->limbs[m - 1] >> (64 - s);
+
+    for (i = m - 1; i > 0; i--)
+      un[i] = (a->limbs[i] << s) | (a->limbs[i - 1] >> (64 - s));
+
+    un[0] = a->limbs[0] << s;
+  }
+
+  d = dn[n - 1];
+  v = bch_reciprocal_2by1(d);
+
+  if (n == 1) {
+    rem = un[m];
+
+    for (j = m - 1; j >= 0; j--)
+      qn[j] = bch_udivrem_2by1(rem, un[j], d, v, &rem);
+
+    un[0] = rem;
+  } else {
+    for (j = m - n; j >= 0; j--) {
+      uint64_t qhat, rhat, borrow, carry;
+
+      if (un[j + n] >= d) {
+        // Can only be equal; the estimate saturates.
+        qhat = ~(uint64_t)0;
+      } else {
+        uint64_t ph, pl;
+
+        qhat = bch_udivrem_2by1(un[j + n], un[j + n - 1], d, v, &rhat);
+
+        // Refine with the second divisor limb.
+        for (;;) {
+          pl = bch_mul64(qhat, dn[n - 2], &ph);
+
+          if (ph < rhat || (ph == rhat && pl <= un[j + n - 2]))
+            break;
+
+          qhat -= 1;
+          rhat += d;
+
+          if (rhat < d)
+            break;
+        }
+      }
+
+      // Multiply and subtract.
+      borrow = 0;
+      carry = 0;
+
+      for (i = 0; i < n; i++) {
+        uint64_t ph;
+        uint64_t pl = bch_mul64(qhat, dn[i], &ph);
+        uint64_t t;
+
+        pl += carry;
+        ph += pl < carry;
+        carry = ph;
+
+        t = un[i + j] - pl;
+        ph = t > un[i + j];
+        un[i + j] = t - borrow;
+        borrow = ph + (un[i + j] > t);
+      }
+
+      {
+        uint64_t t = un[j + n] - carry;
+        uint64_t b2 = t > un[j + n];
+
+        un[j + n] = t - borrow;
+        borrow = b2 + (un[j + n] > t);
+      }
+
+      // Estimate was one too large: add back.
+      if (borrow) {
+        qhat -= 1;
+        carry = 0;
+
+        for (i = 0; i < n; i++) {
+          uint64_t t = un[i + j] + carry;
+          uint64_t u = t + dn[i];
+
+          carry = (t < carry) + (u < t);
+          un[i + j] = u;
+        }
+
+        un[j + n] += carry;
+      }
+
+      qn[j] = qhat;
+    }
+  }
+
+  if (q)
+    memcpy(q->limbs, qn, sizeof(qn));
+
+  if (r) {
+    bch_u256_set_u64(r, 0);
+
+    if (s == 0) {
+      for (i = 0; i < n; i++)
+        r->limbs[i] = un[i];
+    } else {
+      for (i = 0; i < n - 1; i++)
+        r->limbs[i] = (un[i] >> s) | (un[i + 1] << (64 - s));
+
+      r->limbs[n - 1] = un[n - 1] >> s;
+    }
+  }
+
+  return true;
+}
+
+// Expected number of hashes for a target:
+// 2^256 / (target + 1), computed without a
+// 257 bit intermediate as ~target / (target + 1) + 1.
+bool
+bch_u256_work(bch_u256_t *r, const bch_u256_t *target) {
+  assert(r && "r is null");
+  assert(target && "target is null");
+
+  bch_u256_t num, den;
+
+  if (bch_u256_add_u64(&den, target, 1)) {
+    // Target of 2^256 - 1: one hash.
+    bch_u256_set_u64(r, 1);
+    return true;
+  }
+
+  bch_u256_not(&num, target);
+
+  if (!bch_u256_divmod(r, NULL, &num, &den))
+    return false;
+
+  bch_u256_add_u64(r, r, 1);
+
+  return true;
+}
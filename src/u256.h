@@ -0,0 +1,63 @@
+#ifndef _BCH_U256_H
+#define _BCH_U256_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+/*
+ * Fixed-width 256-bit unsigned integers.
+ *
+ * Four 64 bit limbs, least significant first. Everything is
+ * done in place on the stack; no allocations. Used for the
+ * chainwork math where the generic `bch_bn_t` is overkill.
+ */
+
+typedef struct bch_u256_s {
+  uint64_t limbs[4];
+} bch_u256_t;
+
+void
+bch_u256_set_u64(bch_u256_t *r, uint64_t v);
+
+void
+bch_u256_import(bch_u256_t *r, const uint8_t *data);
+
+void
+bch_u256_export(const bch_u256_t *a, uint8_t *data);
+
+bool
+bch_u256_is_zero(const bch_u256_t *a);
+
+int
+bch_u256_cmp(const bch_u256_t *a, const bch_u256_t *b);
+
+int
+bch_u256_bits(const bch_u256_t *a);
+
+void
+bch_u256_not(bch_u256_t *r, const bch_u256_t *a);
+
+bool
+bch_u256_add(bch_u256_t *r, const bch_u256_t *a, const bch_u256_t *b);
+
+bool
+bch_u256_sub(bch_u256_t *r, const bch_u256_t *a, const bch_u256_t *b);
+
+bool
+bch_u256_add_u64(bch_u256_t *r, const bch_u256_t *a, uint64_t b);
+
+bool
+bch_u256_mul(bch_u256_t *r, const bch_u256_t *a, const bch_u256_t *b);
+
+bool
+bch_u256_divmod(
+  bch_u256_t *q,
+  bch_u256_t *r,
+  const bch_u256_t *a,
+  const bch_u256_t *b
+);
+
+bool
+bch_u256_work(bch_u256_t *r, const bch_u256_t *target);
+#endif
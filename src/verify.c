@@ -0,0 +1,610 @@
+#include <assert.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sigcache.h"
+#include "uv.h"
+#include "verify.h"
+#include "secp256k1/secp256k1.h"
+#include "secp256k1/schnorr.h"
+
+/*
+ * Jobs
+ */
+
+bool
+bch_verify_job_init(
+  bch_verify_job_t *job,
+  uint8_t type,
+  const uint8_t *msg,
+  const uint8_t *pub,
+  size_t pub_len,
+  const uint8_t *sig,
+  size_t sig_len,
+  bch_verify_cb cb,
+  void *arg
+) {
+  assert(job && "job is null");
+  assert(msg && "msg is null");
+  assert(pub && "pub is null");
+  assert(sig && "sig is null");
+
+  if (type != BCH_VERIFY_ECDSA && type != BCH_VERIFY_SCHNORR)
+    return false;
+
+  if (pub_len > BCH_VERIFY_MAX_PUB || sig_len > BCH_VERIFY_MAX_SIG)
+    return false;
+
+  job->type = type;
+  memcpy(job->msg, msg, 32);
+  memcpy(job->pub, pub, pub_len);
+  job->pub_len = pub_len;
+  memcpy(job->sig, sig, sig_len);
+  job->sig_len = sig_len;
+  job->result = BCH_VERIFY_INVALID;
+  job->cb = cb;
+  job->arg = arg;
+  job->next = NULL;
+
+  return true;
+}
+
+/*
+ * Queue
+ *
+ * Bounded MPMC ring (Vyukov). Each cell carries a
+ * sequence number telling producers and consumers
+ * whether it is free for the lap they are on, so the
+ * only contended operation is a CAS on head or tail.
+ */
+
+static bool
+bch_verify_push(bch_verify_t *pool, bch_verify_job_t *job) {
+  size_t pos = atomic_load_explicit(&pool->head, memory_order_relaxed);
+  bch_verify_cell_t *cell;
+
+  for (;;) {
+    cell = &pool->cells[pos & pool->mask];
+
+    size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+    intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+
+    if (dif == 0) {
+      if (atomic_compare_exchange_weak_explicit(&pool->head, &pos, pos + 1,
+                                                memory_order_relaxed,
+                                                memory_order_relaxed)) {
+        break;
+      }
+    } else if (dif < 0) {
+      return false;
+    } else {
+      pos = atomic_load_explicit(&pool->head, memory_order_relaxed);
+    }
+  }
+
+  cell->job = job;
+
+  atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+
+  return true;
+}
+
+static bch_verify_job_t *
+bch_verify_pop(bch_verify_t *pool) {
+  size_t pos = atomic_load_explicit(&pool->tail, memory_order_relaxed);
+  bch_verify_cell_t *cell;
+  bch_verify_job_t *job;
+
+  for (;;) {
+    cell = &pool->cells[pos & pool->mask];
+
+    size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+    intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+
+    if (dif == 0) {
+      if (atomic_compare_exchange_weak_explicit(&pool->tail, &pos, pos + 1,
+                                                memory_order_relaxed,
+                                                memory_order_relaxed)) {
+        break;
+      }
+    } else if (dif < 0) {
+      return NULL;
+    } else {
+      pos = atomic_load_explicit(&pool->tail, memory_order_relaxed);
+    }
+  }
+
+  job = cell->job;
+
+  atomic_store_explicit(&cell->seq, pos + pool->mask + 1,
+                        memory_order_release);
+
+  return job;
+}
+
+/*
+ * Completion
+ *
+ * Workers push onto a lock-free stack. The loop takes
+ * the whole stack with one exchange, so there is no ABA.
+ */
+
+static void
+bch_verify_finish(bch_verify_t *pool, bch_verify_job_t *job) {
+  bch_verify_job_t *head = atomic_load_explicit(&pool->done,
+                                                memory_order_relaxed);
+
+  do {
+    job->next = head;
+  } while (!atomic_compare_exchange_weak_explicit(&pool->done, &head, job,
+                                                  memory_order_release,
+                                                  memory_order_relaxed));
+}
+
+static void
+bch_verify_flush(bch_verify_t *pool) {
+  bch_verify_job_t *job = atomic_exchange_explicit(&pool->done, NULL,
+                                                   memory_order_acquire);
+  bch_verify_job_t *fifo = NULL;
+
+  // Restore submission order (roughly; workers race).
+  while (job) {
+    bch_verify_job_t *next = job->next;
+    job->next = fifo;
+    fifo = job;
+    job = next;
+  }
+
+  while (fifo) {
+    bch_verify_job_t *next = fifo->next;
+
+    fifo->next = NULL;
+
+    if (fifo->cb)
+      fifo->cb(fifo, fifo->arg);
+
+    fifo = next;
+  }
+}
+
+static void
+after_verify(uv_async_t *async) {
+  bch_verify_flush((bch_verify_t *)async->data);
+}
+
+/*
+ * Verification
+ */
+
+// The batch calls report only the first failure. Rather
+// than restart a batch after every bad signature, which
+// is quadratic on hostile input, the jobs past the first
+// failure are checked one at a time.
+static void
+bch_verify_ecdsa(
+  const hsk_secp256k1_context *ctx,
+  bch_verify_job_t **jobs,
+  const hsk_secp256k1_ecdsa_signature **sigs,
+  const unsigned char **msgs,
+  const hsk_secp256k1_pubkey **pubs,
+  size_t len
+) {
+  size_t i, failed = 0;
+
+  if (hsk_secp256k1_ecdsa_verify_batch(ctx, sigs, msgs, pubs, len, &failed))
+    failed = len;
+
+  for (i = 0; i < failed; i++)
+    jobs[i]->result = BCH_VERIFY_VALID;
+
+  for (i = failed + 1; i < len; i++) {
+    if (hsk_secp256k1_ecdsa_verify(ctx, sigs[i], msgs[i], pubs[i]))
+      jobs[i]->result = BCH_VERIFY_VALID;
+  }
+}
+
+static void
+bch_verify_schnorr(
+  const hsk_secp256k1_context *ctx,
+  hsk_secp256k1_scratch_space *scratch,
+  bch_verify_job_t **jobs,
+  const unsigned char **sigs,
+  const unsigned char **msgs,
+  const hsk_secp256k1_pubkey **pubs,
+  size_t len
+) {
+  size_t i, failed = 0;
+
+  if (hsk_secp256k1_schnorr_verify_batch(ctx, scratch, sigs, msgs,
+                                         pubs, len, &failed)) {
+    failed = len;
+  }
+
+  for (i = 0; i < failed; i++)
+    jobs[i]->result = BCH_VERIFY_VALID;
+
+  for (i = failed + 1; i < len; i++) {
+    if (hsk_secp256k1_schnorr_verify(ctx, sigs[i], msgs[i], pubs[i]))
+      jobs[i]->result = BCH_VERIFY_VALID;
+  }
+}
+
+// Verify up to BCH_VERIFY_BATCH jobs, setting each
+// job's result. Usable without a pool. The cache
+// may be NULL.
+void
+bch_verify_run(
+  const hsk_secp256k1_context *ctx,
+  hsk_secp256k1_scratch_space *scratch,
+  bch_sigcache_t *cache,
+  bch_verify_job_t **jobs,
+  size_t len
+) {
+  assert(ctx && "ctx is null");
+  assert(scratch && "scratch is null");
+  assert((jobs || len == 0) && "jobs is null");
+  assert(len <= BCH_VERIFY_BATCH && "batch too large");
+
+  uint8_t hashes[BCH_VERIFY_BATCH][32];
+  bool cached[BCH_VERIFY_BATCH];
+  const unsigned char *inputs[BCH_VERIFY_BATCH];
+  size_t input_lens[BCH_VERIFY_BATCH];
+  hsk_secp256k1_pubkey keys[BCH_VERIFY_BATCH];
+  int parsed[BCH_VERIFY_BATCH];
+  hsk_secp256k1_ecdsa_signature ders[BCH_VERIFY_BATCH];
+
+  bch_verify_job_t *ecdsa_jobs[BCH_VERIFY_BATCH];
+  const hsk_secp256k1_ecdsa_signature *ecdsa_sigs[BCH_VERIFY_BATCH];
+  const unsigned char *ecdsa_msgs[BCH_VERIFY_BATCH];
+  const hsk_secp256k1_pubkey *ecdsa_pubs[BCH_VERIFY_BATCH];
+  size_t ecdsa_len = 0;
+
+  bch_verify_job_t *schnorr_jobs[BCH_VERIFY_BATCH];
+  const unsigned char *schnorr_sigs[BCH_VERIFY_BATCH];
+  const unsigned char *schnorr_msgs[BCH_VERIFY_BATCH];
+  const hsk_secp256k1_pubkey *schnorr_pubs[BCH_VERIFY_BATCH];
+  size_t schnorr_len = 0;
+
+  size_t i;
+
+  if (len == 0)
+    return;
+
+  for (i = 0; i < len; i++) {
+    bch_verify_job_t *job = jobs[i];
+
+    job->result = BCH_VERIFY_INVALID;
+    cached[i] = false;
+
+    inputs[i] = job->pub;
+    input_lens[i] = job->pub_len;
+
+    if (cache) {
+      bch_sigcache_key(cache, hashes[i], job->type, job->msg,
+                       job->pub, job->pub_len, job->sig, job->sig_len);
+
+      if (bch_sigcache_has(cache, hashes[i])) {
+        job->result = BCH_VERIFY_VALID;
+        cached[i] = true;
+        inputs[i] = NULL;
+      }
+    }
+  }
+
+  // Decompress the keys together. Cached jobs
+  // have no input and are skipped.
+  hsk_secp256k1_ec_pubkey_parse_batch(ctx, keys, parsed,
+                                      inputs, input_lens, len);
+
+  for (i = 0; i < len; i++) {
+    bch_verify_job_t *job = jobs[i];
+
+    if (cached[i] || !parsed[i])
+      continue;
+
+    if (job->type == BCH_VERIFY_SCHNORR) {
+      if (job->sig_len != 64)
+        continue;
+
+      schnorr_jobs[schnorr_len] = job;
+      schnorr_sigs[schnorr_len] = job->sig;
+      schnorr_msgs[schnorr_len] = job->msg;
+      schnorr_pubs[schnorr_len] = &keys[i];
+      schnorr_len += 1;
+    } else {
+      if (!hsk_secp256k1_ecdsa_signature_parse_der(ctx, &ders[i],
+                                                   job->sig, job->sig_len)) {
+        continue;
+      }
+
+      ecdsa_jobs[ecdsa_len] = job;
+      ecdsa_sigs[ecdsa_len] = &ders[i];
+      ecdsa_msgs[ecdsa_len] = job->msg;
+      ecdsa_pubs[ecdsa_len] = &keys[i];
+      ecdsa_len += 1;
+    }
+  }
+
+  bch_verify_ecdsa(ctx, ecdsa_jobs, ecdsa_sigs,
+                   ecdsa_msgs, ecdsa_pubs, ecdsa_len);
+
+  bch_verify_schnorr(ctx, scratch, schnorr_jobs, schnorr_sigs,
+                     schnorr_msgs, schnorr_pubs, schnorr_len);
+
+  if (!cache)
+    return;
+
+  // Only successes are cached.
+  for (i = 0; i < len; i++) {
+    if (!cached[i] && jobs[i]->result == BCH_VERIFY_VALID)
+      bch_sigcache_add(cache, hashes[i]);
+  }
+}
+
+/*
+ * Workers
+ */
+
+static void
+bch_verify_worker(void *arg) {
+  bch_verify_worker_t *worker = (bch_verify_worker_t *)arg;
+  bch_verify_t *pool = worker->pool;
+  bch_verify_job_t *jobs[BCH_VERIFY_BATCH];
+
+  for (;;) {
+    size_t queued, want, len, i;
+
+    uv_sem_wait(&pool->sem);
+
+    if (atomic_load(&pool->stop))
+      break;
+
+    // Take a fair share of what is queued so a burst is
+    // spread across the pool instead of one worker.
+    queued = atomic_load_explicit(&pool->head, memory_order_relaxed)
+           - atomic_load_explicit(&pool->tail, memory_order_relaxed);
+
+    want = queued / (size_t)pool->threads;
+
+    if (want == 0)
+      want = 1;
+
+    if (want > BCH_VERIFY_BATCH)
+      want = BCH_VERIFY_BATCH;
+
+    len = 0;
+
+    while (len < want) {
+      bch_verify_job_t *job = bch_verify_pop(pool);
+
+      if (!job)
+        break;
+
+      jobs[len++] = job;
+    }
+
+    // Surplus posts from jobs taken in an earlier batch.
+    if (len == 0)
+      continue;
+
+    bch_verify_run(pool->ctx, worker->scratch, pool->cache, jobs, len);
+
+    for (i = 0; i < len; i++)
+      bch_verify_finish(pool, jobs[i]);
+
+    uv_async_send(&pool->async);
+  }
+}
+
+/*
+ * Pool
+ */
+
+bool
+bch_verify_open(
+  bch_verify_t *pool,
+  uv_loop_t *loop,
+  const hsk_secp256k1_context *ctx,
+  bch_sigcache_t *cache,
+  int threads,
+  size_t size
+) {
+  assert(pool && "pool is null");
+  assert(loop && "loop is null");
+  assert(ctx && "ctx is null");
+
+  size_t cap = 2;
+  size_t i;
+  int started = 0;
+
+  if (threads < 1 || threads > BCH_VERIFY_MAX_THREADS)
+    return false;
+
+  if (size == 0)
+    size = BCH_VERIFY_QUEUE_SIZE;
+
+  while (cap < size)
+    cap <<= 1;
+
+  memset(pool, 0, sizeof(bch_verify_t));
+
+  pool->ctx = ctx;
+  pool->cache = cache;
+  pool->threads = threads;
+  pool->mask = cap - 1;
+
+  atomic_init(&pool->stop, false);
+  atomic_init(&pool->head, 0);
+  atomic_init(&pool->tail, 0);
+  atomic_init(&pool->done, NULL);
+
+  pool->cells = malloc(cap * sizeof(bch_verify_cell_t));
+
+  if (!pool->cells)
+    return false;
+
+  for (i = 0; i < cap; i++) {
+    atomic_init(&pool->cells[i].seq, i);
+    pool->cells[i].job = NULL;
+  }
+
+  pool->workers = calloc(threads, sizeof(bch_verify_worker_t));
+
+  if (!pool->workers)
+    goto fail_cells;
+
+  if (uv_sem_init(&pool->sem, 0) != 0)
+    goto fail_workers;
+
+  if (uv_async_init(loop, &pool->async, after_verify) != 0)
+    goto fail_sem;
+
+  pool->async.data = (void *)pool;
+
+  for (started = 0; started < threads; started++) {
+    bch_verify_worker_t *worker = &pool->workers[started];
+
+    worker->pool = pool;
+    worker->scratch = hsk_secp256k1_scratch_space_create(
+      ctx, BCH_VERIFY_SCRATCH_SIZE, BCH_VERIFY_SCRATCH_SIZE);
+
+    if (!worker->scratch)
+      goto fail_threads;
+
+    if (uv_thread_create(&worker->thread, bch_verify_worker, worker) != 0) {
+      hsk_secp256k1_scratch_space_destroy(worker->scratch);
+      goto fail_threads;
+    }
+  }
+
+  return true;
+
+fail_threads:
+  atomic_store(&pool->stop, true);
+
+  for (i = 0; i < (size_t)started; i++)
+    uv_sem_post(&pool->sem);
+
+  for (i = 0; i < (size_t)started; i++) {
+    uv_thread_join(&pool->workers[i].thread);
+    hsk_secp256k1_scratch_space_destroy(pool->workers[i].scratch);
+  }
+
+  uv_close((uv_handle_t *)&pool->async, NULL);
+fail_sem:
+  uv_sem_destroy(&pool->sem);
+fail_workers:
+  free(pool->workers);
+  pool->workers = NULL;
+fail_cells:
+  free(pool->cells);
+  pool->cells = NULL;
+  return false;
+}
+
+// Stop the workers and complete every outstanding
+// job: finished ones with their result, queued ones
+// as BCH_VERIFY_CANCELED. The async handle is closed,
+// so the pool must stay alive until the loop has run
+// its close callbacks.
+void
+bch_verify_close(bch_verify_t *pool) {
+  assert(pool && "pool is null");
+
+  bch_verify_job_t *job;
+  int i;
+
+  atomic_store(&pool->stop, true);
+
+  for (i = 0; i < pool->threads; i++)
+    uv_sem_post(&pool->sem);
+
+  for (i = 0; i < pool->threads; i++) {
+    uv_thread_join(&pool->workers[i].thread);
+    hsk_secp256k1_scratch_space_destroy(pool->workers[i].scratch);
+  }
+
+  bch_verify_flush(pool);
+
+  while ((job = bch_verify_pop(pool))) {
+    job->result = BCH_VERIFY_CANCELED;
+
+    if (job->cb)
+      job->cb(job, job->arg);
+  }
+
+  uv_close((uv_handle_t *)&pool->async, NULL);
+  uv_sem_destroy(&pool->sem);
+
+  free(pool->workers);
+  pool->workers = NULL;
+
+  free(pool->cells);
+  pool->cells = NULL;
+}
+
+// Returns false if the queue is full; the caller
+// may retry later or verify inline.
+bool
+bch_verify_submit(bch_verify_t *pool, bch_verify_job_t *job) {
+  assert(pool && "pool is null");
+  assert(job && "job is null");
+
+  job->result = BCH_VERIFY_INVALID;
+  job->next = NULL;
+
+  if (!bch_verify_push(pool, job))
+    return false;
+
+  uv_sem_post(&pool->sem);
+
+  return true;
+}
+
+// Apply the line printed by bench/ecmult:
+// "<threshold> <window 1 max> ... <window 11 max>".
+bool
+bch_verify_tune(hsk_secp256k1_context *ctx, const char *spec) {
+  size_t window_max[HSK_SECP256K1_ECMULT_MULTI_WINDOWS];
+  unsigned long long value;
+  size_t threshold = 0;
+  const char *s = spec;
+  char *end;
+  int i;
+
+  assert(ctx && "ctx is null");
+  assert(spec && "spec is null");
+
+  for (i = -1; i < HSK_SECP256K1_ECMULT_MULTI_WINDOWS; i++) {
+    while (*s == ' ' || *s == '\t')
+      s++;
+
+    if (*s < '0' || *s > '9')
+      return false;
+
+    errno = 0;
+    value = strtoull(s, &end, 10);
+
+    if (errno != 0 || value > SIZE_MAX)
+      return false;
+
+    if (i < 0)
+      threshold = (size_t)value;
+    else
+      window_max[i] = (size_t)value;
+
+    s = end;
+  }
+
+  while (*s == ' ' || *s == '\t' || *s == '\r' || *s == '\n')
+    s++;
+
+  if (*s != '\0')
+    return false;
+
+  return hsk_secp256k1_context_set_ecmult_multi(ctx, threshold, window_max) == 1;
+}
@@ -0,0 +1,139 @@
+#ifndef _BCH_VERIFY_H
+#define _BCH_VERIFY_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "uv.h"
+#include "sigcache.h"
+#include "secp256k1/secp256k1.h"
+
+/*
+ * Signature verification pool.
+ *
+ * Jobs are submitted from the loop thread into a bounded
+ * lock-free MPMC ring and picked up by a fixed set of
+ * worker threads sharing one read-only secp256k1 context.
+ * Each worker drains a small batch at a time, verifies it
+ * with the batch APIs (Schnorr signatures use the worker's
+ * own scratch space) and pushes the finished jobs onto a
+ * lock-free completion stack. A uv_async_t then runs the
+ * callbacks on the loop thread.
+ *
+ * With a signature cache, jobs whose signature already
+ * verified are answered from it and the rest are added to
+ * it once they verify.
+ *
+ * Signatures are passed without their sighash byte:
+ * strict DER with a low S for ECDSA (at most 72 bytes)
+ * or 64 bytes for Schnorr. High-S ECDSA signatures are
+ * rejected, as BCH consensus requires.
+ *
+ * Jobs are owned by the caller and must stay alive until
+ * their callback has run.
+ */
+
+#define BCH_VERIFY_ECDSA 0
+#define BCH_VERIFY_SCHNORR 1
+
+#define BCH_VERIFY_CANCELED -1
+#define BCH_VERIFY_INVALID 0
+#define BCH_VERIFY_VALID 1
+
+#define BCH_VERIFY_MAX_PUB 65
+#define BCH_VERIFY_MAX_SIG 72
+#define BCH_VERIFY_MAX_THREADS 64
+#define BCH_VERIFY_QUEUE_SIZE 4096
+#define BCH_VERIFY_BATCH 64
+#define BCH_VERIFY_SCRATCH_SIZE (1 << 20)
+
+typedef struct bch_verify_job_s bch_verify_job_t;
+
+typedef void (*bch_verify_cb)(bch_verify_job_t *job, void *arg);
+
+struct bch_verify_job_s {
+  uint8_t type;
+  uint8_t msg[32];
+  uint8_t pub[BCH_VERIFY_MAX_PUB];
+  size_t pub_len;
+  uint8_t sig[BCH_VERIFY_MAX_SIG];
+  size_t sig_len;
+  int result;
+  bch_verify_cb cb;
+  void *arg;
+  struct bch_verify_job_s *next;
+};
+
+typedef struct bch_verify_cell_s {
+  atomic_size_t seq;
+  bch_verify_job_t *job;
+} bch_verify_cell_t;
+
+typedef struct bch_verify_worker_s {
+  struct bch_verify_s *pool;
+  uv_thread_t thread;
+  hsk_secp256k1_scratch_space *scratch;
+} bch_verify_worker_t;
+
+typedef struct bch_verify_s {
+  const hsk_secp256k1_context *ctx;
+  bch_sigcache_t *cache;
+  uv_async_t async;
+  uv_sem_t sem;
+  bch_verify_worker_t *workers;
+  int threads;
+  bch_verify_cell_t *cells;
+  size_t mask;
+  atomic_bool stop;
+  // Producer and consumer indices on their own lines.
+  uint8_t pad0[64];
+  atomic_size_t head;
+  uint8_t pad1[64];
+  atomic_size_t tail;
+  uint8_t pad2[64];
+  _Atomic(bch_verify_job_t *) done;
+} bch_verify_t;
+
+bool
+bch_verify_job_init(
+  bch_verify_job_t *job,
+  uint8_t type,
+  const uint8_t *msg,
+  const uint8_t *pub,
+  size_t pub_len,
+  const uint8_t *sig,
+  size_t sig_len,
+  bch_verify_cb cb,
+  void *arg
+);
+
+bool
+bch_verify_open(
+  bch_verify_t *pool,
+  uv_loop_t *loop,
+  const hsk_secp256k1_context *ctx,
+  bch_sigcache_t *cache,
+  int threads,
+  size_t size
+);
+
+void
+bch_verify_close(bch_verify_t *pool);
+
+bool
+bch_verify_submit(bch_verify_t *pool, bch_verify_job_t *job);
+
+void
+bch_verify_run(
+  const hsk_secp256k1_context *ctx,
+  hsk_secp256k1_scratch_space *scratch,
+  bch_sigcache_t *cache,
+  bch_verify_job_t **jobs,
+  size_t len
+);
+
+bool
+bch_verify_tune(hsk_secp256k1_context *ctx, const char *spec);
+#endif